@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Compares loading a collection one Post() at a time with PostMany(), and
+// patching it one transaction at a time with PatchMany(), with a queued
+// subscriber attached so the cost of notification fan-out is included.
+//
+
+#include "autogen/benchmark/BenchItem.h"
+#include "jude/database/Collection.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+   template<typename Fn>
+   double MeasureNsPerOp(size_t operations, Fn fn)
+   {
+      auto start = steady_clock::now();
+      fn();
+      auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+      return (double)elapsed / (double)operations;
+   }
+
+   std::vector<jude::BenchItem> MakeItems(jude_id_t count)
+   {
+      std::vector<jude::BenchItem> items;
+      items.reserve(count);
+      for (jude_id_t id = 1; id <= count; id++)
+      {
+         auto item = jude::BenchItem::New();
+         item.AssignId(id);
+         item.Set_name("item " + std::to_string(id)).Set_value((int32_t)id).Set_enabled(true);
+         items.push_back(std::move(item));
+      }
+      return items;
+   }
+
+   std::vector<jude::BenchItem> MakePatches(jude_id_t count)
+   {
+      std::vector<jude::BenchItem> patches;
+      patches.reserve(count);
+      for (jude_id_t id = 1; id <= count; id++)
+      {
+         auto patch = jude::BenchItem::New();
+         patch.AssignId(id);
+         patch.Set_value(-(int32_t)id);
+         patches.push_back(std::move(patch));
+      }
+      return patches;
+   }
+
+   struct Results
+   {
+      double postNs;
+      double patchNs;
+      size_t notifications;
+   };
+
+   Results Measure(bool bulk, jude_id_t count)
+   {
+      jude::NotifyQueue queue("bench", (size_t)count + 1);
+      jude::Collection<jude::BenchItem> collection("items", count);
+      size_t notifications = 0;
+      auto subscription = collection.OnChange([&](const jude::Notification<jude::BenchItem>&) { notifications++; }, jude::FieldMask::ForAllChanges(), queue);
+
+      auto items = MakeItems(count);
+      auto patches = MakePatches(count);
+      Results results;
+
+      results.postNs = MeasureNsPerOp(count, [&] {
+         if (bulk)
+         {
+            collection.PostMany(std::move(items));
+         }
+         else
+         {
+            for (auto& item : items)
+            {
+               collection.Post(item.Id())->Set_name(item.Get_name()).Set_value(item.Get_value()).Set_enabled(item.Get_enabled());
+            }
+         }
+         while (queue.Process(0)) {}
+      });
+
+      results.patchNs = MeasureNsPerOp(count, [&] {
+         if (bulk)
+         {
+            collection.PatchMany(patches);
+         }
+         else
+         {
+            for (auto& patch : patches)
+            {
+               collection.TransactionLock(patch.Id())->Set_value(patch.Get_value());
+            }
+         }
+         while (queue.Process(0)) {}
+      });
+
+      results.notifications = notifications;
+      return results;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   jude_id_t count = argc > 1 ? (jude_id_t)atoi(argv[1]) : 50000;
+
+   auto single = Measure(false, count);
+   auto bulk = Measure(true, count);
+
+   printf("%-10s %14s %14s %16s\n", "", "ns/post", "ns/patch", "notifications");
+   printf("%-10s %14.1f %14.1f %16zu\n", "single", single.postNs, single.patchNs, single.notifications);
+   printf("%-10s %14.1f %14.1f %16zu\n", "bulk", bulk.postNs, bulk.patchNs, bulk.notifications);
+
+   return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+//
+// Measures notification throughput with several producer threads sending to one
+// consumer, comparing the port's queue against the lock-free NotificationRing.
+//
+
+#include "jude/core/cpp/NotifyQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+   std::atomic<uint64_t> s_mallocs{0};
+}
+
+void* operator new(size_t size)
+{
+   s_mallocs++;
+   if (auto block = malloc(size ? size : 1))
+   {
+      return block;
+   }
+   throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+
+namespace
+{
+   struct Result
+   {
+      double eventsPerSecond;
+      double mallocsPerEvent;
+      uint64_t lost;
+   };
+
+   Result Measure(jude::NotifyQueue::Type type, unsigned producerCount, uint64_t eventsPerProducer)
+   {
+      // Deep enough that neither queue should drop anything
+      jude::NotifyQueue queue("bench", (size_t)(producerCount * eventsPerProducer), type);
+      std::atomic<uint64_t> received{0};
+      std::atomic<unsigned> producersRunning{producerCount};
+
+      auto mallocs = s_mallocs.load();
+      auto start = steady_clock::now();
+
+      std::thread consumer([&] {
+         while (producersRunning > 0 || queue.Process(0))
+         {
+            queue.Process(1);
+         }
+      });
+
+      std::vector<std::thread> producers;
+      for (unsigned p = 0; p < producerCount; p++)
+      {
+         producers.emplace_back([&] {
+            for (uint64_t event = 0; event < eventsPerProducer; event++)
+            {
+               queue.Send([&received] { received.fetch_add(1, std::memory_order_relaxed); });
+            }
+            producersRunning--;
+         });
+      }
+
+      for (auto& producer : producers)
+      {
+         producer.join();
+      }
+      consumer.join();
+
+      auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+      double events = (double)producerCount * eventsPerProducer;
+      return { received / elapsed, (double)(s_mallocs - mallocs) / events, (uint64_t)events - received };
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned maxProducers = argc > 1 ? (unsigned)atoi(argv[1]) : 4;
+   uint64_t eventsPerProducer = argc > 2 ? (uint64_t)atoll(argv[2]) : 200000;
+
+   printf("%-10s %10s %16s %16s %8s\n", "queue", "producers", "events/s", "mallocs/event", "lost");
+   for (unsigned producers = 1; producers <= maxProducers; producers *= 2)
+   {
+      auto ported = Measure(jude::NotifyQueue::Type::Ported, producers, eventsPerProducer);
+      auto lockFree = Measure(jude::NotifyQueue::Type::LockFree, producers, eventsPerProducer);
+
+      printf("%-10s %10u %16.0f %16.2f %8llu\n", "ported", producers, ported.eventsPerSecond, ported.mallocsPerEvent, (unsigned long long)ported.lost);
+      printf("%-10s %10u %16.0f %16.2f %8llu\n", "lock-free", producers, lockFree.eventsPerSecond, lockFree.mallocsPerEvent, (unsigned long long)lockFree.lost);
+   }
+
+   return 0;
+}
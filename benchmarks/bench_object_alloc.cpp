@@ -0,0 +1,114 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Counts heap allocations and time per POST / delete cycle with and without
+// per-type object pools.
+//
+
+#include "autogen/benchmark/BenchItem.h"
+#include "jude/core/cpp/ObjectPool.h"
+#include "jude/database/Collection.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace std::chrono;
+
+namespace
+{
+   std::atomic<uint64_t> s_mallocs{0};
+}
+
+void* operator new(size_t size)
+{
+   s_mallocs++;
+   if (auto block = malloc(size ? size : 1))
+   {
+      return block;
+   }
+   throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+
+namespace
+{
+   struct Result
+   {
+      double mallocsPerPost;
+      double nsPerPost;
+   };
+
+   Result Measure(bool usePools, jude_id_t count, unsigned rounds)
+   {
+      jude::Options::UseObjectPools = usePools;
+      jude::Collection<jude::BenchItem> collection("items", count);
+
+      auto cycle = [&] {
+         for (jude_id_t id = 1; id <= count; id++)
+         {
+            collection.Post(id)->Set_name("item").Set_value((int32_t)id);
+         }
+         for (jude_id_t id = 1; id <= count; id++)
+         {
+            collection.Delete(id);
+         }
+      };
+
+      cycle(); // warm up pools and collection storage
+
+      auto mallocs = s_mallocs.load();
+      auto start = steady_clock::now();
+      for (unsigned round = 0; round < rounds; round++)
+      {
+         cycle();
+      }
+      auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+      double posts = (double)count * rounds;
+      return { (double)(s_mallocs - mallocs) / posts, (double)elapsed / posts };
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   jude_id_t count = argc > 1 ? (jude_id_t)atoi(argv[1]) : 10000;
+   unsigned rounds = argc > 2 ? (unsigned)atoi(argv[2]) : 10;
+
+   auto heap = Measure(false, count, rounds);
+   auto pooled = Measure(true, count, rounds);
+
+   printf("%-10s %18s %14s\n", "", "mallocs/post", "ns/post");
+   printf("%-10s %18.2f %14.1f\n", "heap", heap.mallocsPerPost, heap.nsPerPost);
+   printf("%-10s %18.2f %14.1f\n", "pooled", pooled.mallocsPerPost, pooled.nsPerPost);
+
+   auto stats = jude::ObjectPool::GetStatistics();
+   printf("pools: %zu, pool allocations: %zu, blocks in use: %zu\n", stats.pools, stats.poolAllocations, stats.blocksInUse);
+
+   return 0;
+}
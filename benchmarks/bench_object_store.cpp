@@ -0,0 +1,168 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Compares the collection storage policies for insert, lookup and ordered iteration,
+// both on the raw ObjectStore and through the Collection API.
+//
+
+#include "autogen/benchmark/BenchItem.h"
+#include "jude/database/Collection.h"
+#include "jude/database/ObjectStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+   template<typename Fn>
+   double MeasureNsPerOp(size_t operations, Fn fn)
+   {
+      auto start = steady_clock::now();
+      fn();
+      auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+      return (double)elapsed / (double)operations;
+   }
+
+   void Report(const char* operation, double ordered, double hashed)
+   {
+      printf("%-28s %12.1f %12.1f %8.2f\n", operation, ordered, hashed, ordered / hashed);
+   }
+
+   struct Results
+   {
+      double storeInsert;
+      double storeFind;
+      double storeIterate;
+      double post;
+      double containsId;
+      double restGet;
+      double getIds;
+   };
+
+   Results Run(jude::StoragePolicy policy, const std::vector<jude_id_t>& ids, const std::vector<jude_id_t>& lookups)
+   {
+      Results results;
+
+      auto store = jude::ObjectStore::Create(policy);
+      results.storeInsert = MeasureNsPerOp(ids.size(), [&] {
+         for (auto id : ids)
+         {
+            store->Insert(id) = jude::BenchItem::New();
+         }
+      });
+
+      size_t found = 0;
+      results.storeFind = MeasureNsPerOp(lookups.size(), [&] {
+         for (auto id : lookups)
+         {
+            found += store->Find(id) ? 1 : 0;
+         }
+      });
+
+      size_t visited = 0;
+      results.storeIterate = MeasureNsPerOp(ids.size(), [&] {
+         store->ForEach([&] (const jude::Object&) { visited++; return true; });
+      });
+
+      jude::Collection<jude::BenchItem> collection("items", ids.size());
+      collection.SetStoragePolicy(policy);
+
+      results.post = MeasureNsPerOp(ids.size(), [&] {
+         for (auto id : ids)
+         {
+            collection.Post(id)->Set_value((int32_t)id);
+         }
+      });
+
+      results.containsId = MeasureNsPerOp(lookups.size(), [&] {
+         for (auto id : lookups)
+         {
+            found += collection.ContainsId(id) ? 1 : 0;
+         }
+      });
+
+      std::stringstream output;
+      char path[32];
+      results.restGet = MeasureNsPerOp(lookups.size(), [&] {
+         for (auto id : lookups)
+         {
+            snprintf(path, sizeof(path), "/%" PRIjudeID "/value", id);
+            output.str("");
+            collection.RestGet(path, output);
+         }
+      });
+
+      results.getIds = MeasureNsPerOp(ids.size(), [&] {
+         visited += collection.GetIds().size();
+      });
+
+      if (found == 0 || visited == 0)
+      {
+         printf("unexpected empty results\n");
+      }
+
+      return results;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   size_t count = argc > 1 ? (size_t)atoi(argv[1]) : 100000;
+
+   std::mt19937 random(42);
+   std::vector<jude_id_t> ids(count);
+   for (size_t i = 0; i < count; i++)
+   {
+      ids[i] = (jude_id_t)(i + 1);
+   }
+   std::shuffle(ids.begin(), ids.end(), random);
+
+   std::vector<jude_id_t> lookups(count);
+   for (auto& id : lookups)
+   {
+      id = ids[random() % count];
+   }
+
+   auto ordered = Run(jude::StoragePolicy::Ordered, ids, lookups);
+   auto hashed = Run(jude::StoragePolicy::Hashed, ids, lookups);
+
+   printf("%zu objects, random id order (ns per operation)\n", count);
+   printf("%-28s %12s %12s %8s\n", "operation", "ordered", "hashed", "speedup");
+   Report("ObjectStore::Insert", ordered.storeInsert, hashed.storeInsert);
+   Report("ObjectStore::Find", ordered.storeFind, hashed.storeFind);
+   Report("ObjectStore::ForEach", ordered.storeIterate, hashed.storeIterate);
+   Report("Collection::Post", ordered.post, hashed.post);
+   Report("Collection::ContainsId", ordered.containsId, hashed.containsId);
+   Report("Collection::RestGet(id)", ordered.restGet, hashed.restGet);
+   Report("Collection::GetIds", ordered.getIds, hashed.getIds);
+
+   return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Measures REST GET throughput on a collection as the number of reader threads
+// grows, comparing the default exclusive mutex against the reader/writer mode.
+//
+
+#include "autogen/benchmark/BenchItem.h"
+#include "jude/database/Collection.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+   constexpr jude_id_t ItemCount = 1000;
+
+   double MeasureReadsPerSecond(jude::Collection<jude::BenchItem>& collection, unsigned threadCount, milliseconds period)
+   {
+      std::atomic<bool> running{true};
+      std::atomic<uint64_t> totalReads{0};
+      std::vector<std::thread> readers;
+
+      for (unsigned t = 0; t < threadCount; t++)
+      {
+         readers.emplace_back([&, t] {
+            uint64_t reads = 0;
+            jude_id_t id = 1 + t;
+            std::stringstream output;
+            while (running)
+            {
+               char path[16];
+               snprintf(path, sizeof(path), "/%u/name", (unsigned)id);
+               output.str("");
+               collection.RestGet(path, output);
+               id = (id % ItemCount) + 1;
+               reads++;
+            }
+            totalReads += reads;
+         });
+      }
+
+      std::this_thread::sleep_for(period);
+      running = false;
+      for (auto& reader : readers)
+      {
+         reader.join();
+      }
+
+      return (double)totalReads / duration_cast<duration<double>>(period).count();
+   }
+
+   void Populate(jude::Collection<jude::BenchItem>& collection)
+   {
+      for (jude_id_t id = 1; id <= ItemCount; id++)
+      {
+         collection.Post(id)->Set_name("item").Set_value((int32_t)id);
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned maxThreads = argc > 1 ? (unsigned)atoi(argv[1]) : 8;
+   milliseconds duration(argc > 2 ? atoi(argv[2]) : 1000);
+
+   auto exclusive = std::make_shared<jude::Mutex>(jude::Mutex::Mode::Exclusive);
+   auto readerWriter = std::make_shared<jude::Mutex>(jude::Mutex::Mode::ReaderWriter);
+
+   jude::Collection<jude::BenchItem> exclusiveCollection("exclusive", ItemCount, jude_user_Public, exclusive);
+   jude::Collection<jude::BenchItem> sharedCollection("shared", ItemCount, jude_user_Public, readerWriter);
+
+   Populate(exclusiveCollection);
+   Populate(sharedCollection);
+
+   printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+   printf("%8s %18s %18s %8s\n", "threads", "exclusive (GET/s)", "shared (GET/s)", "ratio");
+
+   for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+   {
+      auto exclusiveRate = MeasureReadsPerSecond(exclusiveCollection, threads, duration);
+      auto sharedRate = MeasureReadsPerSecond(sharedCollection, threads, duration);
+      printf("%8u %18.0f %18.0f %8.2f\n", threads, exclusiveRate, sharedRate, sharedRate / exclusiveRate);
+   }
+
+   return 0;
+}
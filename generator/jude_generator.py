@@ -1099,9 +1099,19 @@ class DatabaseEntry:
          result += '\n      %s.SetAccessLevel(CRUD::UPDATE, jude_user_%s);' % (self.name, self.auth_update)
       if self.auth_delete != "Public":
          result += '\n      %s.SetAccessLevel(CRUD::DELETE, jude_user_%s);' % (self.name, self.auth_delete)
+      for indexedField in self.get_indexes():
+         result += '\n      %s.AddIndex("%s");' % (self.name, indexedField)
 
       return result
 
+   def get_indexes(self):
+      indexes = self.field_data.get('index', [])
+      if isinstance(indexes, str):
+         indexes = [ indexes ]
+      if indexes and not self.is_collecton:
+         raise SyntaxError("Database entry '" + self.name + "' is not a collection so cannot be indexed")
+      return [ str(index) for index in indexes ]
+
 class Database:
 
    def calculate_types(self):
@@ -274,10 +274,14 @@ namespace jude
       // Done over the REST API (default) or even just if we create "in code"?
       extern jude_user_t DefaultAccessLevelForJSON; 
 
-      // If set to true, we do not generate random ID's for everything. Instead, we generate the next available ID based
-      // on the collection / array we are about to populate with a new object. 
-      // NOTE: This leads to duplicate ID's in the system but is required to keep our tests backwards compatible.
+      // If set to true, we do not generate random ID's for everything. Instead, collections using the default id policy
+      // hand out sequential ID's, carrying on from the highest ID they hold (see IdPolicy::Sequential).
+      // NOTE: This keeps ID's small and predictable, which our older tests rely on.
       extern bool GenerateIDsBAsedOnCollectionSize;
+
+      // If set to true (default), Object data is allocated from per-type pools of fixed size blocks
+      // rather than from the heap. Pools keep freed blocks for reuse.
+      extern bool UseObjectPools;
    }
 }
 #endif
@@ -40,7 +40,8 @@ struct jude_notification_t
 jude_notification_queue_t* 
      jude_notification_queue_create (size_t max_pending_notifications);
 void jude_notification_queue_destroy(jude_notification_queue_t* queue);
-void jude_notification_queue_post   (jude_notification_queue_t* queue, const jude_notification_t* notification);
+bool jude_notification_queue_post   (jude_notification_queue_t* queue, const jude_notification_t* notification); // false if the queue is full
+bool jude_notification_queue_receive(jude_notification_queue_t* queue, jude_notification_t* notification, uint32_t max_wait_ms); // takes without calling
 bool jude_notification_queue_process(jude_notification_queue_t* queue, uint32_t max_wait_ms);
 
 
@@ -64,14 +64,15 @@ namespace jude
          , messageAccessor(m_copyOfChangedObject)
       {}
 
-      // translate notification
+      // translate notification - the typed notification shares our copy of the object rather than making another.
+      // It keeps its own source locker as it can outlive this notification.
       template<typename T>
       Notification<T> As(std::function<T()>&& sourceLocker) const
       {
          static_assert(std::is_same<T_Object, Object>::value); // can only translate from Notification<Object>
          static_assert(std::is_base_of<Object, T>::value);     // can only translate to a dervied class of Object
 
-         return Notification<T>(m_copyOfChangedObject, [&] { return this->Source().template As<T>(); }, m_deleted);
+         return Notification<T>(const_cast<T_Object*>(&m_copyOfChangedObject), std::move(sourceLocker), m_deleted);
       }
 
       bool IsDeleted() const { return m_deleted; }
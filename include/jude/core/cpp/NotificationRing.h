@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <jude/jude_core.h>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+namespace jude
+{
+   // Bounded lock-free queue of callbacks for many producers and a single consumer. The slots are allocated up front
+   // and the callback is moved into one, so pushing takes no lock and doesn't copy the callback again. Slots hold a
+   // std::function though, so a lambda capturing more than its small buffer (typically a couple of pointers) still
+   // allocates when it is made into one. The consumer only sleeps on the port's semaphore once it finds the ring empty,
+   // and only then do producers signal it.
+   class NotificationRing
+   {
+      struct Slot
+      {
+         std::atomic<size_t>   sequence;
+         std::function<void()> callback;
+      };
+
+      std::unique_ptr<Slot[]>         m_slots;
+      const size_t                    m_mask;
+      alignas(64) std::atomic<size_t> m_tail{0}; // next position claimed by a producer
+      alignas(64) size_t              m_head{0}; // next position read by the consumer
+      std::atomic<bool>               m_consumerWaiting{false};
+      jude_semaphore_t*               m_wakeup;
+
+      NotificationRing(const NotificationRing&) = delete;
+      NotificationRing& operator=(const NotificationRing&) = delete;
+
+      bool TryPop(std::function<void()>& callback);
+
+   public:
+      explicit NotificationRing(size_t capacity); // rounded up to a power of two
+      ~NotificationRing();
+
+      size_t Capacity() const { return m_mask + 1; }
+
+      bool Push(std::function<void()>&& callback); // false if the ring is full - the callback is left with the caller
+
+      // Waits up to maxWaitMs for a callback. Only one thread may pop at a time.
+      bool Pop(std::function<void()>& callback, uint32_t maxWaitMs);
+   };
+}
@@ -26,21 +26,91 @@
 #include <jude/jude_core.h>
 #include <string>
 #include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <functional>
 
 #include "Notification.h"
+#include "NotificationRing.h"
 
 namespace jude
 {
    class NotifyQueue
    {
+   public:
+      enum class Type
+      {
+         Ported,  // the port's queue of jude_notification_t (default)
+         LockFree // NotificationRing - callbacks are held in preallocated slots and sending takes no lock
+      };
+
+      // What Send() does when the queue already holds maxDepth notifications
+      enum class Overflow
+      {
+         DropNewest, // discard the new notification (default)
+         DropOldest, // discard the oldest pending notification to make room
+         Block,      // wait up to the block timeout for room, then discard the new notification
+         Coalesce,   // gather overflowing notifications into one batch that is processed once the queue drains - a full batch drops the new notification
+         Reject      // Send() fails and the caller decides what to do
+      };
+
+      struct Stats
+      {
+         size_t sent;          // notifications given to Send() (not counting immediate or paused queues)
+         size_t processed;
+         size_t dropped;       // lost to DropNewest, DropOldest, a Block timeout or a full overflow batch
+         size_t blocked;       // sends that had to wait for room
+         size_t rejected;
+         size_t coalesced;     // sends added to the overflow batch
+         size_t depth;         // pending right now
+         size_t highWaterMark; // most ever pending at once
+      };
+
+   private:
       std::string m_name;
       jude_notification_queue_t *m_queue;
+      std::unique_ptr<NotificationRing> m_ring;
       std::vector<std::function<void()>> m_pausedNotifications;
       bool m_paused {false};
 
+      bool     m_coalescePerObject {false};
+      size_t   m_maxDepth {0};
+      Overflow m_overflow {Overflow::DropNewest};
+      uint32_t m_blockTimeoutMs {0};
+      jude_semaphore_t* m_spaceAvailable {nullptr};
+      std::atomic<unsigned> m_blockedSenders {0};
+      std::mutex m_consumerMutex; // only used to let producers steal from a LockFree queue for DropOldest
+
+      std::mutex m_overflowMutex;
+      std::vector<std::function<void()>> m_overflowBatch;
+      size_t m_maxOverflowBatch {0};
+      std::atomic<bool> m_hasOverflowBatch {false};
+
+      std::atomic<size_t> m_depth {0};
+      std::atomic<size_t> m_highWaterMark {0};
+      std::atomic<size_t> m_sent {0};
+      std::atomic<size_t> m_processed {0};
+      std::atomic<size_t> m_dropped {0};
+      std::atomic<size_t> m_blocked {0};
+      std::atomic<size_t> m_rejected {0};
+      std::atomic<size_t> m_coalesced {0};
+
       NotifyQueue(std::nullptr_t);  // null queue - only use this for immediate dispatch of notifications
 
+      void Open(const std::string& name, size_t maxDepth, Type type);
+      void Close();
+
+      bool ReserveSlot();
+      void ReleaseSlot();
+      bool WaitForSlot();
+      bool DropOldest();
+      bool Post(std::function<void()>&& callback);
+      bool Receive(std::function<void()>& callback, uint32_t maxWaitMs);
+      bool AddToOverflowBatch(std::function<void()>&& callback);
+      bool ProcessOverflowBatch();
+
    public:
       // Use this queue if you want notifications to be processed immediately rather than posted to a queue
       static NotifyQueue Immediate; 
@@ -48,10 +118,11 @@ namespace jude
       // Unless specified, we will always use the default queue for subscriptions
       static NotifyQueue Default;
 
-      static void SetDefaultQueue(const std::string& name, size_t maxDepth);
+      static void SetDefaultQueue(const std::string& name, size_t maxDepth, Type type = Type::Ported);
       static void SetDefaultQueueAsImmediate();
 
-      explicit NotifyQueue(const std::string& name, size_t maxDepth = 128);
+      // Lock free queues must only be processed by one thread at a time
+      explicit NotifyQueue(const std::string& name, size_t maxDepth = 128, Type type = Type::Ported);
       ~NotifyQueue();
 
       // temporarily stop events being processed
@@ -60,16 +131,57 @@ namespace jude
 
       bool operator==(const NotifyQueue& rhs)
       {
-         return m_queue == rhs.m_queue;
+         return m_queue == rhs.m_queue && m_ring == rhs.m_ring;
       }
 
-      bool IsImmediate() const { return m_queue == nullptr; }
+      bool IsImmediate() const { return m_queue == nullptr && m_ring == nullptr; }
+      Type GetType() const { return m_ring ? Type::LockFree : Type::Ported; }
+
+      // Set before the queue is in use. Don't use Block on a queue that is sent to from its own consumer thread.
+      void SetOverflowPolicy(Overflow policy, uint32_t blockTimeoutMs = 0);
+      Overflow GetOverflowPolicy() const { return m_overflow; }
+
+      // Most notifications the Coalesce overflow batch will hold - 4 x maxDepth unless set
+      void SetMaxOverflowBatch(size_t maxBatch) { m_maxOverflowBatch = maxBatch; }
+      size_t GetMaxOverflowBatch() const { return m_maxOverflowBatch; }
+
+      // Collections hold back changes for this queue so that each object is delivered once with the latest copy and all
+      // fields changed since the last delivery - a slow consumer handles distinct objects rather than every edit
+      void SetCoalescePerObject(bool coalesce) { m_coalescePerObject = coalesce; }
+      bool IsCoalescingPerObject() const { return m_coalescePerObject; }
+
+      Stats GetStats() const;
+      std::string DebugInfo() const;
       
-      void Send(std::function<void()>&& callback);
+      // returns false if the notification was not queued (see Overflow)
+      bool Send(std::function<void()>&& callback);
 
       // Wait for up to "maxWaitMs" milliseconds for a new item in the queue and process it
       // returns true when notifications are processed
       bool Process(uint32_t maxWaitMs = 0);
    };
+
+   // Gathers the callbacks for a batch of changes (possibly from several collections) so that each queue
+   // is sent one message for the whole batch. Immediate callbacks are made first, in the order they were added.
+   class NotificationBatch
+   {
+      struct QueuedCallbacks
+      {
+         NotifyQueue*                       queue;
+         std::vector<std::function<void()>> callbacks;
+         std::vector<std::function<void()>> onDropped;
+      };
+
+      std::vector<std::function<void()>> m_immediate;
+      std::vector<QueuedCallbacks>       m_queued;
+
+   public:
+      // onDropped is called (from Publish) if the queue does not take the message holding this callback
+      void Add(NotifyQueue& queue, std::function<void()>&& callback, std::function<void()>&& onDropped = nullptr);
+      bool IsEmpty() const { return m_immediate.empty() && m_queued.empty(); }
+
+      // Call without holding any locks - callbacks are free to lock objects
+      void Publish();
+   };
 }
 
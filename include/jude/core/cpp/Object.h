@@ -28,6 +28,7 @@
 #include <optional>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #include <jude/jude_core.h>
 #include <jude/core/cpp/FieldMask.h>
@@ -54,15 +55,22 @@ namespace jude
 
       struct SharedRootData
       {
-         std::unique_ptr<jude_object_t> object;
+         jude_object_t* object{nullptr};    // pooled objects share one allocation with this header
+         bool ownsObject{false};            // true when object was allocated separately on the heap
          std::function<void()> onChange;    // called when object or subpath changes
          std::function<void()> onSingleRef; // called when reference count of this shared data is about to be exactly one
+         std::atomic<uint64_t> version{0};  // set by the owning collection each time a change is published
+         std::atomic<bool> editLocked{false}; // set by the owner while it holds the lock for an editable copy - onSingleRef only fires when set
+
+         ~SharedRootData() { if (ownsObject) delete[] reinterpret_cast<char*>(object); }
       };
 
       std::shared_ptr<SharedRootData> m_sharedRoot;
       
       void ReleaseSharedData();
       void OnEdited();
+      void AllocateRoot(const jude_rtti_t& type);
+      bool AttachCallbacks(std::function<void()> onChange, std::function<void()> onSingleRef); // only if we are the sole reference
 
    protected:
       jude_object_t *m_object; // if not null, always points to somewhere inside m_sharedRoot
@@ -117,6 +125,7 @@ namespace jude
 
          Object clone(*m_object->__rtti, onChange, onSingleRef);
          clone.OverwriteData(*this, andClearChangeMarkers);
+         clone.m_sharedRoot->version = Version(); // a copy of the data as it was at this version
 
          // we no longer have a parent.
          clone.m_sharedRoot->object->__parent_offset = 0;
@@ -142,6 +151,10 @@ namespace jude
 
       size_t RefCount() const { return m_sharedRoot.use_count(); }
 
+      // Version given by a collection when a change to the stored object was published (copies keep the version they were
+      // copied at) - 0 if it has never been stored
+      uint64_t Version() const { return m_sharedRoot ? m_sharedRoot->version.load() : 0; }
+
       Object Parent();
       const Object Parent() const;
 
@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <jude/jude_core.h>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+namespace jude
+{
+   // Fixed size block allocator for the root data of Objects of one type.
+   // Each block holds the shared reference header followed by the jude_object_t payload
+   // so creating an Object costs one pool allocation instead of several heap allocations.
+   // Freed blocks are kept for reuse - pools only ever grow.
+   class ObjectPool
+   {
+   public:
+      struct Statistics
+      {
+         size_t pools;           // number of types with a pool
+         size_t blocksInUse;     // objects currently allocated from pools
+         size_t poolAllocations; // objects ever allocated from pools
+         size_t heapAllocations; // heap allocations made on behalf of Objects (pool chunks or unpooled objects)
+      };
+
+      static constexpr size_t BlocksPerChunk = 32;
+
+      static ObjectPool& ForType(const jude_rtti_t& type);
+      static Statistics  GetStatistics();
+      static void        CountHeapAllocations(size_t count); // for objects created without a pool
+
+      // Returns a block with room for a header of headerSize bytes followed by the object data at DataOffset()
+      void*  Allocate(size_t headerSize);
+      void   Free(void* block);
+      size_t DataOffset() const { return m_dataOffset; }
+
+   private:
+      explicit ObjectPool(size_t dataSize);
+
+      std::mutex                           m_mutex;
+      const size_t                         m_dataSize;
+      size_t                               m_dataOffset{0};
+      size_t                               m_blockSize{0};
+      void*                                m_freeList{nullptr};
+      std::vector<std::unique_ptr<char[]>> m_chunks;
+   };
+}
@@ -27,6 +27,7 @@
 #include <jude/core/cpp/RestfulResult.h>
 
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -52,6 +53,9 @@ namespace jude
       virtual RestfulResult RestPut   (const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) = 0;
       virtual RestfulResult RestDelete(const char* path, const AccessControl& accessControl = accessToEverything) = 0;
 
+      // Version of what is at the path, changing whenever it does (e.g. for an HTTP ETag) - not everything is versioned
+      virtual RestfulResult RestGetVersion(const char* /*path*/, uint64_t& /*version*/, const AccessControl& /*accessControl*/ = accessToEverything) const { return jude_rest_Method_Not_Allowed; }
+
       // Convenience functions
       std::string   ToJSON(RestApiSecurityLevel::Value userLevel, size_t maxSize = 0xFFFF) const { return ToJSON("/", maxSize, userLevel); }
       std::string   ToJSON(const char* path = "/", size_t maxSize = 0xFFFF, RestApiSecurityLevel::Value userLevel = Options::DefaultAccessLevelForJSON) const;
@@ -72,6 +76,9 @@ namespace jude
       // Suggest to use this function each time you wish to traverse a URL path
       static std::string GetNextUrlToken(const char* urlPath, const char** resultingSuffix = nullptr, bool stripSlash = true);
 
+      // Decodes the query parameters at the end of a URL path e.g. "/items?limit=10&after=5" - parameters without a value map to ""
+      static std::map<std::string, std::string> GetUrlQuery(const char* urlPath);
+
       ///////////////////////////////////////////////////////////////////////////////
       // Protobuf backwards compatibility
       bool JsonEncodeTo(std::ostream& output, const AccessControl& accessControl = accessToEverything) const
@@ -0,0 +1,97 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <iostream>
+#include <unordered_map>
+
+#include <jude/core/cpp/Object.h>
+
+namespace jude
+{
+   // Count, sum, min and max of one numeric field of the objects in a collection - or just a count of the objects -
+   // optionally for each value of a second "group by" field (e.g. a count for each value of an enum).
+   // Maintained by the collection as changes are published so reads never visit the objects - not thread safe on its own.
+   class Aggregate
+   {
+   public:
+      struct Totals
+      {
+         size_t count{0}; // objects in the group - only those with the value field set when there is a value field
+         double sum{0};
+         double min{0};
+         double max{0};
+
+         double Average() const { return count ? sum / count : 0; }
+      };
+
+   private:
+      struct Group
+      {
+         size_t                 count{0};
+         double                 sum{0};
+         std::multiset<double>  values; // so min and max survive removals
+      };
+
+      struct Contribution
+      {
+         std::string group;
+         double      value;
+      };
+
+      const jude_field_t*                         m_valueField;
+      const jude_field_t*                         m_groupField;
+      std::unordered_map<jude_id_t, Contribution> m_contributions;
+      std::map<std::string, Group>                m_groups;
+
+      bool ReadValue(const Object& object, double& value) const;
+      Totals TotalsOf(const Group& group) const;
+
+   public:
+      // valueField and groupField are optional but must be single fields - valueField must be numeric
+      Aggregate(const jude_field_t* valueField, const jude_field_t* groupField)
+         : m_valueField(valueField)
+         , m_groupField(groupField)
+      {}
+
+      static bool CanAggregate(const jude_field_t& field);
+      static bool CanGroupBy(const jude_field_t& field);
+
+      // Only changes to the fields we aggregate need an update
+      bool IsAffectedBy(const Object& changedObject) const;
+
+      void Update(const Object& object);  // add or re-aggregate the object
+      void Remove(jude_id_t id);
+
+      Totals Get(const std::string& group = "") const; // ungrouped aggregates have the single group ""
+      std::map<std::string, Totals> Groups() const;
+
+      // {"count":n,"sum":s,"min":a,"max":b,"avg":m} - or an object of those for each group when grouped
+      void ToJSON(std::ostream& output) const;
+   };
+}
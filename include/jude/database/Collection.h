@@ -24,19 +24,38 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <list>
+#include <memory>
 #include <set>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <shared_mutex>
 #include <functional>
 #include <algorithm>
 
 #include <jude/jude.h>
 #include <jude/core/cpp/Validatable.h>
 #include "DatabaseEntry.h"
+#include "ObjectStore.h"
+#include "TieredObjectStore.h"
+#include "SecondaryIndex.h"
+#include "SubscriberIndex.h"
+#include "OrderedIndex.h"
+#include "Aggregate.h"
+#include "ExpiryWheel.h"
+#include "IdAllocator.h"
+#include "CollectionQuery.h"
+#include "CollectionSnapshot.h"
 #include "Transaction.h"
 #include "CollectionIterator.h"
 
 namespace jude
 {
+   class DatabaseTransaction;
+
    class CollectionBase : public DatabaseEntry
                         , public Validatable<>
    {
@@ -44,6 +63,7 @@ namespace jude
 
       friend struct CollectionBaseIterator;
       friend struct CollectionBaseConstIterator;
+      friend class DatabaseTransaction;
 
       uint32_t nextSubscriberId = 0;
 
@@ -56,8 +76,44 @@ namespace jude
          RestApiSecurityLevel::Value canDelete;
       } m_access;
       
-      std::map<jude_id_t, Object> m_objects;
-      const size_t                m_capacity;
+      std::unique_ptr<ObjectStore> m_objects;
+      TieredObjectStore*           m_tieredObjects{nullptr}; // m_objects when spilling to disk
+      size_t                       m_reservedInserts{0};     // room held for database transactions being committed - guarded by m_mutex
+      const size_t                 m_capacity;
+      mutable IdAllocator          m_idAllocator;
+
+      // Lock stripes for object level locking - empty unless EnableObjectLocking() has been called
+      std::vector<std::unique_ptr<jude::Mutex>> m_objectLocks;
+
+      // Secondary indexes and aggregates have their own lock as they are updated by whoever publishes a change
+      mutable std::mutex               m_indexMutex;
+      std::vector<SecondaryIndex>      m_indexes;
+      std::vector<OrderedIndex>        m_orderedIndexes;
+      std::map<std::string, Aggregate> m_aggregates;
+      // Added but not yet built - writers keep these up to date while AddIndex() etc. fill them in
+      std::list<SecondaryIndex>        m_buildingIndexes;
+      std::list<OrderedIndex>          m_buildingOrderedIndexes;
+      std::map<std::string, Aggregate> m_buildingAggregates;
+
+      // While any snapshot is alive the latest table is remembered so the next one only rebuilds the chunks changed since.
+      // m_snapshotMutex is never held while waiting for another lock; one snapshot is built at a time.
+      mutable std::mutex                                     m_snapshotMutex;
+      mutable std::mutex                                     m_snapshotBuildMutex;
+      mutable std::weak_ptr<const CollectionSnapshot::Table> m_snapshot;
+      mutable std::vector<jude_id_t>                         m_snapshotChangedIds;
+      mutable bool                                           m_snapshotBuilding{false};
+      mutable uint32_t                                       m_snapshotGeneration{0};
+
+      std::atomic<uint64_t> m_version{0};
+
+      // Time-to-live - the wheel is only created once expiry is used. m_expiryMutex is never held while waiting for another lock.
+      mutable std::mutex           m_expiryMutex;
+      std::unique_ptr<ExpiryWheel> m_expiry;
+      std::chrono::milliseconds    m_timeToLive{0};
+      std::atomic<bool>            m_expiryInUse{false};
+      std::thread                  m_expiryThread;
+      std::condition_variable      m_expiryWakeup;
+      bool                         m_expiryThreadStopping{false};
       
       struct CollectionSubscriber
       {
@@ -68,26 +124,108 @@ namespace jude
          size_t       ptrdiff;      
       };
       std::unordered_map<uint32_t, CollectionSubscriber> m_subscribers;
+      SubscriberIndex m_subscriberIndex; // who to notify for a change - kept in step with m_subscribers
+      std::atomic<size_t> m_subscriberCount{0}; // read without the lock so unwatched changes cost nothing
       std::unordered_map<uint32_t, Validatable<>::Validator> m_validators;
 
       ValidationResult Validate(Validation<Object>& resource);
       void OnChanged();
 
+      jude::Mutex&  ObjectMutex(jude_id_t id) const;
+      jude_id_t     FindStoredId(jude_id_t id, bool next) const;
+      Object*       FindStoredObject(jude_id_t id);
+      bool          ReadObject(jude_id_t id, const std::function<void(const Object&)>& reader) const;
+      void          ForEachObject(const std::function<bool(const Object&)>& reader, jude_id_t after = JUDE_INVALID_ID) const; // in id order
+      void          ForEachMatch(const CollectionQuery& query, const std::function<bool(const Object&)>& reader, jude_id_t after = JUDE_INVALID_ID) const;
+      void          OnSnapshotChange(jude_id_t id);
+      Object        AdoptObject(Object& candidate, jude_id_t id);
+      void          UnshareStoredObject(Object& storedObject, jude_id_t id); // caller must hold ObjectMutex(id)
+      bool          EncodeForSpill(const Object& object, std::string& bytes) const;
+      Object        DecodeSpilledObject(jude_id_t id, uint64_t version, const std::string& bytes) const;
+      void          EvictColdObjects() const;
+      void          UpdateIndexes(const Object& changedObject, bool isDeleted);
+      void          BuildIndex(const std::function<void(const Object&)>& update); // fills in an index added to the building lists
+      void          UpdateExpiry(jude_id_t id, bool isDeleted);
+      ExpiryWheel&  Expiry(); // call with m_expiryMutex held
+
+      std::vector<std::unique_lock<jude::Mutex>> LockObjects(std::vector<jude_id_t> ids); // locks each object mutex once in a consistent order
+
+      // Objects chosen for a batch delete. If the object has moved on from matchedVersion (when non zero) it is
+      // only deleted if it still matches.
+      struct DeleteCandidate
+      {
+         jude_id_t id;
+         uint64_t  matchedVersion;
+      };
+      // With allOrNothing a missing id or a refused deletion fails the batch, otherwise those objects are skipped
+      RestfulResult DeleteBatch(const std::vector<DeleteCandidate>& candidates, const std::function<bool(const Object&)>& stillMatches, bool allOrNothing, size_t& deletedCount);
+
+      struct PendingNotification
+      {
+         jude_id_t            id;
+         Notification<Object> event;
+      };
+      using PendingNotifications = std::vector<PendingNotification>;
+
+      // Changes waiting on a queue that coalesces per object - one merged notification per id, in the order the
+      // ids first changed. The queue holds a single message that delivers them all.
+      struct CoalescedChange
+      {
+         PendingNotification latest;   // shared with other subscribers - marked with the merged changes on delivery
+         FieldMask           changes;  // everything changed since the last delivery
+         bool                merged;
+      };
+      struct CoalescedNotifications
+      {
+         std::vector<jude_id_t>                                  order;
+         std::unordered_map<jude_id_t, CoalescedChange>          byId;
+         bool                                                    messageSent = false;
+      };
+      std::mutex                                                 m_coalescedMutex;
+      std::unordered_map<NotifyQueue*, CoalescedNotifications>   m_coalesced;
+
+      void CoalesceNotification(CoalescedNotifications& pending, const PendingNotification& notification);
+      void HandleCoalescedChangesFromQueue(NotifyQueue* origin);
+
       void PublishChangesToQueue(jude_id_t id);
       void PublishChangesToQueue(Object& changedObject, bool isDeleted);
-      void HandleChangesFromQueue(const Notification<Object>& notification, NotifyQueue* origin);
+      void AddNotification(PendingNotifications& notifications, Object& changedObject, bool isDeleted);
+      bool HasInterestedSubscribers(const Object& changedObject, bool isDeleted) const;
+      void PublishNotifications(PendingNotifications&& notifications);
+      void AddToBatch(PendingNotifications&& notifications, NotificationBatch& batch); // decides who to notify, the batch is published later
+      void HandleChangesFromQueue(const PendingNotifications& notifications, const std::vector<size_t>& indexes, NotifyQueue* origin);
       jude_id_t FindObjectIdFromPath(const char* path_token) const;
+      jude_id_t GenerateId() const; // JUDE_INVALID_ID if no unused id could be found
+      RestfulResult InsertObject(Object candidateObject, bool generate_uuid, bool andValidate);
+
+      // Steps of a DatabaseTransaction commit - the caller holds ObjectMutex(id) throughout
+      bool             ReserveInserts(size_t count); // false if there isn't room - otherwise call ReleaseInserts() once applied or abandoned
+      void             ReleaseInserts(size_t count);
+      ValidationResult ValidateChange(jude_id_t id, Object& changed, bool isNew, bool isDeleted);
+      void             ApplyChange(jude_id_t id, Object& changed, bool isNew, bool isDeleted, PendingNotifications& notifications);
+      RestfulResult RestPostMany(std::istream& input, const AccessControl& accessControl);
 
    protected:
       CollectionBase(const CollectionBase&) = delete;
 
       explicit CollectionBase(const jude_rtti_t &RTTI, const std::string& name, RestApiSecurityLevel::Value accessLevel, size_t capacity, std::shared_ptr<jude::Mutex> mutex);
-      virtual ~CollectionBase() {}
+      virtual ~CollectionBase();
 
       RestfulResult Post(const Object& newObject, bool generate_uuid, bool andValidate); // create new (new uuid is generated unless specified)
+      RestfulResult Post(Object&& newObject, bool generate_uuid, bool andValidate);      // as above but stores the object itself if nobody else refers to it
+      // Batches - all objects are validated before any are stored, then locking and notification is done once for the batch
+      RestfulResult PostMany(std::vector<Object>& newObjects, bool generate_uuid, bool andValidate, std::vector<jude_id_t>* createdIds = nullptr);
+      RestfulResult PatchMany(const std::vector<const Object*>& patches); // each patch needs an id
+      // Deletes the objects that match (and that validators allow) as one batch - returns the number deleted.
+      // Matching is done over the live store under the shared lock - objects changed after they matched are left alone.
+      size_t EraseIf(const std::function<bool(const Object&)>& matches);
+      // Visits the objects in id order from a snapshot (or in place when spilling to disk) - see ForEachMatch()
+      void ForEachPublished(const std::function<bool(const Object&)>& reader) const;
 
       // Edit locks - these won't validate but will lock for editing by code.
       Object LockForEdit(jude_id_t id, bool next = false);
+      // Read locks - takes the shared lock only long enough to make a copy of the object
+      Object LockForRead(jude_id_t id, bool next = false) const;
       Object LockForEditFromPath(const char** fullpath, bool& isRootPath);
       void   OnEdited(jude_id_t id); // We can configure the collection to call this each time a change is made
       void   OnEditCompleted(jude_id_t id);
@@ -97,31 +235,94 @@ namespace jude
       Transaction<T_Object> LockForTransaction(jude_id_t id)
       {
          // Lock now - pass this into the transaction to keep locked until the transaction completes.
-         std::unique_lock<jude::Mutex> lock(*m_mutex);
+         std::unique_lock<jude::Mutex> lock(ObjectMutex(id));
 
-         auto objectRecord = m_objects.find(id);
-         if (objectRecord == m_objects.end())
+         auto storedObject = FindStoredObject(id);
+         if (!storedObject)
          {
             return nullptr;
          }
          
-         return Transaction<T_Object>(
+         return EvictAfterUnlock(Transaction<T_Object>(
             std::move(lock),
-            objectRecord->second,    // we make a copy for transactions
+            *storedObject,    // we make a copy for transactions
             [this, id](Object& resource, bool needsCommit)->RestfulResult
             {
                return OnTransactionCompleted(id, resource, needsCommit);
             }
-         );
+         ));
+      }
+
+      // Delta transactions - edits start from an empty object so only the changed fields are copied back on commit
+      template<class T_Object = Object>
+      Transaction<T_Object> LockForDeltaTransaction(jude_id_t id)
+      {
+         std::unique_lock<jude::Mutex> lock(ObjectMutex(id));
+
+         auto storedObject = FindStoredObject(id);
+         if (!storedObject)
+         {
+            return nullptr;
+         }
+
+         Object delta(m_rtti);
+         delta.AssignId(id);
+         delta.ClearChangeMarkers();
+
+         return EvictAfterUnlock(Transaction<T_Object>(
+            std::move(lock),
+            std::move(delta),
+            *storedObject,    // readable through Original() - no copy
+            [this, id](Object& resource, bool needsCommit)->RestfulResult
+            {
+               return OnDeltaTransactionCompleted(id, resource, needsCommit);
+            }
+         ));
+      }
+
+      // Optimistic transactions - nothing is locked until commit, when the edit is only applied if nobody else has
+      // changed the object in the meantime. Otherwise the commit fails with jude_rest_Conflict.
+      template<class T_Object = Object>
+      Transaction<T_Object> CreateOptimisticTransaction(jude_id_t id)
+      {
+         auto copy = LockForRead(id);
+         if (!copy)
+         {
+            return nullptr;
+         }
+
+         auto version = copy.Version();
+         return EvictAfterUnlock(Transaction<T_Object>(
+            std::unique_lock<jude::Mutex>(), // no lock held
+            std::move(copy),                 // already our own copy
+            [this, id, version](Object& resource, bool needsCommit)->RestfulResult
+            {
+               return OnOptimisticTransactionCompleted(id, version, resource, needsCommit);
+            }
+         ));
       }
 
       Transaction<Object> CreateTransactionFromPath(const char** fullpath, bool& isRootPath);
       RestfulResult       OnTransactionCompleted(jude_id_t id, Object& copy, bool needsCommit);
+      RestfulResult       OnOptimisticTransactionCompleted(jude_id_t id, uint64_t version, Object& copy, bool needsCommit);
+      RestfulResult       OnDeltaTransactionCompleted(jude_id_t id, Object& delta, bool needsCommit);
+      RestfulResult       ApplyDelta(jude_id_t id, const Object& delta); // caller must hold ObjectMutex(id)
 
 
       void Unsubscribe(uint32_t subscriberId);
       void DeregisterValidator(uint32_t validatorId);
 
+      // Objects can't be evicted while a transaction holds their lock so check again once it has been released
+      template<class T_Object>
+      Transaction<T_Object> EvictAfterUnlock(Transaction<T_Object> transaction) const
+      {
+         if (m_tieredObjects)
+         {
+            transaction.AfterUnlock([this] { EvictColdObjects(); });
+         }
+         return transaction;
+      }
+
       template<class T_Object = Object>
       Transaction<T_Object> CreatePostTransaction(jude_id_t id = JUDE_AUTO_ID, bool andValidate = true)
       {
@@ -132,45 +333,41 @@ namespace jude
 
          if (id == JUDE_AUTO_ID)
          {
-            ////////////////////////////////////////////////////////
-            // Protobuf compatibility layer
-            if (Options::GenerateIDsBAsedOnCollectionSize && !ContainsId(count() + 1))
+            id = GenerateId();
+            if (id == JUDE_INVALID_ID)
             {
-               id = count() + 1;
-            }
-            else
-            ////////////////////////////////////////////////////////
-            {
-               id = jude_generate_uuid();
+               return Transaction<T_Object>("Could not generate a unique id");
             }
          }
          
          // Lock now - pass this into the transaction to keep locked until the transaction completes.
-         std::unique_lock<jude::Mutex> lock(*m_mutex); 
+         std::unique_lock<jude::Mutex> lock(ObjectMutex(id)); 
 
          Object newObject(m_rtti);
 
          newObject.AssignId(id);
 
-         return Transaction<T_Object>(
+         return EvictAfterUnlock(Transaction<T_Object>(
             std::move(lock),
-            newObject,
+            std::move(newObject), // nobody else has this so no need for a copy
             [this, id, andValidate](Object& resource, bool needsCommit)->RestfulResult
             {
                if (needsCommit)
                {
                   resource.AssignId(id); // NOTE: You can't change id once post has started
-                  return Post(resource, false, andValidate);
+                  return Post(std::move(resource), false, andValidate); // the transaction is finished with it
                }
                return jude_rest_OK;
             }
-         );
+         ));
       }
 
       void HandleObjectNotification(const jude_notification_t* notify_data);
       void ProcessNotification(const jude_notification_t* notify_data);
 
    public:
+      static constexpr size_t DefaultLockStripes = 64;
+
       std::string GetName() const { return m_name; }
       const jude_rtti_t* GetType() const override { return &m_rtti; }
       RestApiSecurityLevel::Value GetAccessLevel(CRUD crud) const override;
@@ -199,21 +396,94 @@ namespace jude
 
       RestfulResult RestoreEntry(std::istream& input); // for restoring from persistence
       RestfulResult Delete(jude_id_t id);
-      void clear();
+      // Deletes all the objects or none of them - validated together, then locking and notification is done once for the batch
+      RestfulResult DeleteMany(const std::vector<jude_id_t>& ids);
+      void clear(); // deletes every object that validators allow to be deleted
       size_t count() const;
       size_t size() const { return count(); }
       size_t capacity() const { return m_capacity; }
-      bool Full() const { return count() >= capacity(); }
+      bool Full() const; // includes room held by database transactions being committed
 
       bool ContainsId(jude_id_t id) const;
       std::vector<jude_id_t> GetIds() const;
 
+      // Object level locking - edits and transactions on different ids stop contending on the collection mutex,
+      // which is then only held while objects are inserted into or erased from the collection.
+      // Objects share one of 'stripes' recursive locks chosen by id. Enable before the collection is in use.
+      // NOTE: Code that edits more than one object at a time must lock them in a consistent order.
+      void EnableObjectLocking(size_t stripes = DefaultLockStripes);
+      bool HasObjectLocking() const { return !m_objectLocks.empty(); }
+
+      // Choose how ids are given to posted objects - sequential and block ids are handed out without any locking.
+      // Not thread safe: choose before posting. Sequential ids carry on from the highest id already stored.
+      void SetIdPolicy(IdPolicy policy, size_t blockSize = IdAllocator::DefaultBlockSize);
+      IdPolicy GetIdPolicy() const { return m_idAllocator.GetPolicy(); }
+
+      // Choose how objects are stored - Hashed gives O(1) lookups by id for large collections.
+      // Can only be changed while the collection is empty.
+      bool SetStoragePolicy(StoragePolicy policy);
+      StoragePolicy GetStoragePolicy() const { return m_objects->GetPolicy(); }
+
+      // Memory bounded storage - at most maxResidentObjects stay in memory and the least recently used are written
+      // to filePath (in the protobuf encoding), then read back in when next locked. Can only be enabled while the
+      // collection is empty. Objects are evicted after reads, edits and posts; the file is removed with the collection.
+      bool EnableSpillToDisk(const std::string& filePath, size_t maxResidentObjects);
+      TieredObjectStore::Stats GetSpillStats() const; // all zero unless spilling to disk
+
+      // Secondary indexes make "*field=value" path lookups O(1) instead of scanning every object.
+      // Indexes follow published changes so an edit still in progress is not visible until it completes.
+      bool AddIndex(const char* fieldName);
+      bool HasIndex(const char* fieldName) const;
+      std::vector<jude_id_t> FindIdsByIndex(const char* fieldName, const std::string& value) const; // ascending ids
+
+      // Ordered indexes keep the ids in the order of a numeric or string field so TopIds() and ForEachIdInOrder()
+      // don't have to visit or copy every object. Objects without the field set are left out.
+      bool AddOrderedIndex(const char* fieldName);
+      bool HasOrderedIndex(const char* fieldName) const;
+      // Ids of the k objects with the highest (or lowest) values - without an ordered index this is one pass with a k sized heap
+      std::vector<jude_id_t> TopIds(const char* fieldName, size_t k, bool highestFirst = true) const;
+      // Walks the ids in field order until the visitor returns false - false if the field has no ordered index.
+      // The index is read a chunk at a time so changes published during the walk may or may not be seen.
+      bool ForEachIdInOrder(const char* fieldName, const std::function<bool(jude_id_t)>& visitor, bool descending = false) const;
+
+      // Aggregates keep the count, sum, min and max of a numeric field (or just a count when valueField is null) as
+      // changes are published, optionally for each value of groupByField. Reads are O(1) - also GET "?aggregate=<name>".
+      bool AddAggregate(const std::string& name, const char* valueField, const char* groupByField = nullptr);
+      bool HasAggregate(const std::string& name) const;
+      Aggregate::Totals GetAggregate(const std::string& name, const std::string& group = "") const;
+      std::map<std::string, Aggregate::Totals> GetAggregateGroups(const std::string& name) const;
+
+      // Time-to-live: objects are deleted once unchanged for timeToLive (zero turns it off - existing objects are given
+      // timeToLive from now) or at the time given to ExpireAfter() for one object. Any change restarts the collection TTL.
+      // ExpireObjects() deletes whatever has expired through Delete(), so validators and subscribers see each one as usual,
+      // and is called every period by a background thread once StartExpiryThread() is called.
+      void SetTimeToLive(std::chrono::milliseconds timeToLive);
+      std::chrono::milliseconds GetTimeToLive() const;
+      bool ExpireAfter(jude_id_t id, std::chrono::milliseconds timeToLive);
+      size_t ExpireObjects(ExpiryWheel::Clock::time_point now = ExpiryWheel::Clock::now()); // returns the number deleted
+      void StartExpiryThread(std::chrono::milliseconds period = std::chrono::milliseconds(100));
+      void StopExpiryThread();
+
+      // Ascending ids of the objects that match the query's "where" terms - an "=" term on an indexed field avoids a scan
+      std::vector<jude_id_t> FindIds(const CollectionQuery& query) const;
+
+      // Immutable view of the collection as last published. Objects are shared with the collection until they are next
+      // changed, and unchanged chunks of 64 entries are shared with the previous snapshot - so this is O(1) when nothing
+      // has changed and otherwise costs a pointer per chunk plus a chunk per changed object. Nothing is kept once the
+      // last snapshot is released, but objects a live snapshot refers to are not spilled to disk.
+      CollectionSnapshot Snapshot() const;
+
+      // The collection's version goes up with every published change and each changed object is given the new value.
+      // A REST PATCH with "?ifVersion=<n>" fails with Precondition_Failed unless the object is still at version n.
+      uint64_t Version() const { return m_version; }
+
       // From RestApiInterface...
       virtual RestfulResult RestGet(const char* path, std::ostream& output, const AccessControl& accessControl = accessToEverything) const override;
       virtual RestfulResult RestPost(const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) override;
       virtual RestfulResult RestPatch(const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) override;
       virtual RestfulResult RestPut(const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) override;
       virtual RestfulResult RestDelete(const char* path, const AccessControl& accessControl = accessToEverything) override;
+      virtual RestfulResult RestGetVersion(const char* path, uint64_t& version, const AccessControl& accessControl = accessToEverything) const override;
 
       virtual std::vector<std::string> SearchForPath(CRUD operationType, const char* pathPrefix, jude_size_t maxPaths, RestApiSecurityLevel::Value userLevel = jude_user_Root) const override;
 
@@ -282,6 +552,40 @@ namespace jude
       template<typename Pred>
       iterator find_if(Pred p) { return std::find_if(begin(), end(), p); }
 
+      // Copies of the k objects with the highest (or lowest) values of the field - see TopIds()
+      std::vector<T_Object> TopK(const char* fieldName, size_t k, bool highestFirst = true) const
+      {
+         std::vector<T_Object> results;
+         for (auto id : TopIds(fieldName, k, highestFirst))
+         {
+            if (auto object = LockForRead(id)) // unless deleted since
+            {
+               results.emplace_back(object.As<T_Object>());
+            }
+         }
+         return results;
+      }
+
+      // Visits a copy of each object in field order until the visitor returns false - needs an ordered index on the field
+      bool ForEachInOrder(const char* fieldName, const std::function<bool(const T_Object&)>& visitor, bool descending = false) const
+      {
+         return ForEachIdInOrder(fieldName, [&] (jude_id_t id) {
+            auto object = LockForRead(id);
+            return !object || visitor(object.As<T_Object>());
+         }, descending);
+      }
+
+      // Deletes every object that matches in one batch - returns the number deleted.
+      // The predicate is called under the collection's shared lock and only gets a read-only view of each object.
+      template<typename Pred>
+      size_t erase_if(Pred p)
+      {
+         return EraseIf([&p] (const Object& object) {
+            const T_Object typed = const_cast<Object&>(object).As<T_Object>(); // the const handle keeps the stored data read-only
+            return p(typed);
+         });
+      }
+
       template<typename Pred>
       void remove_if(Pred p) { if (auto it = std::find_if(begin(), end(), p)) Delete(it->Id()); }
 
@@ -295,8 +599,42 @@ namespace jude
 
       Transaction<T_Object> Post(jude_id_t id = JUDE_AUTO_ID)   {  return CreatePostTransaction<T_Object>(id, !Options::ValidatePostOnlyForRestAPI);  }
     
+      // Adds all the objects or none of them. Objects without an id are given one.
+      // Pass the vector with std::move() to store the objects without copying them.
+      RestfulResult PostMany(std::vector<T_Object> newObjects, std::vector<jude_id_t>* createdIds = nullptr)
+      {
+         std::vector<Object> objects;
+         objects.reserve(newObjects.size());
+         for (auto& newObject : newObjects)
+         {
+            objects.emplace_back(std::move(newObject));
+         }
+         newObjects.clear();
+         return CollectionBase::PostMany(objects, false, !Options::ValidatePostOnlyForRestAPI, createdIds);
+      }
+
+      // Applies the changed fields of each patch to the object with the same id - all or nothing
+      RestfulResult PatchMany(const std::vector<T_Object>& patches)
+      {
+         std::vector<const Object*> objects;
+         objects.reserve(patches.size());
+         for (auto& patch : patches)
+         {
+            objects.push_back(&patch);
+         }
+         return CollectionBase::PatchMany(objects);
+      }
+
       Transaction<T_Object> TransactionLock(jude_id_t id)   {  return LockForTransaction<T_Object>(id);  }
 
+      // Cheaper transaction for large objects: the transaction object starts empty (read current values with Original())
+      // and only the fields set in it are applied on commit. Arrays that are set replace the stored array.
+      Transaction<T_Object> DeltaTransactionLock(jude_id_t id)   {  return LockForDeltaTransaction<T_Object>(id);  }
+
+      // Holds no lock while you edit so long edits don't stall other threads. Commit() returns jude_rest_Conflict if
+      // someone else changed the object first - start a new transaction and try again.
+      Transaction<T_Object> OptimisticTransaction(jude_id_t id)   {  return CreateOptimisticTransaction<T_Object>(id);  }
+
       SubscriptionHandle OnChange(T_Subscriber callback,
                             FieldMask resourceFieldFilter = FieldMask::ForAllChanges(),
                             NotifyQueue& queue = NotifyQueue::Default) override
@@ -327,20 +665,23 @@ namespace jude
             });
       }
 
+      // These read from a snapshot so return copies - use a transaction to change an object
       template<typename Pred>
-      std::vector<T_Object> find_all(Pred p) 
+      std::vector<T_Object> find_all(Pred p) const
       {
          std::vector<T_Object> results;
-         std::for_each(begin(), end(), [&] (T_Object& element) {
+         ForEachPublished([&] (const Object& object) {
+            auto element = CollectionSnapshot::As<T_Object>(object);
             if (p(element))
             {
-               results.emplace_back(element);
+               results.emplace_back(object.CloneAs<T_Object>());
             }
-         });  
+            return true;
+         });
          return results;
       }
 
-      std::vector<T_Object> AsVector() 
+      std::vector<T_Object> AsVector() const
       {
          return find_all([] (auto&) { return true; });
       }
@@ -174,7 +174,8 @@ namespace jude
       {
          if (m_iter) 
          { 
-            m_value = m_iter->CloneAs<T_Object>(); 
+            // m_iter already holds its own read copy so no need to clone again
+            m_value = const_cast<Object&>(*m_iter).As<T_Object>(); 
          }
          else
          {
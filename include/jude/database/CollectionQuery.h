@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <jude/core/cpp/Object.h>
+#include <jude/core/cpp/FieldMask.h>
+#include <jude/core/cpp/RestfulResult.h>
+
+namespace jude
+{
+   // Filter and projection for reading a collection, e.g. from "?where=value>=10 and name=bob&fields=name,value".
+   // Predicates are compiled once against the type so objects are tested by reading their field data directly.
+   class CollectionQuery
+   {
+   public:
+      enum class Operator { Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual };
+
+      struct Predicate
+      {
+         const jude_field_t* field;
+         size_t              offset;   // of the field data from the start of the object
+         Operator            op;
+         int64_t             signedValue;
+         uint64_t            unsignedValue;
+         double              floatValue;
+         std::string         stringValue;
+
+         bool Matches(const jude_object_t& object) const;
+         bool IndexKey(std::string& key) const; // the value as a secondary index holds it - false if an index can't be used
+      };
+
+   private:
+      const jude_rtti_t&     m_rtti;
+      std::vector<Predicate> m_predicates; // all must match
+      FieldMask              m_fields;
+      bool                   m_hasProjection{false};
+
+   public:
+      explicit CollectionQuery(const jude_rtti_t& rtti)
+         : m_rtti(rtti)
+      {}
+
+      // "field op value" terms joined by " and " - op is one of = == != < <= > >=
+      // Strings may be quoted, enums are given by name. Unset fields never match.
+      RestfulResult Where(const std::string& expression);
+      // Comma separated field names - only these (and the id) are output
+      RestfulResult Select(const std::string& fieldList);
+
+      const std::vector<Predicate>& Predicates() const { return m_predicates; }
+      bool HasFilter() const { return !m_predicates.empty(); }
+      bool HasProjection() const { return m_hasProjection; }
+      const FieldMask& Fields() const { return m_fields; }
+
+      bool Matches(const Object& object) const;
+   };
+}
@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <iterator>
+
+#include <jude/core/cpp/Object.h>
+
+namespace jude
+{
+   // An immutable view of the objects in a collection at one moment - see CollectionBase::Snapshot().
+   // Readers can take as long as they like over a snapshot without blocking writers to the collection.
+   // Objects in a snapshot share their data with the collection (copy-on-write) so must never be edited.
+   class CollectionSnapshot
+   {
+   public:
+      static constexpr size_t ChunkSize = 64;
+
+      using Entry = std::pair<jude_id_t, Object>;
+      using Chunk = std::vector<Entry>; // in id order, never empty
+
+      // Chunks that hold no changed objects are shared between one snapshot and the next
+      struct Table
+      {
+         std::vector<std::shared_ptr<const Chunk>> chunks; // in id order
+         size_t size{0};
+      };
+
+      class const_iterator
+      {
+         using ChunkIterator = std::vector<std::shared_ptr<const Chunk>>::const_iterator;
+
+         ChunkIterator m_chunk;
+         size_t        m_entry{0};
+
+      public:
+         using iterator_category = std::forward_iterator_tag;
+         using value_type        = Object;
+         using difference_type   = std::ptrdiff_t;
+         using pointer           = const Object*;
+         using reference         = const Object&;
+
+         const_iterator(ChunkIterator chunk, size_t entry) : m_chunk(chunk), m_entry(entry) {}
+
+         reference operator*() const { return (**m_chunk)[m_entry].second; }
+         pointer operator->() const { return &(**m_chunk)[m_entry].second; }
+         const_iterator& operator++() 
+         { 
+            if (++m_entry == (*m_chunk)->size())
+            {
+               ++m_chunk;
+               m_entry = 0;
+            }
+            return *this; 
+         }
+         const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+
+         friend bool operator== (const const_iterator& a, const const_iterator& b) { return a.m_chunk == b.m_chunk && a.m_entry == b.m_entry; }
+         friend bool operator!= (const const_iterator& a, const const_iterator& b) { return !(a == b); }
+      };
+
+   private:
+      std::shared_ptr<const Table> m_table;
+
+   public:
+      CollectionSnapshot(std::shared_ptr<const Table> table)
+         : m_table(std::move(table))
+      {}
+
+      size_t size() const { return m_table->size; }
+      bool   empty() const { return m_table->size == 0; }
+
+      const_iterator begin() const { return const_iterator(m_table->chunks.begin(), 0); }
+      const_iterator end() const   { return const_iterator(m_table->chunks.end(), 0); }
+
+      const Object* Find(jude_id_t id) const;
+      void ForEach(const std::function<bool(const Object&)>& visitor, jude_id_t after = JUDE_INVALID_ID) const; // return false to stop
+
+      // A typed view of a frozen object - for reading only
+      template<class T_Object>
+      static T_Object As(const Object& object)
+      {
+         return const_cast<Object&>(object).As<T_Object>();
+      }
+   };
+}
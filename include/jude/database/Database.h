@@ -69,6 +69,7 @@ namespace jude
       virtual RestfulResult RestPatch(const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) override;
       virtual RestfulResult RestPut(const char* path, std::istream& input, const AccessControl& accessControl = accessToEverything) override;
       virtual RestfulResult RestDelete(const char* path, const AccessControl& accessControl = accessToEverything) override;
+      virtual RestfulResult RestGetVersion(const char* path, uint64_t& version, const AccessControl& accessControl = accessToEverything) const override;
 
       virtual std::vector<std::string> SearchForPath(CRUD operationType, const char* pathPrefix, jude_size_t maxPaths, RestApiSecurityLevel::Value userLevel = jude_user_Root) const override;
 
@@ -0,0 +1,99 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "Collection.h"
+
+namespace jude
+{
+   // Changes to objects in any number of collections (e.g. an order and its stock lines) that are applied together or
+   // not at all. Nothing is locked while changes are staged. Commit() locks every object involved in a fixed order,
+   // checks none has changed since it was staged, validates every change and only then applies them. Subscribers
+   // get one notification batch for the whole transaction - one message per queue.
+   // Like Transaction, it commits when destroyed unless Commit() or Abort() has already been called.
+   class DatabaseTransaction
+   {
+      struct Entry
+      {
+         CollectionBase* collection;
+         jude_id_t       id;
+         bool            isNew;
+         bool            isDeleted;
+         uint64_t        version; // of the stored object when the change was staged
+         Object          object;  // staged copy - null for deletes
+      };
+
+      class InsertReservation; // room held in a collection while a commit is applied
+
+      std::vector<Entry> m_entries;
+      bool               m_done{false};
+
+      Entry*  Find(const CollectionBase& collection, jude_id_t id);
+      Object* StageEdit(CollectionBase& collection, jude_id_t id);
+      Object* StagePost(CollectionBase& collection, Object& newObject);
+
+   public:
+      DatabaseTransaction() = default;
+      DatabaseTransaction(DatabaseTransaction&&) = default;
+      DatabaseTransaction(const DatabaseTransaction&) = delete;
+      ~DatabaseTransaction();
+
+      // A copy of the object to edit - null if the object doesn't exist or is to be deleted
+      template<class T_Object>
+      T_Object Edit(Collection<T_Object>& collection, jude_id_t id)
+      {
+         auto staged = StageEdit(collection, id);
+         return staged ? staged->template As<T_Object>() : T_Object(nullptr);
+      }
+
+      // A new object to fill in - null if the id is already part of this transaction or no unused id could be found
+      template<class T_Object>
+      T_Object Post(Collection<T_Object>& collection, jude_id_t id = JUDE_AUTO_ID)
+      {
+         if (id == JUDE_AUTO_ID)
+         {
+            id = collection.GenerateId();
+            if (id == JUDE_INVALID_ID)
+            {
+               return T_Object(nullptr);
+            }
+         }
+         Object newObject = T_Object::New();
+         newObject.AssignId(id);
+         auto staged = StagePost(collection, newObject);
+         return staged ? staged->template As<T_Object>() : T_Object(nullptr);
+      }
+
+      bool Delete(CollectionBase& collection, jude_id_t id); // false if the object doesn't exist
+
+      size_t size() const { return m_entries.size(); }
+
+      // Conflict if any object changed (or was added) since it was staged, nothing is changed unless all is OK
+      RestfulResult Commit();
+      void Abort();
+   };
+}
@@ -0,0 +1,84 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+
+#include <jude/jude_core.h>
+
+namespace jude
+{
+   // Hierarchical timer wheel of object expiry times: each level has 64 slots, each slot a level down is 64 times
+   // shorter. Arming, re-arming and cancelling are O(1) and advancing only visits the slots that come due, so
+   // expired ids are found without scanning every object. Not thread safe on its own.
+   class ExpiryWheel
+   {
+   public:
+      using Clock = std::chrono::steady_clock;
+
+   private:
+      static constexpr unsigned SlotBits = 6;
+      static constexpr unsigned Slots    = 1u << SlotBits;
+      static constexpr unsigned Levels   = 5;
+
+      struct Entry
+      {
+         jude_id_t id;
+         uint64_t  deadline; // in ticks
+      };
+
+      using Slot = std::vector<Entry>;
+
+      const Clock::duration                       m_resolution;
+      const Clock::time_point                     m_start;
+      uint64_t                                    m_currentTick{0};
+      std::array<std::array<Slot, Slots>, Levels> m_levels;
+
+      // Latest deadline of each armed id - wheel entries that don't match are stale and skipped
+      std::unordered_map<jude_id_t, uint64_t>     m_deadlines;
+
+      uint64_t ToTicks(Clock::time_point time, bool roundUp) const;
+      void Insert(const Entry& entry);
+
+   public:
+      explicit ExpiryWheel(Clock::duration resolution, Clock::time_point start = Clock::now())
+         : m_resolution(resolution)
+         , m_start(start)
+      {}
+
+      size_t Size() const { return m_deadlines.size(); }
+      bool IsArmed(jude_id_t id) const { return m_deadlines.count(id) != 0; }
+
+      void Arm(jude_id_t id, Clock::time_point expiry); // replaces any earlier expiry of the id
+      void Cancel(jude_id_t id);
+
+      // Moves the wheel on to now, appending the ids that have expired. Expired ids are no longer armed.
+      void Advance(Clock::time_point now, std::vector<jude_id_t>& expired);
+   };
+}
@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <atomic>
+
+#include <jude/jude_core.h>
+
+namespace jude
+{
+   enum class IdPolicy
+   {
+      Uuid,       // jude_generate_uuid() - the default. Sequential instead when Options::GenerateIDsBAsedOnCollectionSize is set
+      Sequential, // one shared atomic counter
+      Blocks,     // each thread takes a block of sequential ids at a time so posting threads don't share a cache line
+      Random      // random ids from a per-thread generator - ids don't give away how many objects there are
+   };
+
+   // Hands out ids for new objects in a collection without taking a lock. Sequential and block ids are never handed out
+   // twice and skip past ids the collection has been given explicitly (see Observe()) until the counter wraps around the
+   // jude_id_t range. Uuid and random ids, block ids reserved before an explicit id was used and sequential ids after
+   // wrapping can collide with stored objects, so the collection checks those first.
+   class IdAllocator
+   {
+      IdPolicy               m_policy;
+      size_t                 m_blockSize;
+      std::atomic<uint64_t>  m_next{1};
+      std::atomic<bool>      m_wrapped{false}; // sequential ids have gone past the end of the jude_id_t range
+      const uint64_t         m_serial; // identifies our per-thread blocks - never reused unlike our address
+
+      IdPolicy ActivePolicy() const;
+
+   public:
+      static constexpr size_t DefaultBlockSize = 64;
+
+      IdAllocator();
+
+      IdPolicy GetPolicy() const { return m_policy; }
+      bool CanCollide() const; // sequential ids only can once the counter has wrapped around the jude_id_t range
+
+      // Not thread safe - choose the policy before posting. Sequential ids start after firstUnusedId - 1.
+      void SetPolicy(IdPolicy policy, jude_id_t firstUnusedId, size_t blockSize = DefaultBlockSize);
+
+      jude_id_t Next();
+      void Observe(jude_id_t id); // an id now in use - sequential ids will carry on after it
+   };
+}
@@ -0,0 +1,118 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+#include <jude/core/cpp/Object.h>
+
+namespace jude
+{
+   enum class StoragePolicy
+   {
+      Ordered, // std::map keyed by id (default)
+      Hashed,  // open addressing hash table keyed by id - ordered id index is only built when needed
+      Tiered   // least recently used objects are spilled to disk - see CollectionBase::EnableSpillToDisk()
+   };
+
+   // Storage for the objects held in a collection.
+   // Not thread safe - the collection lock must be held: shared for const methods, exclusive otherwise.
+   // Stored objects never move so pointers remain valid until the object is erased.
+   class ObjectStore
+   {
+   public:
+      using Visitor = std::function<bool(const Object&)>; // return false to stop visiting
+
+      static std::unique_ptr<ObjectStore> Create(StoragePolicy policy); // in memory policies only
+
+      virtual ~ObjectStore() = default;
+
+      virtual StoragePolicy GetPolicy() const = 0;
+
+      virtual Object*       Find(jude_id_t id) = 0;
+      virtual const Object* Find(jude_id_t id) const = 0;
+      virtual bool          Contains(jude_id_t id) const { return Find(id) != nullptr; }
+      virtual Object&       Insert(jude_id_t id) = 0; // returns existing object if id is already in the store
+      virtual bool          Erase(jude_id_t id) = 0;
+      virtual size_t        Size() const = 0;
+
+      // Ordered access - returns the first id after the given id (or the first id if JUDE_INVALID_ID)
+      virtual jude_id_t     NextId(jude_id_t id) const = 0;
+      virtual void          ForEach(const Visitor& visitor, jude_id_t after = JUDE_INVALID_ID) const = 0; // in id order, starting after the given id
+   };
+
+   class OrderedObjectStore : public ObjectStore
+   {
+      std::map<jude_id_t, Object> m_objects;
+
+   public:
+      StoragePolicy GetPolicy() const override { return StoragePolicy::Ordered; }
+
+      Object*       Find(jude_id_t id) override;
+      const Object* Find(jude_id_t id) const override;
+      Object&       Insert(jude_id_t id) override;
+      bool          Erase(jude_id_t id) override;
+      size_t        Size() const override { return m_objects.size(); }
+      jude_id_t     NextId(jude_id_t id) const override;
+      void          ForEach(const Visitor& visitor, jude_id_t after = JUDE_INVALID_ID) const override;
+   };
+
+   class HashedObjectStore : public ObjectStore
+   {
+      static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+      struct Slot
+      {
+         jude_id_t id;
+         uint32_t  entry; // index into m_entries or EmptySlot
+      };
+
+      std::vector<Slot>     m_slots;      // power of two sized, linear probing
+      std::deque<Object>    m_entries;    // deque so stored objects never move
+      std::vector<uint32_t> m_freeEntries;
+      size_t                m_size{0};
+
+      std::vector<jude_id_t> m_orderedIds; // sorted - kept up to date by Insert() and Erase()
+
+      size_t SlotFor(jude_id_t id) const;
+      size_t FindSlot(jude_id_t id) const;
+      void   Grow();
+
+   public:
+      StoragePolicy GetPolicy() const override { return StoragePolicy::Hashed; }
+
+      Object*       Find(jude_id_t id) override;
+      const Object* Find(jude_id_t id) const override;
+      Object&       Insert(jude_id_t id) override;
+      bool          Erase(jude_id_t id) override;
+      size_t        Size() const override { return m_size; }
+      jude_id_t     NextId(jude_id_t id) const override;
+      void          ForEach(const Visitor& visitor, jude_id_t after = JUDE_INVALID_ID) const override;
+   };
+}
@@ -0,0 +1,74 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <jude/core/cpp/Object.h>
+
+namespace jude
+{
+   // Ordered index of one numeric or string field of the objects in a collection: (field value, id) in ascending order.
+   // Objects without the field set are left out. Maintained by the collection as changes are published - not thread safe on its own.
+   class OrderedIndex
+   {
+   public:
+      // Where a walk through the index has got to
+      struct Cursor
+      {
+         bool        started{false};
+         std::string key;
+         jude_id_t   id{0};
+      };
+
+   private:
+      const jude_field_t&                                 m_field;
+      std::set<std::pair<std::string, jude_id_t>>         m_order;
+      std::unordered_map<jude_id_t, std::string>          m_keyById;
+
+   public:
+      explicit OrderedIndex(const jude_field_t& field)
+         : m_field(field)
+      {}
+
+      static bool CanOrder(const jude_field_t& field);
+
+      // Encodes the field value so that keys compare (as strings) in the same order as the values - false if unset
+      static bool ReadKey(const jude_field_t& field, const Object& object, std::string& key);
+
+      const jude_field_t& Field() const { return m_field; }
+      size_t Size() const { return m_keyById.size(); }
+
+      void Update(const Object& object);  // add or re-order the object
+      void Remove(jude_id_t id);
+
+      // Appends up to count ids following the cursor, moving the cursor on - false at the end.
+      // Ties are in id order, so a descending walk gives them highest id first.
+      bool Next(std::vector<jude_id_t>& ids, size_t count, bool descending, Cursor& cursor) const;
+   };
+}
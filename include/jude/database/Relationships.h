@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
 #include <jude/database/Database.h>
 #include <jude/database/Collection.h>
 
@@ -7,8 +9,6 @@ namespace jude {
    
    class Relationships
    {
-      std::vector<SubscriptionHandle> m_subscribers;
-
    public:
       struct ReferenceId // a "path" to a reference ID in a collection
       {
@@ -17,6 +17,35 @@ namespace jude {
          jude_index_t fieldIndex;
       };
 
+      // Reverse index of a reference field: target id -> the objects that refer to it, so handling a deleted target
+      // or checking for duplicate references only visits the objects involved. Kept up to date by a subscription
+      // to the referencing collection.
+      class ReferenceIndex
+      {
+         mutable std::mutex                                                     m_mutex;
+         std::unordered_map<jude_id_t, std::unordered_map<jude_id_t, size_t>>   m_referrers; // target -> referrer -> slots
+         std::unordered_map<jude_id_t, std::vector<jude_id_t>>                  m_targetsOf;
+
+         void RemoveLocked(jude_id_t referrerId);
+
+      public:
+         const ReferenceId reference;
+
+         explicit ReferenceIndex(ReferenceId ref) : reference(ref) {}
+
+         void Update(const Object& referrer);
+         void Remove(jude_id_t referrerId);
+         std::vector<jude_id_t> ReferrersOf(jude_id_t targetId) const; // ascending ids
+      };
+
+   private:
+      std::vector<SubscriptionHandle> m_subscribers;
+      std::vector<std::shared_ptr<ReferenceIndex>> m_referenceIndexes;
+
+      std::shared_ptr<ReferenceIndex> IndexOf(ReferenceId reference); // shared by every relationship using the reference
+
+   public:
+
       ~Relationships()
       {
          ClearAll();
@@ -28,6 +57,7 @@ namespace jude {
          {
             handle.Unsubscribe();
          }
+         m_referenceIndexes.clear();
       }
 
       // Use this relationship to keep common id's from two collections in sync
@@ -40,8 +70,8 @@ namespace jude {
       // Use this relationship enforce a many to one relationship with these two features:
       // 1. The referenceCollectonReferenceId will be validated against changes to ensure each element points to 
       //    a valid entry in the target collection
-      // 2. When an entry in the target collection is deleted, the reference paths are scanned and 
-      //    scrubbed of any references to the deleted resource.
+      // 2. When an entry in the target collection is deleted, the reference paths of the objects that refer to it
+      //    are scrubbed of any references to the deleted resource.
       // 3. If allowDuplicatesInReference is false then we must ensure that no two elements in 
       //    the given reference paths refer to the same element in the target collection
       void EnforceReference(ReferenceId from, jude::CollectionBase& to);
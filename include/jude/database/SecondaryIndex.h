@@ -0,0 +1,56 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <jude/core/cpp/Object.h>
+
+namespace jude
+{
+   // Hash index of one field of the objects in a collection: field value (as a string) -> ids.
+   // Maintained by the collection as changes are published - not thread safe on its own.
+   class SecondaryIndex
+   {
+      const jude_field_t& m_field;
+      std::unordered_map<std::string, std::vector<jude_id_t>> m_idsByValue;
+      std::unordered_map<jude_id_t, std::string>              m_valueById;
+
+   public:
+      explicit SecondaryIndex(const jude_field_t& field)
+         : m_field(field)
+      {}
+
+      const jude_field_t& Field() const { return m_field; }
+      size_t Size() const { return m_valueById.size(); }
+
+      void Update(const Object& object);  // add or re-index the object
+      void Remove(jude_id_t id);
+
+      // All ids with this value in ascending order
+      const std::vector<jude_id_t>* Find(const std::string& value) const;
+   };
+}
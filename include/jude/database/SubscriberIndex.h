@@ -0,0 +1,65 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <jude/jude_core.h>
+#include <jude/core/cpp/FieldMask.h>
+
+namespace jude
+{
+   // Finds the subscribers interested in a change without visiting every subscriber. Subscribers to a single id are
+   // listed under that id. Subscribers to the whole collection each get a slot, and each field keeps a bitmap of the
+   // slots whose filter includes it. Maintained under the collection's mutex - not thread safe on its own.
+   class SubscriberIndex
+   {
+      struct Entry
+      {
+         jude_id_t id;
+         FieldMask filter;
+         size_t    slot; // wildcard subscribers only
+      };
+
+      std::unordered_map<uint32_t, Entry>                   m_entries;
+      std::unordered_map<jude_id_t, std::vector<uint32_t>>  m_byId;
+      std::vector<uint32_t>                                 m_slots;        // wildcard subscriber in each slot
+      std::vector<size_t>                                   m_freeSlots;
+      std::vector<uint64_t>                                 m_fieldBitmaps[JUDE_MAX_FIELDS_PER_MESSAGE];
+
+   public:
+      size_t Size() const { return m_entries.size(); }
+
+      void Add(uint32_t subscriberId, jude_id_t id, const FieldMask& filter); // id is JUDE_AUTO_ID for all objects
+      void Remove(uint32_t subscriberId);
+      void Clear();
+
+      // Appends the subscribers to "id" (or to all objects) whose filter overlaps the changed fields, in the order they
+      // subscribed. "changes" is a change mask as given by Notification::GetChangeMask().
+      void FindInterested(jude_id_t id, const FieldMask& changes, std::vector<uint32_t>& subscriberIds) const;
+      bool AnyInterested(jude_id_t id, const FieldMask& changes) const;
+   };
+}
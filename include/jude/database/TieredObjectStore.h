@@ -0,0 +1,121 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+
+#include <jude/database/ObjectStore.h>
+
+namespace jude
+{
+   // Keeps at most maxResident objects in memory. The least recently used objects are serialised to a spill file
+   // by Evict() and read back in when next found, so pointers to a stored object are only stable while it is in use.
+   // Find() may load objects under the shared collection lock, hence the store's own mutex.
+   class TieredObjectStore : public ObjectStore
+   {
+   public:
+      // The store doesn't know the stored type - the collection supplies how to convert its objects
+      struct Codec
+      {
+         std::function<bool(const Object& object, std::string& bytes)>                        encode;
+         std::function<Object(jude_id_t id, uint64_t version, const std::string& bytes)>      decode; // gives a plain copy
+         std::function<Object(Object& object, jude_id_t id)>                                  adopt;  // makes a decoded copy the stored object
+      };
+
+      struct Stats
+      {
+         size_t   residentObjects{0};
+         size_t   spilledObjects{0};
+         uint64_t hits{0};         // finds of objects already in memory
+         uint64_t misses{0};       // finds that read the object back from the spill file
+         uint64_t evictions{0};
+         uint64_t readErrors{0};   // spilled objects that couldn't be read back - finds return null and scans skip them
+         uint64_t bytesSpilled{0}; // total written to the spill file
+         uint64_t fileBytes{0};    // current size of the spill file, including space no longer in use
+
+         double HitRate() const { return (hits + misses) == 0 ? 1.0 : double(hits) / double(hits + misses); }
+      };
+
+   private:
+      // Compaction rewrites the spill file once more than half of it is unused and it is bigger than this
+      static constexpr uint64_t MinimumCompactionBytes = 64 * 1024;
+
+      struct Entry
+      {
+         Object   object;      // null while the object is only held in the spill file
+         uint64_t version{0};  // version of the copy in the spill file
+         uint64_t offset{0};
+         uint32_t length{0};   // zero if there is no copy in the spill file
+         std::list<jude_id_t>::iterator recent; // position in m_recent while resident
+      };
+
+      const Codec       m_codec;
+      const std::string m_path;
+      const size_t      m_maxResident;
+
+      mutable std::mutex                 m_mutex;
+      mutable std::map<jude_id_t, Entry> m_entries; // only inserted into or erased from under the exclusive collection lock
+      mutable std::list<jude_id_t>       m_recent;  // resident ids, most recently used first
+      mutable std::fstream               m_file;
+      uint64_t                           m_unusedBytes{0};
+      mutable Stats                      m_stats;
+
+      bool    ReadBytes(const Entry& entry, std::string& bytes) const; // call with m_mutex held
+      Object* Load(jude_id_t id, Entry& entry) const;                  // call with m_mutex held - null if the spilled copy can't be read
+      void    Compact();                                               // call with m_mutex held
+
+   public:
+      TieredObjectStore(Codec codec, std::string path, size_t maxResident);
+      ~TieredObjectStore();
+
+      bool IsOpen() const { return m_file.is_open(); }
+
+      StoragePolicy GetPolicy() const override { return StoragePolicy::Tiered; }
+
+      Object*       Find(jude_id_t id) override;
+      const Object* Find(jude_id_t id) const override;
+      bool          Contains(jude_id_t id) const override { return m_entries.count(id) != 0; } // never loads
+      Object&       Insert(jude_id_t id) override;
+      bool          Erase(jude_id_t id) override;
+      size_t        Size() const override { return m_entries.size(); }
+      jude_id_t     NextId(jude_id_t id) const override;
+      void          ForEach(const Visitor& visitor, jude_id_t after = JUDE_INVALID_ID) const override; // spilled objects are visited as copies
+
+      bool NeedsEviction() const;
+      std::vector<jude_id_t> EvictionCandidates() const; // least recently used first
+
+      // Writes the object to the spill file (unless an unchanged copy is already there) and releases it from memory.
+      // Call with the collection lock held exclusively and the object lock held - objects still referenced are kept.
+      bool Evict(jude_id_t id);
+
+      Stats GetStats() const;
+   };
+}
@@ -45,6 +45,8 @@ namespace jude
       TransactionCompleteFn m_onTransactionComplete;
       std::string           m_error;
       T_Object              m_object;
+      const Object*         m_original{nullptr}; // only for delta transactions
+      std::function<void()> m_afterUnlock;
 
       void CommitOnDestructor()
       {
@@ -63,8 +65,8 @@ namespace jude
 
    public:
       Transaction(std::string m_error)
-         : m_object(nullptr)
-         , m_error(m_error)
+         : m_error(m_error)
+         , m_object(nullptr)
       {}
 
       Transaction(std::nullptr_t)
@@ -73,15 +75,33 @@ namespace jude
 
       Transaction(std::unique_lock<jude::Mutex>&& lock, const Object& object, TransactionCompleteFn onTransactionComplete)
          : m_lock(std::move(lock))
+         , m_onTransactionComplete(onTransactionComplete)
          , m_object(object.Clone(false).template As<T_Object>())
+      {} 
+
+      // Takes ownership of an object that is not shared with anyone else (e.g. a new object) without copying it
+      Transaction(std::unique_lock<jude::Mutex>&& lock, Object&& object, TransactionCompleteFn onTransactionComplete)
+         : m_lock(std::move(lock))
+         , m_onTransactionComplete(onTransactionComplete)
+         , m_object(object.template As<T_Object>())
+      {} 
+
+      // Delta transaction - edits are made to an empty object and only the changed fields are applied to the original on commit.
+      // The original stays readable (but must not be edited) while the lock is held.
+      Transaction(std::unique_lock<jude::Mutex>&& lock, Object&& delta, const Object& original, TransactionCompleteFn onTransactionComplete)
+         : m_lock(std::move(lock))
          , m_onTransactionComplete(onTransactionComplete)
+         , m_object(delta.template As<T_Object>())
+         , m_original(&original)
       {} 
 
       Transaction(Transaction&& rhs)
          : m_lock(std::move(rhs.m_lock))
-         , m_object(std::move(rhs.m_object))
-         , m_error(std::move(rhs.m_error))
          , m_onTransactionComplete(std::move(rhs.m_onTransactionComplete))
+         , m_error(std::move(rhs.m_error))
+         , m_object(std::move(rhs.m_object))
+         , m_original(rhs.m_original)
+         , m_afterUnlock(std::move(rhs.m_afterUnlock))
       {}
 
       ~Transaction()
@@ -96,6 +116,10 @@ namespace jude
       const std::string& GetError() { return m_error; }
       const char * GetErrorMessage() { return m_error.c_str(); }
 
+      bool IsDelta() const { return m_original != nullptr; }
+      // The object as it was before this transaction - only available for delta transactions
+      const Object& Original() const { jude_assert(IsDelta()); return *m_original; }
+
       
       T_Object* get() { return &m_object; } // do your own assertion
       const T_Object* get() const { return &m_object; } // do your own assertion
@@ -113,11 +137,24 @@ namespace jude
             auto result = m_onTransactionComplete(m_object, m_needsCommit);
             m_needsCommit = false; // prevent double commit
             m_object = nullptr; // destroy the object
+
+            if (m_afterUnlock)
+            {
+               // Nothing is left to protect once the object is gone
+               if (m_lock.owns_lock())
+               {
+                  m_lock.unlock();
+               }
+               m_afterUnlock();
+            }
             return result;
          }
          return jude_rest_OK;
       }
 
+      // Called once the transaction has completed and released its lock
+      void AfterUnlock(std::function<void()> afterUnlock) { m_afterUnlock = std::move(afterUnlock); }
+
       void Abort()
       {
          // we can't commit if we remove the commit function
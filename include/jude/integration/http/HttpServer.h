@@ -124,6 +124,62 @@ namespace jude
          return responseContent;
       }
 
+      // ETags are the quoted version of what is at the path - empty when the path is not versioned
+      std::string GetETag(const std::string& path)
+      {
+         uint64_t version;
+         if (!m_database.RestGetVersion(path.c_str(), version, m_accessLevel))
+         {
+            return "";
+         }
+         return "\"" + std::to_string(version) + "\"";
+      }
+
+      static std::string VersionFromETag(std::string etag)
+      {
+         etag.erase(0, etag.find_first_not_of(" \t"));
+         etag.erase(etag.find_last_not_of(" \t") + 1);
+         if (etag.compare(0, 2, "W/") == 0)
+         {
+            etag.erase(0, 2);
+         }
+         if (etag.length() >= 2 && etag.front() == '"' && etag.back() == '"')
+         {
+            etag = etag.substr(1, etag.length() - 2);
+         }
+         return etag;
+      }
+
+      // If-Match and If-None-Match hold "*" or a comma separated list of ETags - each is compared whole
+      static bool ETagMatches(const std::string& header, const std::string& etag)
+      {
+         if (VersionFromETag(header) == "*")
+         {
+            return true;
+         }
+         if (etag.empty())
+         {
+            return false;
+         }
+
+         auto version = VersionFromETag(etag);
+         size_t start = 0;
+         while (start <= header.length())
+         {
+            auto end = header.find(',', start);
+            if (end == std::string::npos)
+            {
+               end = header.length();
+            }
+            if (VersionFromETag(header.substr(start, end - start)) == version)
+            {
+               return true;
+            }
+            start = end + 1;
+         }
+         return false;
+      }
+
    public:
       HttpServer(jude::Database &db, RestApiSecurityLevel::Value accessLevel)
          : m_database(db)
@@ -167,7 +223,27 @@ namespace jude
             }
             else
             {
-               auto result = m_database.RestGet(req.path.c_str(), output, m_accessLevel);
+               // Pass the query on to the database e.g. for collection paging with "?after=<id>&limit=<n>"
+               auto path = req.path;
+               auto query = req.target.find('?');
+               if (query != std::string::npos)
+               {
+                  path += req.target.substr(query);
+               }
+
+               // Pollers can send back the ETag they were given and skip the download if nothing has changed
+               auto etag = GetETag(path);
+               if (!etag.empty())
+               {
+                  res.set_header("ETag", etag);
+                  if (ETagMatches(req.get_header_value("If-None-Match"), etag))
+                  {
+                     res.status = jude_rest_Not_Modified;
+                     return;
+                  }
+               }
+
+               auto result = m_database.RestGet(path.c_str(), output, m_accessLevel);
                res.status = result.GetCode();
                if (result)
                {
@@ -206,12 +282,30 @@ namespace jude
             // Read body
             auto body = ReadContent(content_reader);
             jude::RomInputStream input(body.GetString().c_str());
-            auto result = m_database.RestPatch(req.path.c_str(), input, m_accessLevel);
+
+            // "If-Match" makes the patch conditional on the object still being at one of the versions listed
+            auto path = req.path;
+            auto ifMatch = req.get_header_value("If-Match");
+            if (!ifMatch.empty() && VersionFromETag(ifMatch) != "*")
+            {
+               auto etag = GetETag(req.path);
+               if (!ETagMatches(ifMatch, etag))
+               {
+                  res.status = jude_rest_Precondition_Failed;
+                  res.set_content("Object is not at any of the versions in If-Match", "text/plain");
+                  return;
+               }
+               // The collection checks the version again as it applies the patch in case it changes in between
+               path += "?ifVersion=" + VersionFromETag(etag);
+            }
+
+            auto result = m_database.RestPatch(path.c_str(), input, m_accessLevel);
             res.status = result.GetCode();
             if (result)
             {
                std::stringstream output;
                m_database.RestGet(req.path.c_str(), output, m_accessLevel);
+               res.set_header("ETag", GetETag(req.path));
                res.set_content(output.GetString(), "application/json");
             }
             else
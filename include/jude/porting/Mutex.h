@@ -30,7 +30,16 @@ namespace jude
 {
    class Mutex
    {
-      jude_mutex_t* m_impl;
+   public:
+      enum class Mode
+      {
+         Exclusive,   // every lock is exclusive (default)
+         ReaderWriter // lock_shared() allows concurrent readers - falls back to Exclusive if the port has no rwlock
+      };
+
+   private:
+      jude_mutex_t*  m_impl{ nullptr };
+      jude_rwlock_t* m_rwImpl{ nullptr };
       int m_lockDepth{ 0 };
       char holdingThread[16];
 
@@ -39,24 +48,58 @@ namespace jude
       Mutex& operator=(const Mutex&) = delete;
 
    public:
-      Mutex()
+      explicit Mutex(Mode mode = Mode::Exclusive)
       {
          holdingThread[0] = '\0';
-         m_impl = jude_os->mutex_create();
+         if (mode == Mode::ReaderWriter && jude_os->rwlock_create)
+         {
+            m_rwImpl = jude_os->rwlock_create();
+         }
+         if (m_rwImpl == nullptr)
+         {
+            m_impl = jude_os->mutex_create();
+         }
       }
 
       ~Mutex()
       {
-         jude_os->mutex_destroy(m_impl);
+         if (m_rwImpl)
+         {
+            jude_os->rwlock_destroy(m_rwImpl);
+         }
+         else
+         {
+            jude_os->mutex_destroy(m_impl);
+         }
       }
 
       // for BasicLockable interface
       void lock() 
       { 
-         jude_os->mutex_lock(m_impl, -1); 
+         if (m_rwImpl)
+         {
+            if (!jude_os->rwlock_lock(m_rwImpl, -1))
+            {
+               jude_fatal("Attempt to upgrade a shared lock to an exclusive lock");
+            }
+         }
+         else
+         {
+            jude_os->mutex_lock(m_impl, -1); 
+         }
          m_lockDepth++;
       }
 
+      bool try_lock()
+      {
+         bool locked = m_rwImpl ? jude_os->rwlock_lock(m_rwImpl, 0) : jude_os->mutex_lock(m_impl, 0);
+         if (locked)
+         {
+            m_lockDepth++;
+         }
+         return locked;
+      }
+
       void unlock() 
       { 
          if (m_lockDepth <= 0)
@@ -64,9 +107,42 @@ namespace jude
             jude_fatal("Attmpt to unlock mutex that is not locked");
          }
          m_lockDepth--;
-         jude_os->mutex_unlock(m_impl);
+         if (m_rwImpl)
+         {
+            jude_os->rwlock_unlock(m_rwImpl);
+         }
+         else
+         {
+            jude_os->mutex_unlock(m_impl);
+         }
+      }
+
+      // for SharedLockable interface (e.g. std::shared_lock) - readers do not change the lock depth
+      void lock_shared()
+      {
+         if (m_rwImpl)
+         {
+            jude_os->rwlock_lock_shared(m_rwImpl, -1);
+         }
+         else
+         {
+            lock();
+         }
+      }
+
+      void unlock_shared()
+      {
+         if (m_rwImpl)
+         {
+            jude_os->rwlock_unlock_shared(m_rwImpl);
+         }
+         else
+         {
+            unlock();
+         }
       }
 
+      bool IsReaderWriter() const { return m_rwImpl != nullptr; }
       auto GetLockDepth() const { return m_lockDepth; }
    };
 }
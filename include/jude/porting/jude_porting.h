@@ -38,6 +38,7 @@ extern "C" {
 typedef struct jude_mutex_t jude_mutex_t;
 typedef struct jude_semaphore_t jude_semaphore_t;
 typedef struct jude_queue_t jude_queue_t;
+typedef struct jude_rwlock_t jude_rwlock_t;
 
 // mockable OS interface for jude
 typedef struct
@@ -59,9 +60,17 @@ typedef struct
    // queues
    jude_queue_t *(*queue_create)(size_t maxElements, size_t elementSize);
    void (*queue_destroy)(jude_queue_t *);
-   void (*queue_send)(jude_queue_t *queue, const void *element); // a copy of element is made
+   bool (*queue_send)(jude_queue_t *queue, const void *element); // a copy of element is made - false if the queue is full
    bool (*queue_receive)(jude_queue_t *queue, void *buffer, uint32_t milliseconds);
 
+   // reader/writer locks (optional - leave as NULL and jude will fall back to the exclusive mutex)
+   jude_rwlock_t* (*rwlock_create)();
+   void (*rwlock_destroy)(jude_rwlock_t *);
+   bool (*rwlock_lock)(jude_rwlock_t *, uint32_t milliseconds);        // exclusive access
+   void (*rwlock_unlock)(jude_rwlock_t *);
+   bool (*rwlock_lock_shared)(jude_rwlock_t *, uint32_t milliseconds); // shared access
+   void (*rwlock_unlock_shared)(jude_rwlock_t *);
+
 } jude_os_interface_t;
 
 extern jude_os_interface_t *jude_os;
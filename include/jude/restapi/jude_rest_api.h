@@ -37,6 +37,7 @@ typedef enum
    jude_rest_OK                    = 200,
    jude_rest_Created               = 201, // result of POST
    jude_rest_No_Content            = 204, // result of PATCH to write-only
+   jude_rest_Not_Modified          = 304, // result of conditional GET when the version is unchanged
 
    jude_rest_Bad_Request           = 400,
    jude_rest_Unauthorized          = 401,
@@ -44,6 +45,7 @@ typedef enum
    jude_rest_Not_Found             = 404,
    jude_rest_Method_Not_Allowed    = 405,
    jude_rest_Conflict              = 409,
+   jude_rest_Precondition_Failed   = 412, // result of conditional PATCH when the version has moved on
 
    jude_rest_Internal_Server_Error = 500
 } jude_restapi_code_t;
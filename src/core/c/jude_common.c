@@ -48,7 +48,7 @@ static jude_id_t default_uuid_generator(void *user_data)
 
    // 40 bits of unixtime  (seconds since 1970)
    // 24 bits of counter   (up to 16 million new UUID's per second)
-   return (jude_id_t)((now & 0xFFFFF) << 24) + (mycounter & 0xFFF);
+   return (jude_id_t)((now & 0xFFFFF) << 24) + (mycounter & 0xFFFFFF);
 #else 
    return mycounter;
 #endif
@@ -35,11 +35,21 @@ void jude_notification_queue_destroy(jude_notification_queue_t* queue)
    jude_os->queue_destroy((jude_queue_t*)queue);
 }
 
-void jude_notification_queue_post(jude_notification_queue_t* queue, const jude_notification_t* notification)
+bool jude_notification_queue_post(jude_notification_queue_t* queue, const jude_notification_t* notification)
 {
    jude_assert(queue);
    jude_assert(notification);
-   jude_os->queue_send((jude_queue_t*)queue, notification);
+   return jude_os->queue_send((jude_queue_t*)queue, notification);
+}
+
+bool jude_notification_queue_receive(jude_notification_queue_t* queue, jude_notification_t* notification, uint32_t max_wait_ms)
+{
+   if (!queue)
+   {
+      return false;
+   }
+   jude_assert(notification);
+   return jude_os->queue_receive((jude_queue_t*)queue, notification, max_wait_ms);
 }
 
 bool jude_notification_queue_process(jude_notification_queue_t* queue, uint32_t max_wait_ms)
@@ -174,7 +174,7 @@ namespace jude
       return filter;
    }
 
-   FieldMask ForFields(const jude_rtti_t& type, std::vector<std::string> fieldNames, bool deltasOnly)
+   FieldMask FieldMask::ForFields(const jude_rtti_t& type, std::vector<std::string> fieldNames, bool deltasOnly)
    {
       FieldMask filter;
 
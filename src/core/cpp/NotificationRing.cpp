@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/core/cpp/NotificationRing.h>
+
+namespace
+{
+   size_t RoundUpToPowerOfTwo(size_t value)
+   {
+      size_t result = 1;
+      while (result < value)
+      {
+         result <<= 1;
+      }
+      return result;
+   }
+}
+
+namespace jude
+{
+   // Each slot's sequence says whose turn it is: equal to the position when free for the producer that claims that
+   // position, and position + 1 once the callback is there for the consumer (see Dmitry Vyukov's bounded queue).
+   NotificationRing::NotificationRing(size_t capacity)
+      : m_slots(new Slot[RoundUpToPowerOfTwo(capacity ? capacity : 1)])
+      , m_mask(RoundUpToPowerOfTwo(capacity ? capacity : 1) - 1)
+      , m_wakeup(jude_os->semaphore_create(0, 1))
+   {
+      for (size_t position = 0; position <= m_mask; position++)
+      {
+         m_slots[position].sequence.store(position, std::memory_order_relaxed);
+      }
+   }
+
+   NotificationRing::~NotificationRing()
+   {
+      jude_os->semaphore_destroy(m_wakeup);
+   }
+
+   bool NotificationRing::Push(std::function<void()>&& callback)
+   {
+      auto position = m_tail.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         auto& slot = m_slots[position & m_mask];
+         auto sequence = slot.sequence.load(std::memory_order_acquire);
+         auto difference = (intptr_t)sequence - (intptr_t)position;
+
+         if (difference == 0)
+         {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+               slot.callback = std::move(callback);
+               slot.sequence.store(position + 1, std::memory_order_release);
+               break;
+            }
+         }
+         else if (difference < 0)
+         {
+            return false; // the consumer hasn't freed this slot yet
+         }
+         else
+         {
+            position = m_tail.load(std::memory_order_relaxed); // another producer got here first
+         }
+      }
+
+      // Pairs with the fence in Pop() - either the consumer sees our callback or we see that it is waiting
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_consumerWaiting.load(std::memory_order_relaxed) && m_consumerWaiting.exchange(false))
+      {
+         jude_os->semaphore_give(m_wakeup);
+      }
+      return true;
+   }
+
+   bool NotificationRing::TryPop(std::function<void()>& callback)
+   {
+      auto& slot = m_slots[m_head & m_mask];
+      if (slot.sequence.load(std::memory_order_acquire) != m_head + 1)
+      {
+         return false; // empty, or the producer of this slot hasn't finished yet
+      }
+
+      callback = std::move(slot.callback);
+      slot.callback = nullptr;
+      slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+      m_head++;
+      return true;
+   }
+
+   bool NotificationRing::Pop(std::function<void()>& callback, uint32_t maxWaitMs)
+   {
+      if (TryPop(callback))
+      {
+         return true;
+      }
+
+      if (maxWaitMs == 0)
+      {
+         return false;
+      }
+
+      m_consumerWaiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (!TryPop(callback))
+      {
+         jude_os->semaphore_take(m_wakeup, maxWaitMs);
+         m_consumerWaiting.store(false, std::memory_order_relaxed);
+         return TryPop(callback);
+      }
+
+      m_consumerWaiting.store(false, std::memory_order_relaxed);
+      return true;
+   }
+}
@@ -22,27 +22,118 @@
  */
 
 #include <jude/core/cpp/NotifyQueue.h>
+#include <chrono>
+#include <cstdio>
 
 namespace jude
 {
+   namespace
+   {
+      const char* OverflowName(NotifyQueue::Overflow overflow)
+      {
+         switch (overflow)
+         {
+         case NotifyQueue::Overflow::DropNewest: return "DropNewest";
+         case NotifyQueue::Overflow::DropOldest: return "DropOldest";
+         case NotifyQueue::Overflow::Block:      return "Block";
+         case NotifyQueue::Overflow::Coalesce:   return "Coalesce";
+         case NotifyQueue::Overflow::Reject:     return "Reject";
+         }
+         return "?";
+      }
+   }
+
    NotifyQueue::NotifyQueue(std::nullptr_t)
       : m_name("ImmediateQueue")
       , m_queue(nullptr)
    {
    }
          
-   NotifyQueue::NotifyQueue(const std::string& name, size_t maxDepth)
-      : m_name(name)
-      , m_queue(jude_notification_queue_create(maxDepth))
+   NotifyQueue::NotifyQueue(const std::string& name, size_t maxDepth, Type type)
+      : m_queue(nullptr)
    {
+      Open(name, maxDepth, type);
    }
 
    NotifyQueue::~NotifyQueue()
+   {
+      Close();
+   }
+
+   void NotifyQueue::Open(const std::string& name, size_t maxDepth, Type type)
+   {
+      m_name = name;
+      m_maxDepth = maxDepth;
+      m_maxOverflowBatch = maxDepth * 4;
+      m_queue = (type == Type::Ported) ? jude_notification_queue_create(maxDepth) : nullptr;
+      m_ring = (type == Type::LockFree) ? std::make_unique<NotificationRing>(maxDepth) : nullptr;
+      if (!IsImmediate())
+      {
+         m_spaceAvailable = jude_os->semaphore_create(0, 1);
+      }
+   }
+
+   void NotifyQueue::Close()
    {
       if (m_queue)
       {
+         // anything still pending will never be called but must still be freed
+         jude_notification_t notification;
+         while (jude_notification_queue_receive(m_queue, &notification, 0))
+         {
+            delete reinterpret_cast<std::function<void()>*>(notification.user_data);
+         }
          jude_notification_queue_destroy(m_queue);
+         m_queue = nullptr;
+      }
+      m_ring.reset();
+
+      if (m_spaceAvailable)
+      {
+         jude_os->semaphore_destroy(m_spaceAvailable);
+         m_spaceAvailable = nullptr;
+      }
+
+      std::lock_guard<std::mutex> lock(m_overflowMutex);
+      m_overflowBatch.clear();
+      m_hasOverflowBatch = false;
+      m_depth = 0;
+   }
+
+   void NotifyQueue::SetOverflowPolicy(Overflow policy, uint32_t blockTimeoutMs)
+   {
+      m_overflow = policy;
+      m_blockTimeoutMs = blockTimeoutMs;
+   }
+
+   NotifyQueue::Stats NotifyQueue::GetStats() const
+   {
+      Stats stats;
+      stats.sent = m_sent;
+      stats.processed = m_processed;
+      stats.dropped = m_dropped;
+      stats.blocked = m_blocked;
+      stats.rejected = m_rejected;
+      stats.coalesced = m_coalesced;
+      stats.depth = m_depth;
+      stats.highWaterMark = m_highWaterMark;
+      return stats;
+   }
+
+   std::string NotifyQueue::DebugInfo() const
+   {
+      if (IsImmediate())
+      {
+         return m_name + " (immediate)";
       }
+
+      auto stats = GetStats();
+      char tmp[256];
+      snprintf(tmp, sizeof(tmp), " (%s, %s): depth %zu/%zu, high water %zu, sent %zu, processed %zu, dropped %zu, blocked %zu, rejected %zu, coalesced %zu",
+               GetType() == Type::LockFree ? "LockFree" : "Ported", OverflowName(m_overflow),
+               stats.depth, m_maxDepth, stats.highWaterMark, stats.sent, stats.processed,
+               stats.dropped, stats.blocked, stats.rejected, stats.coalesced);
+      return m_name + tmp;
    }
 
    void NotifyQueue::Pause()
@@ -65,63 +156,335 @@ namespace jude
       m_paused = false;
    }
 
+   bool NotifyQueue::ReserveSlot()
+   {
+      auto depth = m_depth.load();
+      do
+      {
+         if (depth >= m_maxDepth)
+         {
+            return false;
+         }
+      } while (!m_depth.compare_exchange_weak(depth, depth + 1));
 
-   void NotifyQueue::Send(std::function<void()>&& callback)
+      auto highWater = m_highWaterMark.load(std::memory_order_relaxed);
+      while (depth + 1 > highWater && !m_highWaterMark.compare_exchange_weak(highWater, depth + 1, std::memory_order_relaxed))
+      {
+      }
+      return true;
+   }
+
+   void NotifyQueue::ReleaseSlot()
+   {
+      m_depth--;
+      if (m_blockedSenders > 0)
+      {
+         jude_os->semaphore_give(m_spaceAvailable);
+      }
+   }
+
+   bool NotifyQueue::WaitForSlot()
+   {
+      m_blocked++;
+      m_blockedSenders++;
+
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_blockTimeoutMs);
+      bool reserved;
+      while (!(reserved = ReserveSlot()))
+      {
+         uint32_t waitMs = JUDE_WAIT_FOREVER;
+         if (m_blockTimeoutMs != JUDE_WAIT_FOREVER)
+         {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+               break;
+            }
+            waitMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+         }
+         jude_os->semaphore_take(m_spaceAvailable, waitMs);
+      }
+
+      // pass the wake-up on in case there is room for another waiting sender
+      if (--m_blockedSenders > 0 && m_depth < m_maxDepth)
+      {
+         jude_os->semaphore_give(m_spaceAvailable);
+      }
+      return reserved;
+   }
+
+   bool NotifyQueue::DropOldest()
+   {
+      // The slot of the notification we take is handed straight to the new one
+      if (m_ring)
+      {
+         std::lock_guard<std::mutex> lock(m_consumerMutex);
+         std::function<void()> oldest;
+         if (m_ring->Pop(oldest, 0))
+         {
+            m_dropped++;
+            return true;
+         }
+      }
+      else
+      {
+         jude_notification_t oldest;
+         if (jude_notification_queue_receive(m_queue, &oldest, 0))
+         {
+            delete reinterpret_cast<std::function<void()>*>(oldest.user_data);
+            m_dropped++;
+            return true;
+         }
+      }
+
+      // the consumer emptied the queue in the meantime
+      return ReserveSlot();
+   }
+
+   bool NotifyQueue::Post(std::function<void()>&& callback)
+   {
+      if (m_ring)
+      {
+         if (m_ring->Push(std::move(callback)))
+         {
+            return true;
+         }
+      }
+      else
+      {
+         jude_notification_t notification;
+         auto func = new std::function<void()>(std::move(callback));
+         notification.user_data = func;
+         notification.callback = [](void* data)
+         {
+            auto func = reinterpret_cast<std::function<void()>*>(data);
+            (*func)();
+            delete func;
+         };
+         if (jude_notification_queue_post(m_queue, &notification))
+         {
+            return true;
+         }
+         delete func;
+      }
+
+      // only if the port's queue holds fewer than we asked for
+      m_depth--;
+      m_dropped++;
+      return false;
+   }
+
+   bool NotifyQueue::AddToOverflowBatch(std::function<void()>&& callback)
+   {
+      std::lock_guard<std::mutex> lock(m_overflowMutex);
+      if (m_overflowBatch.size() >= m_maxOverflowBatch)
+      {
+         // Callbacks can't be merged as we don't know what they are for, so the batch can only stop growing
+         m_dropped++;
+         return false;
+      }
+      m_overflowBatch.push_back(std::move(callback));
+      m_hasOverflowBatch = true;
+      m_coalesced++;
+      return true;
+   }
+
+   bool NotifyQueue::ProcessOverflowBatch()
+   {
+      std::vector<std::function<void()>> batch;
+      {
+         std::lock_guard<std::mutex> lock(m_overflowMutex);
+         batch.swap(m_overflowBatch);
+         m_hasOverflowBatch = false;
+      }
+
+      for (auto& callback : batch)
+      {
+         callback();
+      }
+      m_processed += batch.size();
+      return !batch.empty();
+   }
+
+   bool NotifyQueue::Send(std::function<void()>&& callback)
    {
       if (m_paused)
       {
          m_pausedNotifications.push_back(callback);
-         return;
+         return true;
       }
 
-      if (m_queue == nullptr)
+      if (IsImmediate())
       {
          callback(); // immediate
-         return;
+         return true;
+      }
+
+      m_sent++;
+
+      // Once there is an overflow batch everything joins it until it is processed so that order is kept
+      if (m_overflow == Overflow::Coalesce && m_hasOverflowBatch)
+      {
+         return AddToOverflowBatch(std::move(callback));
+      }
+
+      if (ReserveSlot())
+      {
+         return Post(std::move(callback));
+      }
+
+      switch (m_overflow)
+      {
+      case Overflow::DropOldest:
+         if (DropOldest())
+         {
+            return Post(std::move(callback));
+         }
+         break;
+
+      case Overflow::Block:
+         if (WaitForSlot())
+         {
+            return Post(std::move(callback));
+         }
+         break;
+
+      case Overflow::Coalesce:
+         return AddToOverflowBatch(std::move(callback));
+
+      case Overflow::Reject:
+         m_rejected++;
+         return false;
+
+      case Overflow::DropNewest:
+         break;
+      }
+
+      m_dropped++;
+      return false;
+   }
+
+   bool NotifyQueue::Receive(std::function<void()>& callback, uint32_t maxWaitMs)
+   {
+      if (m_ring)
+      {
+         if (m_overflow == Overflow::DropOldest)
+         {
+            std::lock_guard<std::mutex> lock(m_consumerMutex);
+            return m_ring->Pop(callback, maxWaitMs);
+         }
+         return m_ring->Pop(callback, maxWaitMs);
       }
 
       jude_notification_t notification;
-      notification.user_data = new std::function<void()>(std::move(callback));
-      notification.callback = [](void* data)
+      if (!jude_notification_queue_receive(m_queue, &notification, maxWaitMs))
       {
-         auto func = reinterpret_cast<std::function<void()>*>(data);
-         (*func)();
-         delete func;
-      };
-      jude_notification_queue_post(m_queue, &notification);
+         return false;
+      }
+      std::unique_ptr<std::function<void()>> func(reinterpret_cast<std::function<void()>*>(notification.user_data));
+      callback = std::move(*func);
+      return true;
    }
 
    bool NotifyQueue::Process(uint32_t maxWaitMs)
    {
-      if (m_queue)
+      if (IsImmediate())
       {
-         return jude_notification_queue_process(m_queue, maxWaitMs);
+         return false;
       }
-      return false;
+
+      // the overflow batch is only processed once the queue in front of it is empty
+      bool hasOverflowBatch = m_hasOverflowBatch;
+      std::function<void()> callback;
+      if (Receive(callback, hasOverflowBatch ? 0 : maxWaitMs))
+      {
+         ReleaseSlot();
+         callback();
+         m_processed++;
+         return true;
+      }
+
+      return hasOverflowBatch && ProcessOverflowBatch();
    }
 
-   NotifyQueue NotifyQueue::Immediate(nullptr);
-   NotifyQueue NotifyQueue::Default(nullptr); // default queue is immediate unless specified in SetDefaultQueue()
+   void NotificationBatch::Add(NotifyQueue& queue, std::function<void()>&& callback, std::function<void()>&& onDropped)
+   {
+      if (queue.IsImmediate())
+      {
+         m_immediate.push_back(std::move(callback));
+         return;
+      }
 
-   void NotifyQueue::SetDefaultQueue(const std::string& name, size_t maxDepth)
+      QueuedCallbacks* entry = nullptr;
+      for (auto& queued : m_queued)
+      {
+         if (queued.queue == &queue)
+         {
+            entry = &queued;
+            break;
+         }
+      }
+      if (!entry)
+      {
+         m_queued.push_back({ &queue, {}, {} });
+         entry = &m_queued.back();
+      }
+      entry->callbacks.push_back(std::move(callback));
+      if (onDropped)
+      {
+         entry->onDropped.push_back(std::move(onDropped));
+      }
+   }
+
+   void NotificationBatch::Publish()
    {
-      Default.m_name = name;
-      if (Default.m_queue)
+      for (auto& callback : m_immediate)
       {
-         jude_notification_queue_destroy(Default.m_queue);
+         callback();
       }
-      Default.m_queue = jude_notification_queue_create(maxDepth);
+      m_immediate.clear();
+
+      for (auto& entry : m_queued)
+      {
+         bool sent;
+         if (entry.callbacks.size() == 1)
+         {
+            sent = entry.queue->Send(std::move(entry.callbacks.front()));
+         }
+         else
+         {
+            sent = entry.queue->Send([callbacks = std::move(entry.callbacks)] {
+               for (auto& callback : callbacks)
+               {
+                  callback();
+               }
+            });
+         }
+
+         if (!sent)
+         {
+            for (auto& onDropped : entry.onDropped)
+            {
+               onDropped();
+            }
+         }
+      }
+      m_queued.clear();
+   }
+
+   NotifyQueue NotifyQueue::Immediate(nullptr);
+   NotifyQueue NotifyQueue::Default(nullptr); // default queue is immediate unless specified in SetDefaultQueue()
+
+   void NotifyQueue::SetDefaultQueue(const std::string& name, size_t maxDepth, Type type)
+   {
+      Default.Close();
+      Default.Open(name, maxDepth, type);
    }
 
    void NotifyQueue::SetDefaultQueueAsImmediate()
    {
+      Default.Close();
       Default.m_name = "Immediate";
-      if (Default.m_queue)
-      {
-         jude_notification_queue_destroy(Default.m_queue);
-      }
-      Default.m_queue = nullptr;
    }
 
 }
-
@@ -26,6 +26,7 @@
 #include <sstream>
 
 #include <jude/core/cpp/Object.h>
+#include <jude/core/cpp/ObjectPool.h>
 #include <jude/core/cpp/ObjectArray.h>
 #include <jude/core/cpp/Stream.h>
 #include <jude/restapi/jude_browser.h>
@@ -64,8 +65,84 @@ namespace
    }
 }
 
+namespace
+{
+   // Lets std::allocate_shared place the reference count, the SharedRootData and the object data in one pool block
+   struct PoolAllocation
+   {
+      jude::ObjectPool& pool;
+      void* block;
+   };
+
+   template<class T>
+   struct PoolAllocator
+   {
+      using value_type = T;
+
+      jude::ObjectPool* pool;
+      PoolAllocation*   allocation; // only valid during allocate_shared()
+
+      PoolAllocator(jude::ObjectPool* pool, PoolAllocation* allocation) : pool(pool), allocation(allocation) {}
+
+      template<class U>
+      PoolAllocator(const PoolAllocator<U>& rhs) : pool(rhs.pool), allocation(rhs.allocation) {}
+
+      T* allocate(size_t n)
+      {
+         jude_assert(n == 1);
+         allocation->block = pool->Allocate(sizeof(T) * n);
+         return static_cast<T*>(allocation->block);
+      }
+
+      void deallocate(T* block, size_t) { pool->Free(block); }
+
+      template<class U> bool operator==(const PoolAllocator<U>& rhs) const { return pool == rhs.pool; }
+      template<class U> bool operator!=(const PoolAllocator<U>& rhs) const { return pool != rhs.pool; }
+   };
+}
+
 namespace jude
 {
+   void Object::AllocateRoot(const jude_rtti_t& type)
+   {
+      jude_object_t* data;
+
+      if (Options::UseObjectPools)
+      {
+         auto& pool = ObjectPool::ForType(type);
+         PoolAllocation allocation{ pool, nullptr };
+
+         // The pool block holds the shared_ptr control block (with SharedRootData inside) followed by the object data
+         m_sharedRoot = std::allocate_shared<SharedRootData>(PoolAllocator<SharedRootData>(&pool, &allocation));
+         data = reinterpret_cast<jude_object_t*>(static_cast<char*>(allocation.block) + pool.DataOffset());
+         m_sharedRoot->object = data;
+      }
+      else
+      {
+         m_sharedRoot = std::make_shared<SharedRootData>();
+         m_sharedRoot->object = data = reinterpret_cast<jude_object_t*>(new char[type.data_size]);
+         m_sharedRoot->ownsObject = true;
+         ObjectPool::CountHeapAllocations(2);
+      }
+
+      memset(data, 0, type.data_size);
+      jude_object_set_rtti(data, &type);
+
+      m_object = data;
+   }
+
+   bool Object::AttachCallbacks(std::function<void()> onChange, std::function<void()> onSingleRef)
+   {
+      if (!m_sharedRoot || m_sharedRoot.use_count() != 1 || m_object != m_sharedRoot->object)
+      {
+         return false;
+      }
+
+      m_sharedRoot->onChange = std::move(onChange);
+      m_sharedRoot->onSingleRef = std::move(onSingleRef);
+      return true;
+   }
+
    // Used when creating a new root object
    Object::Object(const jude_rtti_t& type, 
                   std::function<void()> onChange,
@@ -73,15 +150,9 @@ namespace jude
    {
       if (&type != &null_rtti)
       {
-         m_sharedRoot = std::make_shared<SharedRootData>();
-         m_sharedRoot->object.reset((jude_object_t*)new char[type.data_size]);
+         AllocateRoot(type);
          m_sharedRoot->onChange = onChange;
          m_sharedRoot->onSingleRef = onSingleRef;
-
-         memset(m_sharedRoot->object.get(), 0, type.data_size);
-         jude_object_set_rtti(m_sharedRoot->object.get(), &type);
-
-         m_object = m_sharedRoot->object.get();
       }
    }
 
@@ -90,8 +161,8 @@ namespace jude
       : m_sharedRoot(relative.m_sharedRoot)
       , m_object(&child)
    {
-      jude_assert(m_object >= m_sharedRoot->object.get());
-      jude_assert(m_object < m_sharedRoot->object.get() + m_sharedRoot->object->__rtti->data_size);
+      jude_assert(m_object >= m_sharedRoot->object);
+      jude_assert(m_object < m_sharedRoot->object + m_sharedRoot->object->__rtti->data_size);
    }
 
    Object::Object() noexcept
@@ -144,10 +215,16 @@ namespace jude
    {
       if (  m_sharedRoot 
          && m_sharedRoot->onSingleRef 
-         && m_sharedRoot.use_count() == 2)
-      {
-         // We are about to get down to one remaining instance of the shared root object
-         m_sharedRoot->onSingleRef();
+         && m_sharedRoot.use_count() == 2
+         && m_sharedRoot->editLocked.exchange(false))
+      {
+         // We are about to get down to one remaining instance of the shared root object.
+         // The edit lock is cleared first so temporary copies made by the callback can't fire it again,
+         // and our reference is dropped *before* the callback so that any thread waiting on a lock
+         // released by the callback already sees a reference count of one.
+         auto onSingleRef = m_sharedRoot->onSingleRef;
+         m_sharedRoot.reset();
+         onSingleRef();
       }
    }
 
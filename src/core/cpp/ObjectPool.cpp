@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <jude/core/cpp/ObjectPool.h>
+#include <unordered_map>
+#include <cstddef>
+
+namespace
+{
+   constexpr size_t AlignUp(size_t size, size_t alignment = alignof(std::max_align_t))
+   {
+      return (size + alignment - 1) & ~(alignment - 1);
+   }
+
+   std::atomic<size_t> s_blocksInUse{0};
+   std::atomic<size_t> s_poolAllocations{0};
+   std::atomic<size_t> s_heapAllocations{0};
+
+   struct PoolRegistry
+   {
+      std::mutex mutex;
+      std::unordered_map<const jude_rtti_t*, jude::ObjectPool*> pools;
+   };
+
+   PoolRegistry& Registry()
+   {
+      // Deliberately never destroyed - objects in static storage may be released after static destructors have run
+      static auto registry = new PoolRegistry();
+      return *registry;
+   }
+}
+
+namespace jude
+{
+   ObjectPool::ObjectPool(size_t dataSize)
+      : m_dataSize(dataSize)
+   {}
+
+   ObjectPool& ObjectPool::ForType(const jude_rtti_t& type)
+   {
+      auto& registry = Registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+
+      auto& pool = registry.pools[&type];
+      if (pool == nullptr)
+      {
+         pool = new ObjectPool(type.data_size);
+      }
+      return *pool;
+   }
+
+   ObjectPool::Statistics ObjectPool::GetStatistics()
+   {
+      Statistics stats;
+      {
+         auto& registry = Registry();
+         std::lock_guard<std::mutex> lock(registry.mutex);
+         stats.pools = registry.pools.size();
+      }
+      stats.blocksInUse = s_blocksInUse;
+      stats.poolAllocations = s_poolAllocations;
+      stats.heapAllocations = s_heapAllocations;
+      return stats;
+   }
+
+   void ObjectPool::CountHeapAllocations(size_t count)
+   {
+      s_heapAllocations += count;
+   }
+
+   void* ObjectPool::Allocate(size_t headerSize)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_blockSize == 0)
+      {
+         // The header is the same type for every block so the layout is fixed on first use
+         m_dataOffset = AlignUp(headerSize);
+         m_blockSize = AlignUp(m_dataOffset + m_dataSize);
+      }
+      jude_assert(headerSize <= m_dataOffset);
+
+      if (m_freeList == nullptr)
+      {
+         m_chunks.emplace_back(new char[m_blockSize * BlocksPerChunk]);
+         s_heapAllocations++;
+
+         auto chunk = m_chunks.back().get();
+         for (size_t block = BlocksPerChunk; block > 0; block--)
+         {
+            auto freeBlock = chunk + (block - 1) * m_blockSize;
+            *reinterpret_cast<void**>(freeBlock) = m_freeList;
+            m_freeList = freeBlock;
+         }
+      }
+
+      auto block = m_freeList;
+      m_freeList = *reinterpret_cast<void**>(block);
+
+      s_blocksInUse++;
+      s_poolAllocations++;
+
+      return block;
+   }
+
+   void ObjectPool::Free(void* block)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      *reinterpret_cast<void**>(block) = m_freeList;
+      m_freeList = block;
+
+      s_blocksInUse--;
+   }
+}
@@ -41,6 +41,8 @@ namespace jude
 
       bool GenerateIDsBAsedOnCollectionSize = false;
 
+      bool UseObjectPools = true;
+
       // By default all code that does not explicitly specify an access level gets root access to the data
       // For a more security concious usage of this library, suggest using jude_user_Public here?
       RestApiSecurityLevel::Value DefaultAccessLevelForJSON = RestApiSecurityLevel::Root;
@@ -23,6 +23,9 @@
 
 #include <jude/core/cpp/RestApiInterface.h>
 #include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 
 namespace jude
 {
@@ -85,4 +88,57 @@ namespace jude
       }
       return token;
    }
+
+   std::map<std::string, std::string> RestApiInterface::GetUrlQuery(const char* urlPath)
+   {
+      std::map<std::string, std::string> query;
+
+      const char* start = urlPath ? strchr(urlPath, '?') : nullptr;
+      if (start == nullptr)
+      {
+         return query;
+      }
+
+      auto decode = [] (const char* text, size_t length) {
+         std::string decoded;
+         for (size_t i = 0; i < length; i++)
+         {
+            if (text[i] == '+')
+            {
+               decoded += ' ';
+            }
+            else if (text[i] == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2]))
+            {
+               decoded += (char)strtol(std::string(text + i + 1, 2).c_str(), nullptr, 16);
+               i += 2;
+            }
+            else
+            {
+               decoded += text[i];
+            }
+         }
+         return decoded;
+      };
+
+      while (*start)
+      {
+         start++; // skip '?' or '&'
+         auto end = strchr(start, '&');
+         auto length = end ? (size_t)(end - start) : strlen(start);
+         if (length > 0)
+         {
+            auto equals = (const char*)memchr(start, '=', length);
+            if (equals)
+            {
+               query[decode(start, (size_t)(equals - start))] = decode(equals + 1, length - (size_t)(equals - start) - 1);
+            }
+            else
+            {
+               query[decode(start, length)] = "";
+            }
+         }
+         start += length;
+      }
+      return query;
+   }
 }
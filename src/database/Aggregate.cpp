@@ -0,0 +1,256 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/Aggregate.h>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+namespace
+{
+   void OutputNumber(std::ostream& output, double value)
+   {
+      char buffer[32];
+      if (std::floor(value) == value && std::fabs(value) < 9007199254740992.0) // exact as an integer
+      {
+         snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+      }
+      else
+      {
+         snprintf(buffer, sizeof(buffer), "%.17g", value);
+      }
+      output << buffer;
+   }
+}
+
+namespace jude
+{
+   bool Aggregate::CanAggregate(const jude_field_t& field)
+   {
+      if (jude_field_is_array(&field))
+      {
+         return false;
+      }
+
+      switch (field.type)
+      {
+      case JUDE_TYPE_BOOL:
+      case JUDE_TYPE_SIGNED:
+      case JUDE_TYPE_UNSIGNED:
+      case JUDE_TYPE_ENUM:
+      case JUDE_TYPE_BITMASK:
+      case JUDE_TYPE_FLOAT:
+         return true;
+
+      default:
+         return false;
+      }
+   }
+
+   bool Aggregate::CanGroupBy(const jude_field_t& field)
+   {
+      return !jude_field_is_array(&field) && field.type != JUDE_TYPE_OBJECT && field.type != JUDE_TYPE_BYTES;
+   }
+
+   bool Aggregate::ReadValue(const Object& object, double& value) const
+   {
+      auto data = (const uint8_t*)jude_object_get_value_in_array(const_cast<jude_object_t*>(object.RawData()), m_valueField->index, 0);
+      if (data == nullptr || !object.Has(m_valueField->index))
+      {
+         return false;
+      }
+
+      switch (m_valueField->type)
+      {
+      case JUDE_TYPE_BOOL:
+         value = *(const bool*)data ? 1 : 0;
+         return true;
+
+      case JUDE_TYPE_SIGNED:
+      case JUDE_TYPE_ENUM:
+         switch (m_valueField->data_size)
+         {
+         case 1:  value = *(const int8_t*)data;  return true;
+         case 2:  value = *(const int16_t*)data; return true;
+         case 4:  value = *(const int32_t*)data; return true;
+         default: value = (double)*(const int64_t*)data; return true;
+         }
+
+      case JUDE_TYPE_UNSIGNED:
+      case JUDE_TYPE_BITMASK:
+         switch (m_valueField->data_size)
+         {
+         case 1:  value = *(const uint8_t*)data;  return true;
+         case 2:  value = *(const uint16_t*)data; return true;
+         case 4:  value = *(const uint32_t*)data; return true;
+         default: value = (double)*(const uint64_t*)data; return true;
+         }
+
+      case JUDE_TYPE_FLOAT:
+         // NaN and infinity are left out like a missing value - they can't be ordered or taken back out of the sum
+         value = m_valueField->data_size == sizeof(float) ? *(const float*)data : *(const double*)data;
+         return std::isfinite(value);
+
+      default:
+         return false;
+      }
+   }
+
+   bool Aggregate::IsAffectedBy(const Object& changedObject) const
+   {
+      return changedObject.IsNew()
+          || (m_valueField && changedObject.IsChanged(m_valueField->index))
+          || (m_groupField && changedObject.IsChanged(m_groupField->index));
+   }
+
+   void Aggregate::Update(const Object& object)
+   {
+      Contribution contribution{ "", 0 };
+      if (m_valueField && !ReadValue(object, contribution.value))
+      {
+         Remove(object.Id());
+         return;
+      }
+      if (m_groupField && object.Has(m_groupField->index))
+      {
+         contribution.group = object.GetFieldAsString(m_groupField->index);
+         if (contribution.group.size() >= 2 && contribution.group.front() == '"' && contribution.group.back() == '"')
+         {
+            contribution.group = contribution.group.substr(1, contribution.group.size() - 2); // enum names come quoted
+         }
+      }
+
+      auto existing = m_contributions.find(object.Id());
+      if (existing != m_contributions.end())
+      {
+         if (existing->second.group == contribution.group && existing->second.value == contribution.value)
+         {
+            return;
+         }
+         Remove(object.Id());
+      }
+
+      auto& group = m_groups[contribution.group];
+      group.count++;
+      if (m_valueField)
+      {
+         group.sum += contribution.value;
+         group.values.insert(contribution.value);
+      }
+      m_contributions.emplace(object.Id(), std::move(contribution));
+   }
+
+   void Aggregate::Remove(jude_id_t id)
+   {
+      auto existing = m_contributions.find(id);
+      if (existing == m_contributions.end())
+      {
+         return;
+      }
+
+      auto group = m_groups.find(existing->second.group);
+      if (group != m_groups.end())
+      {
+         if (--group->second.count == 0)
+         {
+            m_groups.erase(group);
+         }
+         else if (m_valueField)
+         {
+            group->second.sum -= existing->second.value;
+            auto value = group->second.values.find(existing->second.value);
+            if (value != group->second.values.end())
+            {
+               group->second.values.erase(value);
+            }
+         }
+      }
+
+      m_contributions.erase(existing);
+   }
+
+   Aggregate::Totals Aggregate::TotalsOf(const Group& group) const
+   {
+      Totals totals;
+      totals.count = group.count;
+      if (!group.values.empty())
+      {
+         totals.sum = group.sum;
+         totals.min = *group.values.begin();
+         totals.max = *group.values.rbegin();
+      }
+      return totals;
+   }
+
+   Aggregate::Totals Aggregate::Get(const std::string& group) const
+   {
+      auto found = m_groups.find(group);
+      return found == m_groups.end() ? Totals() : TotalsOf(found->second);
+   }
+
+   std::map<std::string, Aggregate::Totals> Aggregate::Groups() const
+   {
+      std::map<std::string, Totals> groups;
+      for (auto& group : m_groups)
+      {
+         groups.emplace(group.first, TotalsOf(group.second));
+      }
+      return groups;
+   }
+
+   void Aggregate::ToJSON(std::ostream& output) const
+   {
+      auto outputTotals = [&] (const Totals& totals) {
+         output << "{\"count\":" << totals.count;
+         if (m_valueField)
+         {
+            output << ",\"sum\":";  OutputNumber(output, totals.sum);
+            output << ",\"min\":";  OutputNumber(output, totals.min);
+            output << ",\"max\":";  OutputNumber(output, totals.max);
+            output << ",\"avg\":";  OutputNumber(output, totals.Average());
+         }
+         output << '}';
+      };
+
+      if (!m_groupField)
+      {
+         outputTotals(Get());
+         return;
+      }
+
+      output << '{';
+      bool commaNeeded = false;
+      for (auto& group : m_groups)
+      {
+         if (commaNeeded)
+         {
+            output << ',';
+         }
+         commaNeeded = true;
+         output << std::quoted(group.first) << ':';
+         outputTotals(TotalsOf(group.second));
+      }
+      output << '}';
+   }
+}
@@ -25,17 +25,197 @@
 #include <jude/database/Swagger.h>
 #include <jude/jude.h>
 #include <utility>
+#include <sstream>
+#include <iterator>
 #include <algorithm>
 #include <inttypes.h>
 
 using namespace std;
 
+namespace
+{
+   // Stored objects being read by this thread further up the stack - they mustn't be evicted until the reader returns
+   thread_local unsigned storedObjectReaders = 0;
+
+   struct StoredObjectReader
+   {
+      StoredObjectReader() { storedObjectReaders++; }
+      ~StoredObjectReader() { storedObjectReaders--; }
+   };
+
+   // Merges changed objects (null for deleted ones) into a chunk of a snapshot, splitting it if it gets too big
+   void MergeIntoSnapshot(const jude::CollectionSnapshot::Chunk& chunk, const jude_id_t* ids, jude::Object* objects, size_t count, jude::CollectionSnapshot::Table& table)
+   {
+      jude::CollectionSnapshot::Chunk merged;
+      merged.reserve(chunk.size() + count);
+
+      auto entry = chunk.begin();
+      for (size_t index = 0; index < count; index++)
+      {
+         for (; entry != chunk.end() && entry->first < ids[index]; ++entry)
+         {
+            merged.emplace_back(entry->first, const_cast<jude::Object&>(entry->second));
+         }
+         if (entry != chunk.end() && entry->first == ids[index])
+         {
+            ++entry;
+         }
+         if (objects[index])
+         {
+            merged.emplace_back(ids[index], std::move(objects[index]));
+         }
+      }
+      for (; entry != chunk.end(); ++entry)
+      {
+         merged.emplace_back(entry->first, const_cast<jude::Object&>(entry->second));
+      }
+
+      for (size_t start = 0; start < merged.size(); start += jude::CollectionSnapshot::ChunkSize)
+      {
+         auto end = std::min(start + jude::CollectionSnapshot::ChunkSize, merged.size());
+         auto piece = std::make_shared<jude::CollectionSnapshot::Chunk>();
+         piece->reserve(end - start);
+         std::move(merged.begin() + (ptrdiff_t)start, merged.begin() + (ptrdiff_t)end, std::back_inserter(*piece));
+         table.chunks.push_back(std::move(piece));
+      }
+   }
+
+   bool ContainsDuplicates(std::vector<jude_id_t> ids)
+   {
+      std::sort(ids.begin(), ids.end());
+      return std::adjacent_find(ids.begin(), ids.end()) != ids.end();
+   }
+
+   // Splits a JSON array of objects into the text of each object so they can be decoded one at a time
+   bool SplitJsonArray(std::istream& input, std::vector<std::string>& elements, std::string& error)
+   {
+      std::string json((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+      auto pos = json.find_first_not_of(" \t\r\n");
+      if (pos == std::string::npos || json[pos] != '[')
+      {
+         error = "Expected a JSON array";
+         return false;
+      }
+
+      int depth = 0;
+      bool inString = false;
+      bool escaped = false;
+      size_t start = 0;
+
+      for (pos++; pos < json.length(); pos++)
+      {
+         char c = json[pos];
+         if (inString)
+         {
+            if (escaped)         escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"')   inString = false;
+            continue;
+         }
+
+         switch (c)
+         {
+         case '{':
+         case '[':
+            if (depth++ == 0)
+            {
+               if (c != '{')
+               {
+                  error = "JSON array entries must be objects";
+                  return false;
+               }
+               start = pos;
+            }
+            break;
+
+         case '}':
+         case ']':
+            if (depth == 0)
+            {
+               // end of the outer array
+               if (c != ']' || json.find_first_not_of(" \t\r\n", pos + 1) != std::string::npos)
+               {
+                  error = "Unexpected data after JSON array";
+                  return false;
+               }
+               return true;
+            }
+            if (--depth == 0)
+            {
+               elements.push_back(json.substr(start, pos - start + 1));
+            }
+            break;
+
+         case '"':
+            if (depth == 0)
+            {
+               error = "JSON array entries must be objects";
+               return false;
+            }
+            inString = true;
+            break;
+
+         case ',':
+         case ' ':
+         case '\t':
+         case '\r':
+         case '\n':
+            break;
+
+         default:
+            if (depth == 0)
+            {
+               error = "JSON array entries must be objects";
+               return false;
+            }
+            break;
+         }
+      }
+
+      error = "Unterminated JSON array";
+      return false;
+   }
+
+   template<class T_Index>
+   void UpdateIndex(T_Index& index, const jude::Object& changedObject, bool isDeleted)
+   {
+      if (isDeleted)
+      {
+         index.Remove(changedObject.Id());
+      }
+      else if (changedObject.IsNew() || changedObject.IsChanged(index.Field().index))
+      {
+         index.Update(changedObject);
+      }
+   }
+
+   void UpdateIndex(jude::Aggregate& aggregate, const jude::Object& changedObject, bool isDeleted)
+   {
+      if (isDeleted)
+      {
+         aggregate.Remove(changedObject.Id());
+      }
+      else if (aggregate.IsAffectedBy(changedObject))
+      {
+         aggregate.Update(changedObject);
+      }
+   }
+
+   template<class T_Indexes>
+   bool HasIndexFor(const T_Indexes& indexes, const char* fieldName)
+   {
+      return std::any_of(indexes.begin(), indexes.end(), [&] (const auto& index) { return 0 == strcmp(index.Field().label, fieldName); });
+   }
+}
+
 namespace jude
 {
    CollectionBase::CollectionBase(const jude_rtti_t& RTTI, const std::string& name, RestApiSecurityLevel::Value accessLevel, size_t capacity, std::shared_ptr<jude::Mutex> mutex)
       : DatabaseEntry(mutex)
       , m_rtti(RTTI)
       , m_name(name)
+      , m_objects(ObjectStore::Create(StoragePolicy::Ordered))
       , m_capacity(capacity)
    {
       m_access.canCreate = accessLevel;
@@ -44,6 +224,11 @@ namespace jude
       m_access.canDelete = accessLevel;
    }
 
+   CollectionBase::~CollectionBase()
+   {
+      StopExpiryThread();
+   }
+
    RestApiSecurityLevel::Value CollectionBase::GetAccessLevel(CRUD crud) const
    {
       switch (crud)
@@ -132,64 +317,965 @@ namespace jude
       }
    }
 
-   std::string CollectionBase::GetSwaggerReadSchema(RestApiSecurityLevel::Value userLevel) const
+   std::string CollectionBase::GetSwaggerReadSchema(RestApiSecurityLevel::Value userLevel) const
+   {
+      if (userLevel < m_access.canRead)
+      {
+         return "";
+      }
+
+      static const char* schemaTemplateMap = "        %s:\n"
+                                             "          type: object\n"
+                                             "          additionalProperties:\n"
+                                             "            $ref: '#/components/schemas/%s_Schema'\n";
+
+      static const char* schemaTemplateArray = "        %s:\n"
+                                               "          type: array\n"
+                                               "          items:\n"
+                                               "            $ref: '#/components/schemas/%s_Schema'\n";
+
+      char buffer[1024];
+      snprintf(buffer, std::size(buffer), (Options::SerialiseCollectionAsObjectMap ? schemaTemplateMap : schemaTemplateArray), m_name.c_str(), m_rtti.name);
+      return buffer;
+   }
+
+   ValidationResult CollectionBase::Validate(Validation<Object>& info)
+   {
+      // Take a copy so that validators can run without holding the collection lock
+      std::vector<Validatable<>::Validator> validators;
+      {
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         for (auto& validator : m_validators)
+         {
+            validators.push_back(validator.second);
+         }
+      }
+
+      for (auto& validator : validators)
+      {
+         auto result = validator(info);
+         if (!result)
+         {
+            return result;
+         }
+      }
+      return true;
+   }
+
+   void CollectionBase::EnableObjectLocking(size_t stripes)
+   {
+      auto mode = m_mutex->IsReaderWriter() ? jude::Mutex::Mode::ReaderWriter : jude::Mutex::Mode::Exclusive;
+
+      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      m_objectLocks.clear();
+      for (size_t stripe = 0; stripe < stripes; stripe++)
+      {
+         m_objectLocks.push_back(std::make_unique<jude::Mutex>(mode));
+      }
+   }
+
+   bool CollectionBase::SetStoragePolicy(StoragePolicy policy)
+   {
+      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      if (m_objects->Size() != 0)
+      {
+         return false;
+      }
+
+      if (policy == StoragePolicy::Tiered)
+      {
+         return false; // needs a spill file - use EnableSpillToDisk()
+      }
+
+      if (m_objects->GetPolicy() != policy)
+      {
+         m_objects = ObjectStore::Create(policy);
+         m_tieredObjects = nullptr;
+      }
+      return true;
+   }
+
+   bool CollectionBase::EnableSpillToDisk(const std::string& filePath, size_t maxResidentObjects)
+   {
+      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      if (m_objects->Size() != 0 || maxResidentObjects == 0)
+      {
+         return false;
+      }
+
+      TieredObjectStore::Codec codec;
+      codec.encode = [this] (const Object& object, std::string& bytes) { return EncodeForSpill(object, bytes); };
+      codec.decode = [this] (jude_id_t id, uint64_t version, const std::string& bytes) { return DecodeSpilledObject(id, version, bytes); };
+      codec.adopt  = [this] (Object& object, jude_id_t id) { return AdoptObject(object, id); };
+
+      auto store = std::make_unique<TieredObjectStore>(std::move(codec), filePath, maxResidentObjects);
+      if (!store->IsOpen())
+      {
+         return false;
+      }
+
+      m_tieredObjects = store.get();
+      m_objects = std::move(store);
+      return true;
+   }
+
+   TieredObjectStore::Stats CollectionBase::GetSpillStats() const
+   {
+      return m_tieredObjects ? m_tieredObjects->GetStats() : TieredObjectStore::Stats();
+   }
+
+   bool CollectionBase::EncodeForSpill(const Object& object, std::string& bytes) const
+   {
+      std::ostringstream output;
+      {
+         OutputStreamWrapper wrapper(output, DefaultBufferSize, jude_encode_transport_protobuf);
+         if (!jude_encode(&wrapper.m_ostream, object.m_object))
+         {
+            return false;
+         }
+      }
+      bytes = output.str();
+      return true;
+   }
+
+   Object CollectionBase::DecodeSpilledObject(jude_id_t id, uint64_t version, const std::string& bytes) const
+   {
+      std::istringstream input(bytes);
+      InputStreamWrapper wrapper(input, DefaultBufferSize, jude_decode_transport_protobuf);
+
+      Object object(m_rtti);
+      if (!jude_decode(&wrapper.m_istream, object.m_object))
+      {
+         return nullptr;
+      }
+
+      object.AssignId(id);
+      object.ClearChangeMarkers();
+      object.m_sharedRoot->version = version;
+      return object;
+   }
+
+   void CollectionBase::EvictColdObjects() const
+   {
+      // Never while this thread is reading a stored object further up the stack
+      if (m_tieredObjects == nullptr || storedObjectReaders > 0 || !m_tieredObjects->NeedsEviction())
+      {
+         return;
+      }
+
+      for (auto id : m_tieredObjects->EvictionCandidates())
+      {
+         // Objects locked by anyone - including callers further up this thread's stack - are left in memory
+         auto& objectMutex = ObjectMutex(id);
+         std::unique_lock<jude::Mutex> objectLock(objectMutex, std::try_to_lock);
+         if (!objectLock || objectMutex.GetLockDepth() > 1)
+         {
+            continue;
+         }
+
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
+         m_tieredObjects->Evict(id);
+      }
+   }
+
+   bool CollectionBase::AddIndex(const char* fieldName)
+   {
+      auto field = jude_rtti_find_field(&m_rtti, fieldName);
+      if (field == nullptr)
+      {
+         return false;
+      }
+
+      std::list<SecondaryIndex>::iterator building;
+      {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         if (HasIndexFor(m_indexes, fieldName) || HasIndexFor(m_buildingIndexes, fieldName))
+         {
+            return false;
+         }
+         building = m_buildingIndexes.emplace(m_buildingIndexes.end(), *field);
+      }
+
+      BuildIndex([&] (const Object& object) { building->Update(object); });
+
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      m_indexes.push_back(std::move(*building));
+      m_buildingIndexes.erase(building);
+      return true;
+   }
+
+   void CollectionBase::BuildIndex(const std::function<void(const Object&)>& update)
+   {
+      // Writers publish changes to indexes that are still being built too, and each object is read here under its
+      // object lock, so no change can be published between reading an object and adding it
+      ForEachObject([&] (const Object& object) {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         update(object);
+         return true;
+      });
+   }
+
+   bool CollectionBase::HasIndex(const char* fieldName) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      return HasIndexFor(m_indexes, fieldName);
+   }
+
+   std::vector<jude_id_t> CollectionBase::FindIdsByIndex(const char* fieldName, const std::string& value) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      for (const auto& index : m_indexes)
+      {
+         if (0 == strcmp(index.Field().label, fieldName))
+         {
+            auto ids = index.Find(value);
+            return ids ? *ids : std::vector<jude_id_t>();
+         }
+      }
+      return {};
+   }
+
+   bool CollectionBase::AddOrderedIndex(const char* fieldName)
+   {
+      auto field = jude_rtti_find_field(&m_rtti, fieldName);
+      if (field == nullptr || !OrderedIndex::CanOrder(*field))
+      {
+         return false;
+      }
+
+      std::list<OrderedIndex>::iterator building;
+      {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         if (HasIndexFor(m_orderedIndexes, fieldName) || HasIndexFor(m_buildingOrderedIndexes, fieldName))
+         {
+            return false;
+         }
+         building = m_buildingOrderedIndexes.emplace(m_buildingOrderedIndexes.end(), *field);
+      }
+
+      BuildIndex([&] (const Object& object) { building->Update(object); });
+
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      m_orderedIndexes.push_back(std::move(*building));
+      m_buildingOrderedIndexes.erase(building);
+      return true;
+   }
+
+   bool CollectionBase::HasOrderedIndex(const char* fieldName) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      return HasIndexFor(m_orderedIndexes, fieldName);
+   }
+
+   std::vector<jude_id_t> CollectionBase::TopIds(const char* fieldName, size_t k, bool highestFirst) const
+   {
+      std::vector<jude_id_t> ids;
+      auto field = jude_rtti_find_field(&m_rtti, fieldName);
+      if (field == nullptr || !OrderedIndex::CanOrder(*field) || k == 0)
+      {
+         return ids;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         for (const auto& index : m_orderedIndexes)
+         {
+            if (&index.Field() == field)
+            {
+               OrderedIndex::Cursor cursor;
+               index.Next(ids, k, highestFirst, cursor);
+               return ids;
+            }
+         }
+      }
+
+      // No index - keep the best k seen so far in a heap with the worst of them on top
+      using Entry = std::pair<std::string, jude_id_t>;
+      std::vector<Entry> heap;
+      heap.reserve(k + 1);
+      auto isBetter = [highestFirst] (const Entry& a, const Entry& b) { return highestFirst ? a > b : a < b; };
+
+      std::string key;
+      ForEachObject([&] (const Object& object) {
+         if (OrderedIndex::ReadKey(*field, object, key))
+         {
+            if (heap.size() < k)
+            {
+               heap.emplace_back(key, object.Id());
+               std::push_heap(heap.begin(), heap.end(), isBetter);
+            }
+            else if (isBetter({ key, object.Id() }, heap.front()))
+            {
+               std::pop_heap(heap.begin(), heap.end(), isBetter);
+               heap.back() = { key, object.Id() };
+               std::push_heap(heap.begin(), heap.end(), isBetter);
+            }
+         }
+         return true;
+      });
+
+      std::sort_heap(heap.begin(), heap.end(), isBetter);
+      for (const auto& entry : heap)
+      {
+         ids.push_back(entry.second);
+      }
+      return ids;
+   }
+
+   bool CollectionBase::ForEachIdInOrder(const char* fieldName, const std::function<bool(jude_id_t)>& visitor, bool descending) const
+   {
+      static constexpr size_t ChunkSize = 64;
+
+      OrderedIndex::Cursor cursor;
+      std::vector<jude_id_t> ids;
+      ids.reserve(ChunkSize);
+
+      bool more = true;
+      while (more)
+      {
+         ids.clear();
+         {
+            std::lock_guard<std::mutex> lock(m_indexMutex);
+            auto index = std::find_if(m_orderedIndexes.begin(), m_orderedIndexes.end(), [&] (const OrderedIndex& index) {
+               return 0 == strcmp(index.Field().label, fieldName);
+            });
+            if (index == m_orderedIndexes.end())
+            {
+               return false;
+            }
+            more = index->Next(ids, ChunkSize, descending, cursor);
+         }
+
+         // The visitor is called without the index lock so it can read (or change) the collection
+         for (auto id : ids)
+         {
+            if (!visitor(id))
+            {
+               return true;
+            }
+         }
+      }
+      return true;
+   }
+
+   bool CollectionBase::AddAggregate(const std::string& name, const char* valueField, const char* groupByField)
+   {
+      const jude_field_t* value = nullptr;
+      const jude_field_t* groupBy = nullptr;
+      if (valueField)
+      {
+         value = jude_rtti_find_field(&m_rtti, valueField);
+         if (value == nullptr || !Aggregate::CanAggregate(*value))
+         {
+            return false;
+         }
+      }
+      if (groupByField)
+      {
+         groupBy = jude_rtti_find_field(&m_rtti, groupByField);
+         if (groupBy == nullptr || !Aggregate::CanGroupBy(*groupBy))
+         {
+            return false;
+         }
+      }
+      if (name.empty())
+      {
+         return false;
+      }
+
+      std::map<std::string, Aggregate>::iterator building;
+      {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         if (m_aggregates.count(name) != 0 || m_buildingAggregates.count(name) != 0)
+         {
+            return false;
+         }
+         building = m_buildingAggregates.emplace(name, Aggregate(value, groupBy)).first;
+      }
+
+      BuildIndex([&] (const Object& object) { building->second.Update(object); });
+
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      m_aggregates.emplace(name, std::move(building->second));
+      m_buildingAggregates.erase(building);
+      return true;
+   }
+
+   bool CollectionBase::HasAggregate(const std::string& name) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      return m_aggregates.count(name) != 0;
+   }
+
+   Aggregate::Totals CollectionBase::GetAggregate(const std::string& name, const std::string& group) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      auto aggregate = m_aggregates.find(name);
+      return aggregate == m_aggregates.end() ? Aggregate::Totals() : aggregate->second.Get(group);
+   }
+
+   std::map<std::string, Aggregate::Totals> CollectionBase::GetAggregateGroups(const std::string& name) const
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      auto aggregate = m_aggregates.find(name);
+      return aggregate == m_aggregates.end() ? std::map<std::string, Aggregate::Totals>() : aggregate->second.Groups();
+   }
+
+   // Expiry ticks are 10ms - the wheel then spans over 100 days before entries need to be parked
+   ExpiryWheel& CollectionBase::Expiry()
+   {
+      if (!m_expiry)
+      {
+         m_expiry = std::make_unique<ExpiryWheel>(std::chrono::milliseconds(10));
+         m_expiryInUse = true;
+      }
+      return *m_expiry;
+   }
+
+   void CollectionBase::SetTimeToLive(std::chrono::milliseconds timeToLive)
+   {
+      std::vector<jude_id_t> ids;
+      ForEachObject([&] (const Object& object) {
+         ids.push_back(object.Id());
+         return true;
+      });
+
+      std::lock_guard<std::mutex> lock(m_expiryMutex);
+      m_timeToLive = timeToLive;
+      if (timeToLive.count() > 0)
+      {
+         auto& expiry = Expiry();
+         auto expiryTime = ExpiryWheel::Clock::now() + timeToLive;
+         for (auto id : ids)
+         {
+            expiry.Arm(id, expiryTime);
+         }
+      }
+      else if (m_expiry)
+      {
+         for (auto id : ids)
+         {
+            m_expiry->Cancel(id);
+         }
+      }
+   }
+
+   std::chrono::milliseconds CollectionBase::GetTimeToLive() const
+   {
+      std::lock_guard<std::mutex> lock(m_expiryMutex);
+      return m_timeToLive;
+   }
+
+   bool CollectionBase::ExpireAfter(jude_id_t id, std::chrono::milliseconds timeToLive)
+   {
+      std::lock_guard<jude::Mutex> objectLock(ObjectMutex(id));
+      if (!ContainsId(id))
+      {
+         return false;
+      }
+
+      std::lock_guard<std::mutex> lock(m_expiryMutex);
+      Expiry().Arm(id, ExpiryWheel::Clock::now() + timeToLive);
+      return true;
+   }
+
+   size_t CollectionBase::ExpireObjects(ExpiryWheel::Clock::time_point now)
+   {
+      if (!m_expiryInUse)
+      {
+         return 0;
+      }
+
+      std::vector<jude_id_t> expired;
+      {
+         std::lock_guard<std::mutex> lock(m_expiryMutex);
+         m_expiry->Advance(now, expired);
+      }
+
+      size_t deleted = 0;
+      for (auto id : expired)
+      {
+         // Holding the object lock means nobody can change it between our check and the delete
+         std::lock_guard<jude::Mutex> objectLock(ObjectMutex(id));
+         {
+            std::lock_guard<std::mutex> lock(m_expiryMutex);
+            if (m_expiry->IsArmed(id))
+            {
+               continue; // changed since it expired
+            }
+         }
+         if (Delete(id).IsOK())
+         {
+            deleted++;
+         }
+      }
+      return deleted;
+   }
+
+   void CollectionBase::StartExpiryThread(std::chrono::milliseconds period)
+   {
+      StopExpiryThread();
+
+      std::lock_guard<std::mutex> lock(m_expiryMutex);
+      Expiry();
+      m_expiryThreadStopping = false;
+      m_expiryThread = std::thread([this, period] {
+         std::unique_lock<std::mutex> lock(m_expiryMutex);
+         while (!m_expiryWakeup.wait_for(lock, period, [this] { return m_expiryThreadStopping; }))
+         {
+            lock.unlock();
+            ExpireObjects();
+            lock.lock();
+         }
+      });
+   }
+
+   void CollectionBase::StopExpiryThread()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_expiryMutex);
+         m_expiryThreadStopping = true;
+      }
+      m_expiryWakeup.notify_all();
+      if (m_expiryThread.joinable())
+      {
+         m_expiryThread.join();
+      }
+   }
+
+   void CollectionBase::UpdateExpiry(jude_id_t id, bool isDeleted)
+   {
+      std::lock_guard<std::mutex> lock(m_expiryMutex);
+      if (isDeleted)
+      {
+         m_expiry->Cancel(id);
+      }
+      else if (m_timeToLive.count() > 0)
+      {
+         m_expiry->Arm(id, ExpiryWheel::Clock::now() + m_timeToLive);
+      }
+   }
+
+   void CollectionBase::UpdateIndexes(const Object& changedObject, bool isDeleted)
+   {
+      std::lock_guard<std::mutex> lock(m_indexMutex);
+      for (auto& index : m_indexes)
+      {
+         UpdateIndex(index, changedObject, isDeleted);
+      }
+      for (auto& index : m_orderedIndexes)
+      {
+         UpdateIndex(index, changedObject, isDeleted);
+      }
+      for (auto& aggregate : m_aggregates)
+      {
+         UpdateIndex(aggregate.second, changedObject, isDeleted);
+      }
+
+      for (auto& index : m_buildingIndexes)
+      {
+         UpdateIndex(index, changedObject, isDeleted);
+      }
+      for (auto& index : m_buildingOrderedIndexes)
+      {
+         UpdateIndex(index, changedObject, isDeleted);
+      }
+      for (auto& aggregate : m_buildingAggregates)
+      {
+         UpdateIndex(aggregate.second, changedObject, isDeleted);
+      }
+   }
+
+   // Lock ordering: an object lock may be held while taking the collection lock but never the other way around.
+   // Without object locking, every object shares the collection mutex.
+   jude::Mutex& CollectionBase::ObjectMutex(jude_id_t id) const
+   {
+      if (m_objectLocks.empty())
+      {
+         return *m_mutex;
+      }
+      return *m_objectLocks[(size_t)id % m_objectLocks.size()];
+   }
+
+   std::vector<std::unique_lock<jude::Mutex>> CollectionBase::LockObjects(std::vector<jude_id_t> ids)
+   {
+      std::vector<std::unique_lock<jude::Mutex>> locks;
+      if (!HasObjectLocking())
+      {
+         locks.emplace_back(*m_mutex);
+         return locks;
+      }
+
+      // Always lock stripes in index order so that two batches can't deadlock each other
+      std::vector<size_t> stripes;
+      for (auto id : ids)
+      {
+         stripes.push_back((size_t)id % m_objectLocks.size());
+      }
+      std::sort(stripes.begin(), stripes.end());
+      stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+
+      for (auto stripe : stripes)
+      {
+         locks.emplace_back(*m_objectLocks[stripe]);
+      }
+      return locks;
+   }
+
+   jude_id_t CollectionBase::FindStoredId(jude_id_t id, bool next) const
+   {
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+      if (next)
+      {
+         return m_objects->NextId(id);
+      }
+      return m_objects->Contains(id) ? id : JUDE_INVALID_ID;
+   }
+
+   // Caller must hold ObjectMutex(id) - this stops the entry being erased while the pointer is in use
+   Object* CollectionBase::FindStoredObject(jude_id_t id)
+   {
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+      return m_objects->Find(id);
+   }
+
+   bool CollectionBase::ReadObject(jude_id_t id, const std::function<void(const Object&)>& reader) const
+   {
+      std::shared_lock<jude::Mutex> objectLock(ObjectMutex(id), std::defer_lock);
+      if (HasObjectLocking())
+      {
+         objectLock.lock();
+      }
+
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+      auto storedObject = m_objects->Find(id);
+      if (storedObject == nullptr)
+      {
+         return false;
+      }
+
+      StoredObjectReader reading;
+      reader(*storedObject);
+      return true;
+   }
+
+   void CollectionBase::ForEachObject(const std::function<bool(const Object&)>& reader, jude_id_t after) const
+   {
+      if (!HasObjectLocking())
+      {
+         // A single shared lock gives readers a consistent view of the whole collection
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         StoredObjectReader reading;
+         m_objects->ForEach(reader, after);
+         return;
+      }
+
+      // We can't wait on object locks while holding the collection lock so step through the ids in turn
+      bool keepGoing = true;
+      for (auto id = FindStoredId(after, true); keepGoing && id != JUDE_INVALID_ID; id = FindStoredId(id, true))
+      {
+         ReadObject(id, [&] (const Object& object) { keepGoing = reader(object); });
+         EvictColdObjects();
+      }
+   }
+
+   CollectionSnapshot CollectionBase::Snapshot() const
+   {
+      std::lock_guard<std::mutex> buildLock(m_snapshotBuildMutex);
+
+      std::shared_ptr<const CollectionSnapshot::Table> base;
+      std::vector<jude_id_t> changedIds;
+      uint32_t generation;
+      {
+         std::lock_guard<std::mutex> lock(m_snapshotMutex);
+         base = m_snapshot.lock();
+         if (base && m_snapshotChangedIds.empty())
+         {
+            return CollectionSnapshot(base);
+         }
+         m_snapshotBuilding = true;
+         changedIds.swap(m_snapshotChangedIds);
+         generation = m_snapshotGeneration;
+      }
+
+      // Snapshots share the stored object's data - the collection unshares it before it is next changed in place.
+      // An object this thread is editing further up the stack is copied as its edits are not published yet.
+      auto share = [] (const Object& object) {
+         auto& storedObject = const_cast<Object&>(object);
+         return storedObject.m_sharedRoot->editLocked ? storedObject.Clone(false) : Object(storedObject);
+      };
+
+      auto table = std::make_shared<CollectionSnapshot::Table>();
+
+      if (!base)
+      {
+         std::shared_ptr<CollectionSnapshot::Chunk> chunk;
+         ForEachObject([&] (const Object& object) {
+            if (!chunk || chunk->size() == CollectionSnapshot::ChunkSize)
+            {
+               chunk = std::make_shared<CollectionSnapshot::Chunk>();
+               chunk->reserve(CollectionSnapshot::ChunkSize);
+               table->chunks.push_back(chunk);
+            }
+            chunk->emplace_back(object.Id(), share(object));
+            return true;
+         });
+      }
+      else
+      {
+         // Unchanged chunks are shared with the previous snapshot, only the chunks holding changed ids are rebuilt
+         std::sort(changedIds.begin(), changedIds.end());
+         changedIds.erase(std::unique(changedIds.begin(), changedIds.end()), changedIds.end());
+
+         std::vector<Object> changedObjects(changedIds.size());
+         if (HasObjectLocking())
+         {
+            for (size_t index = 0; index < changedIds.size(); index++)
+            {
+               ReadObject(changedIds[index], [&] (const Object& object) { changedObjects[index] = share(object); });
+            }
+         }
+         else
+         {
+            std::shared_lock<jude::Mutex> lock(*m_mutex);
+            for (size_t index = 0; index < changedIds.size(); index++)
+            {
+               if (auto object = m_objects->Find(changedIds[index]))
+               {
+                  changedObjects[index] = share(*object);
+               }
+            }
+         }
+
+         // Each chunk takes the changed ids that come before the first id of the next chunk
+         const auto& chunks = base->chunks;
+         size_t change = 0;
+         for (size_t index = 0; index < chunks.size(); index++)
+         {
+            auto lastChange = change;
+            bool isLastChunk = (index + 1 == chunks.size());
+            while (lastChange < changedIds.size() && (isLastChunk || changedIds[lastChange] < chunks[index + 1]->front().first))
+            {
+               lastChange++;
+            }
+
+            if (lastChange == change)
+            {
+               table->chunks.push_back(chunks[index]);
+               continue;
+            }
+            MergeIntoSnapshot(*chunks[index], &changedIds[change], &changedObjects[change], lastChange - change, *table);
+            change = lastChange;
+         }
+         if (chunks.empty())
+         {
+            MergeIntoSnapshot(CollectionSnapshot::Chunk(), changedIds.data(), changedObjects.data(), changedIds.size(), *table);
+         }
+      }
+
+      for (const auto& chunk : table->chunks)
+      {
+         table->size += chunk->size();
+      }
+
+      std::lock_guard<std::mutex> lock(m_snapshotMutex);
+      m_snapshotBuilding = false;
+      if (generation == m_snapshotGeneration)
+      {
+         m_snapshot = table;
+      }
+      return CollectionSnapshot(std::move(table));
+   }
+
+   void CollectionBase::OnSnapshotChange(jude_id_t id)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_snapshotMutex);
+         if (!m_snapshotBuilding && m_snapshot.expired())
+         {
+            // Nobody holds a snapshot so the next one starts from scratch anyway
+            m_snapshotChangedIds.clear();
+            return;
+         }
+      }
+
+      auto objectCount = count();
+
+      std::lock_guard<std::mutex> lock(m_snapshotMutex);
+
+      // Once most of the collection has changed it is cheaper to start again than to merge
+      if (m_snapshotChangedIds.size() >= objectCount)
+      {
+         m_snapshot.reset();
+         m_snapshotChangedIds.clear();
+         m_snapshotGeneration++;
+         return;
+      }
+      m_snapshotChangedIds.push_back(id);
+   }
+
+   void CollectionBase::ForEachMatch(const CollectionQuery& query, const std::function<bool(const Object&)>& reader, jude_id_t after) const
+   {
+      // Reads come from a snapshot so slow readers never hold up writers. A collection that spills to disk is read in
+      // place instead - a snapshot would load every spilled object and keep it resident.
+      std::unique_ptr<CollectionSnapshot> snapshot;
+      if (!m_tieredObjects)
+      {
+         snapshot = std::make_unique<CollectionSnapshot>(Snapshot());
+      }
+
+      // Only visit the ids a secondary index gives for an "=" term, if we can
+      std::vector<jude_id_t> candidates;
+      bool useIndex = false;
+      {
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         std::string key;
+         for (const auto& predicate : query.Predicates())
+         {
+            for (const auto& index : m_indexes)
+            {
+               if (&index.Field() == predicate.field && predicate.IndexKey(key))
+               {
+                  if (auto ids = index.Find(key))
+                  {
+                     candidates = *ids;
+                  }
+                  useIndex = true;
+                  break;
+               }
+            }
+            if (useIndex)
+            {
+               break;
+            }
+         }
+      }
+
+      auto matchingReader = [&] (const Object& object) {
+         return !query.Matches(object) || reader(object);
+      };
+
+      if (!useIndex)
+      {
+         if (snapshot)
+         {
+            snapshot->ForEach(matchingReader, after);
+            return;
+         }
+         ForEachObject(matchingReader, after);
+         return;
+      }
+
+      // The index may be ahead of the snapshot - the match is always made against the snapshot's copy
+      auto first = (after == JUDE_INVALID_ID) ? candidates.begin() : std::upper_bound(candidates.begin(), candidates.end(), after);
+      bool keepGoing = true;
+      for (auto id = first; keepGoing && id != candidates.end(); ++id)
+      {
+         if (!snapshot)
+         {
+            ReadObject(*id, [&] (const Object& object) { keepGoing = matchingReader(object); });
+         }
+         else if (auto object = snapshot->Find(*id))
+         {
+            keepGoing = matchingReader(*object);
+         }
+      }
+   }
+
+   void CollectionBase::ForEachPublished(const std::function<bool(const Object&)>& reader) const
    {
-      if (userLevel < m_access.canRead)
-      {
-         return "";
-      }
+      ForEachMatch(CollectionQuery(m_rtti), reader);
+   }
 
-      static const char* schemaTemplateMap = "        %s:\n"
-                                             "          type: object\n"
-                                             "          additionalProperties:\n"
-                                             "            $ref: '#/components/schemas/%s_Schema'\n";
+   std::vector<jude_id_t> CollectionBase::FindIds(const CollectionQuery& query) const
+   {
+      std::vector<jude_id_t> ids;
+      ForEachMatch(query, [&] (const Object& object) {
+         ids.push_back(object.Id());
+         return true;
+      });
+      return ids;
+   }
 
-      static const char* schemaTemplateArray = "        %s:\n"
-                                               "          type: array\n"
-                                               "          items:\n"
-                                               "            $ref: '#/components/schemas/%s_Schema'\n";
+   Object CollectionBase::AdoptObject(Object& candidate, jude_id_t id)
+   {
+      std::function<void()> onChange = [this, id] { OnEdited(id); };             // This may be called on each change to an object
+      std::function<void()> onSingleRef = [this, id] { OnEditCompleted(id); };   // This will be called when the refcount of the object is back to 1
 
-      char buffer[1024];
-      snprintf(buffer, std::size(buffer), (Options::SerialiseCollectionAsObjectMap ? schemaTemplateMap : schemaTemplateArray), m_name.c_str(), m_rtti.name);
-      return buffer;
+      // If nobody else refers to the candidate we can take it as it is, otherwise we need our own clone
+      if (candidate.AttachCallbacks(onChange, onSingleRef))
+      {
+         return Object(std::move(candidate));
+      }
+      return candidate.Clone(false, onChange, onSingleRef);
    }
 
-   ValidationResult CollectionBase::Validate(Validation<Object>& info)
+   void CollectionBase::UnshareStoredObject(Object& storedObject, jude_id_t id)
    {
-      for (auto& validator : m_validators)
+      // Only snapshots share a stored object without an edit lock - leave them the old data and take a copy to change
+      if (storedObject.RefCount() > 1 && !storedObject.m_sharedRoot->editLocked)
       {
-         auto result = validator.second(info);
-         if (!result)
-         {
-            return result;
-         }
+         auto copy = storedObject.Clone(false);
+         storedObject = AdoptObject(copy, id);
       }
-      return true;
    }
 
    // These *must* be called symmetrically
    Object CollectionBase::LockForEdit(jude_id_t id, bool next)
    {
-      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      while ((id = FindStoredId(id, next)) != JUDE_INVALID_ID)
+      {
+         auto& objectMutex = ObjectMutex(id);
+         std::unique_lock<jude::Mutex> lock(objectMutex);
 
-      auto it = next ?
-           (id == JUDE_INVALID_ID ? m_objects.begin() : m_objects.upper_bound(id))
-         : (m_objects.find(id));
+         auto storedObject = FindStoredObject(id);
+         if (storedObject == nullptr)
+         {
+            // Deleted while we waited for the lock
+            if (next)
+            {
+               continue;
+            }
+            return nullptr;
+         }
 
-      if (it == m_objects.end())
-      {
-         return nullptr;
+         if (!storedObject->m_sharedRoot->editLocked)
+         {
+            // No editable copy is outstanding.
+            // Here, we lock again so this resolurce is locked "outside" the collection
+            // until such time as reference count get back to one - then it is "editCompleted" and unlocked
+            objectMutex.lock(); 
+            UnshareStoredObject(*storedObject, id);
+            storedObject->m_sharedRoot->editLocked = true;
+         }
+
+         Object edited(*storedObject);
+         lock.unlock();
+         EvictColdObjects();
+         return edited;
       }
 
-      if (it->second.RefCount() == 1)
+      return nullptr;
+   }
+
+   Object CollectionBase::LockForRead(jude_id_t id, bool next) const
+   {
+      Object copy(nullptr);
+
+      while ((id = FindStoredId(id, next)) != JUDE_INVALID_ID)
       {
-         // The only reference would be that held in the collection.
-         // Here, we lock again so this resolurce is locked "outside" the collection
-         // until such time as reference count get back to one - then it is "editCompleted" and unlocked
-         m_mutex->lock(); 
+         // Readers get their own copy so the lock is not held for the lifetime of the reference
+         if (ReadObject(id, [&] (const Object& object) { copy = object.Clone(); }) || !next)
+         {
+            break;
+         }
       }
 
-      return it->second;
+      EvictColdObjects();
+      return copy;
    }
    
    void CollectionBase::OnEdited(jude_id_t id)
@@ -205,7 +1291,8 @@ namespace jude
       // Now that the editing is completed, publish any changes
       PublishChangesToQueue(id);
 
-      m_mutex->unlock();
+      ObjectMutex(id).unlock();
+      EvictColdObjects();
    }
 
    RestfulResult CollectionBase::PostObject(const Object& object)
@@ -245,8 +1332,9 @@ namespace jude
          return jude_rest_Internal_Server_Error;
       }
 
-      auto objectRecord = m_objects.find(id);
-      if (objectRecord == m_objects.end())
+      // The transaction holds ObjectMutex(id) so the stored object can't be removed while we commit
+      auto storedObject = FindStoredObject(id);
+      if (storedObject == nullptr)
       {
          // Already removed, we can't commit!
          return jude_rest_Internal_Server_Error;
@@ -257,34 +1345,168 @@ namespace jude
          editedCopy.AssignId(id);
       }
 
-      Validation<> validation(&editedCopy, [&] { return objectRecord->second; }, false);
+      Validation<> validation(&editedCopy, [&] { return *storedObject; }, false);
+      auto result = Validate(validation);
+      if (!result)
+      {
+         return RestfulResult(jude_rest_Bad_Request, result.error);
+      }
+
+      // Adopt the edited copy with the callbacks needed for later edits
+      *storedObject = AdoptObject(editedCopy, id);
+      PublishChangesToQueue(*storedObject, false);
+
+      return jude_rest_OK;
+   }
+
+   RestfulResult CollectionBase::OnOptimisticTransactionCompleted(jude_id_t id, uint64_t version, Object& editedCopy, bool needsCommit)
+   {
+      if (!needsCommit || !editedCopy.IsChanged())
+      {
+         return jude_rest_OK;
+      }
+
+      if (!editedCopy)
+      {
+         return jude_rest_Internal_Server_Error;
+      }
+
+      if (editedCopy.Id() != id)
+      {
+         jude_debug("WARNING: Transaction attempted change of id to %" PRIjudeID " - restting it to %" PRIjudeID, editedCopy.Id(), id);
+         editedCopy.AssignId(id);
+      }
+
+      RestfulResult conflict(jude_rest_Conflict, "Object has changed since the transaction started");
+
+      // Validators run without any lock - what they decide still holds if the version is the same when we commit
+      auto original = LockForRead(id);
+      if (!original)
+      {
+         return jude_rest_Not_Found;
+      }
+      if (original.Version() != version)
+      {
+         return conflict;
+      }
+
+      Validation<> validation(&editedCopy, [&] { return original; }, false);
       auto result = Validate(validation);
       if (!result)
       {
          return RestfulResult(jude_rest_Bad_Request, result.error);
       }
 
-      objectRecord->second = editedCopy;
-      PublishChangesToQueue(objectRecord->second, false);
+      // Only now do we lock, just long enough to check the version and swap in the edited copy
+      std::lock_guard<jude::Mutex> lock(ObjectMutex(id));
+
+      auto storedObject = FindStoredObject(id);
+      if (storedObject == nullptr)
+      {
+         return jude_rest_Not_Found;
+      }
+      if (storedObject->Version() != version)
+      {
+         return conflict;
+      }
+
+      *storedObject = AdoptObject(editedCopy, id);
+      PublishChangesToQueue(*storedObject, false);
+
+      return jude_rest_OK;
+   }
+
+   RestfulResult CollectionBase::OnDeltaTransactionCompleted(jude_id_t id, Object& delta, bool needsCommit)
+   {
+      if (!needsCommit || !delta || !delta.IsChanged())
+      {
+         return jude_rest_OK;
+      }
+
+      if (delta.Id() != id)
+      {
+         jude_debug("WARNING: Transaction attempted change of id to %" PRIjudeID " - restting it to %" PRIjudeID, delta.Id(), id);
+         delta.AssignId(id);
+      }
+
+      return ApplyDelta(id, delta);
+   }
+
+   RestfulResult CollectionBase::ApplyDelta(jude_id_t id, const Object& delta)
+   {
+      auto storedObject = FindStoredObject(id);
+      if (storedObject == nullptr)
+      {
+         return jude_rest_Not_Found;
+      }
+
+      bool hasValidators;
+      {
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         hasValidators = !m_validators.empty();
+      }
+
+      if (hasValidators)
+      {
+         // Validators need to see the whole edited object so we have to work on a copy
+         auto editedCopy = storedObject->Clone(false);
+         editedCopy.Patch(delta);
+         return OnTransactionCompleted(id, editedCopy, true);
+      }
 
+      // Only the changed fields of the delta are copied and marked as changed in the stored object
+      UnshareStoredObject(*storedObject, id);
+      if (jude_object_merge_data(storedObject->m_object, delta.m_object))
+      {
+         PublishChangesToQueue(*storedObject, false);
+      }
       return jude_rest_OK;
    }
 
    bool CollectionBase::ContainsId(jude_id_t id) const
    {
-      std::lock_guard<jude::Mutex> lock(*m_mutex);
-      return  m_objects.find(id) != m_objects.end();
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      return m_objects->Contains(id);
    }
 
    std::vector<jude_id_t> CollectionBase::GetIds() const
    {
       std::vector<jude_id_t> idList;
-      std::lock_guard<jude::Mutex> lock(*m_mutex);
-      for (auto const &it : m_objects)
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      idList.reserve(m_objects->Size());
+      m_objects->ForEach([&] (const Object& object) {
+         idList.push_back(object.Id());
+         return true;
+      });
+      return idList;
+   }
+
+   jude_id_t CollectionBase::GenerateId() const
+   {
+      auto id = m_idAllocator.Next();
+      if (m_idAllocator.CanCollide())
       {
-         idList.push_back(it.first);
+         // Never hand out the id of a stored object - posting it would replace that object
+         for (int attempt = 0; attempt < 100 && ContainsId(id); attempt++)
+         {
+            id = m_idAllocator.Next();
+         }
+         if (ContainsId(id))
+         {
+            return JUDE_INVALID_ID;
+         }
       }
-      return idList;
+      return id;
+   }
+
+   void CollectionBase::SetIdPolicy(IdPolicy policy, size_t blockSize)
+   {
+      jude_id_t highestId = 0;
+      ForEachObject([&] (const Object& object) {
+         highestId = std::max(highestId, object.Id());
+         return true;
+      });
+      m_idAllocator.SetPolicy(policy, highestId + 1, blockSize);
    }
 
    jude_id_t CollectionBase::FindObjectIdFromPath(const char* path_token) const
@@ -337,15 +1559,29 @@ namespace jude
          return JUDE_INVALID_ID;
       }
 
-      for (auto& resource : m_objects)
       {
-         if (searchValue == resource.second.GetFieldAsString(key_field->index))
+         std::lock_guard<std::mutex> lock(m_indexMutex);
+         for (const auto& index : m_indexes)
          {
-            return resource.second.Id();
+            if (&index.Field() == key_field)
+            {
+               auto ids = index.Find(searchValue);
+               return ids ? ids->front() : JUDE_INVALID_ID;
+            }
          }
       }
 
-      return JUDE_INVALID_ID;
+      jude_id_t foundId = JUDE_INVALID_ID;
+      ForEachObject([&] (const Object& object) {
+         if (searchValue == object.GetFieldAsString(key_field->index))
+         {
+            foundId = object.Id();
+            return false;
+         }
+         return true;
+      });
+
+      return foundId;
    }
 
    Object CollectionBase::LockForEditFromPath(const char** fullpath, bool& isRootPath)
@@ -399,14 +1635,15 @@ namespace jude
       {
          std::vector<std::string> paths;
          char buffer[32];
-         for (const auto& resource : m_objects)
-         {
-            snprintf(buffer, sizeof(buffer), "%" PRIjudeID, resource.first);
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         m_objects->ForEach([&] (const Object& resource) {
+            snprintf(buffer, sizeof(buffer), "%" PRIjudeID, resource.Id());
             if (0 == strncmp(buffer, token.c_str(), token.length()))
             {
                paths.push_back("/" + token + (buffer + token.length()));
             }
-         }
+            return true;
+         });
          return paths;
       }
       else
@@ -430,20 +1667,28 @@ namespace jude
 
    RestfulResult CollectionBase::Post(const Object& newObject, bool generate_uuid, bool andValidate)
    {
-      auto candidateObject = newObject.Clone(false);
+      return InsertObject(newObject.Clone(false), generate_uuid, andValidate);
+   }
+
+   RestfulResult CollectionBase::Post(Object&& newObject, bool generate_uuid, bool andValidate)
+   {
+      if (newObject.RefCount() != 1)
+      {
+         return Post(static_cast<const Object&>(newObject), generate_uuid, andValidate);
+      }
+      return InsertObject(std::move(newObject), generate_uuid, andValidate);
+   }
+
+   RestfulResult CollectionBase::InsertObject(Object candidateObject, bool generate_uuid, bool andValidate)
+   {
       if (generate_uuid || !candidateObject.IsIdAssigned())
       {
-         ////////////////////////////////////////////////////////
-         // Protobuf compatibility layer
-         if (Options::GenerateIDsBAsedOnCollectionSize && !ContainsId(count() + 1))
-         {
-            candidateObject.AssignId(count() + 1);
-         }
-         else
-         ////////////////////////////////////////////////////////
+         auto id = GenerateId();
+         if (id == JUDE_INVALID_ID)
          {
-            candidateObject.AssignId(jude_generate_uuid());
+            return RestfulResult(jude_rest_Internal_Server_Error, "Could not generate a unique id");
          }
+         candidateObject.AssignId(id);
       }
 
       auto uuid = candidateObject.Id();
@@ -457,30 +1702,268 @@ namespace jude
          auto isValid = Validate(info);
          if (!isValid)
          {
-            return RestfulResult(jude_rest_Bad_Request, std::move(isValid.error));
+            return RestfulResult(jude_rest_Bad_Request, std::move(isValid.error));
+         }
+      }
+
+      // It's valid - add it to our list
+      std::unique_lock<jude::Mutex> objectLock(ObjectMutex(uuid));
+      Object* storedObject;
+      {
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
+
+         if (Full())
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Collection '" + m_name + "' is full");
+         }
+
+         storedObject = &m_objects->Insert(uuid);
+         m_idAllocator.Observe(uuid);
+         // NOTE: move-assingment to prevent the callbacks 
+         *storedObject = AdoptObject(candidateObject, uuid);
+      }
+
+      storedObject->MarkObjectAsNew(); // a posted object is always "new"
+      PublishChangesToQueue(*storedObject, false); // We've just been added
+      storedObject->ClearChangeMarkers();
+
+      objectLock.unlock();
+      EvictColdObjects();
+      return RestfulResult(uuid);
+   }
+
+   RestfulResult CollectionBase::PostMany(std::vector<Object>& newObjects, bool generate_uuid, bool andValidate, std::vector<jude_id_t>* createdIds)
+   {
+      std::vector<Object> clones;       // copies of objects that someone else also refers to
+      std::vector<Object*> candidates;
+      std::vector<jude_id_t> ids;
+      clones.reserve(newObjects.size()); // never reallocates so the candidates can point into it
+      candidates.reserve(newObjects.size());
+      ids.reserve(newObjects.size());
+
+      for (auto& newObject : newObjects)
+      {
+         // Objects nobody else refers to can be stored as they are - they are only moved once every check has passed
+         if (newObject.RefCount() == 1)
+         {
+            candidates.push_back(&newObject);
+         }
+         else
+         {
+            clones.push_back(newObject.Clone(false));
+            candidates.push_back(&clones.back());
+         }
+         auto& candidateObject = *candidates.back();
+
+         if (generate_uuid || !candidateObject.IsIdAssigned())
+         {
+            auto id = GenerateId();
+            if (id == JUDE_INVALID_ID)
+            {
+               return RestfulResult(jude_rest_Internal_Server_Error, "Could not generate a unique id");
+            }
+            candidateObject.AssignId(id);
+         }
+         ids.push_back(candidateObject.Id());
+      }
+
+      if (ContainsDuplicates(ids))
+      {
+         return RestfulResult(jude_rest_Bad_Request, "Batch contains the same id more than once");
+      }
+
+      if (andValidate)
+      {
+         for (size_t index = 0; index < candidates.size(); index++)
+         {
+            candidates[index]->MarkObjectAsNew();
+            Validation<Object> info(candidates[index], {}, false);
+            auto isValid = Validate(info);
+            if (!isValid)
+            {
+               return RestfulResult(jude_rest_Bad_Request, "Entry " + std::to_string(index) + ": " + isValid.error);
+            }
+         }
+      }
+
+      PendingNotifications notifications;
+      notifications.reserve(candidates.size());
+      {
+         auto objectLocks = LockObjects(ids);
+         std::vector<Object*> storedObjects;
+         {
+            std::lock_guard<jude::Mutex> lock(*m_mutex);
+
+            auto newEntries = std::count_if(ids.begin(), ids.end(), [&] (jude_id_t id) { return !m_objects->Contains(id); });
+            if (m_objects->Size() + m_reservedInserts + newEntries > m_capacity)
+            {
+               return RestfulResult(jude_rest_Bad_Request, "Collection '" + m_name + "' does not have room for " + std::to_string(newEntries) + " new entries");
+            }
+
+            for (size_t index = 0; index < candidates.size(); index++)
+            {
+               auto storedObject = &m_objects->Insert(ids[index]);
+               m_idAllocator.Observe(ids[index]);
+               *storedObject = AdoptObject(*candidates[index], ids[index]);
+               storedObjects.push_back(storedObject);
+            }
+         }
+
+         for (auto storedObject : storedObjects)
+         {
+            storedObject->MarkObjectAsNew(); // a posted object is always "new"
+            AddNotification(notifications, *storedObject, false);
+         }
+      }
+
+      PublishNotifications(std::move(notifications));
+      EvictColdObjects();
+
+      if (createdIds)
+      {
+         *createdIds = std::move(ids);
+      }
+      return jude_rest_Created;
+   }
+
+   ValidationResult CollectionBase::ValidateChange(jude_id_t id, Object& changed, bool isNew, bool isDeleted)
+   {
+      if (isDeleted)
+      {
+         Validation<Object> info(*FindStoredObject(id), {}, true);
+         return Validate(info);
+      }
+
+      if (isNew)
+      {
+         if (Options::ValidatePostOnlyForRestAPI)
+         {
+            return true;
+         }
+         changed.MarkObjectAsNew();
+         Validation<Object> info(&changed, {}, false);
+         return Validate(info);
+      }
+
+      Validation<> info(&changed, [this, id] { return *FindStoredObject(id); }, false);
+      return Validate(info);
+   }
+
+   void CollectionBase::ApplyChange(jude_id_t id, Object& changed, bool isNew, bool isDeleted, PendingNotifications& notifications)
+   {
+      if (isDeleted)
+      {
+         Object removed;
+         {
+            std::lock_guard<jude::Mutex> lock(*m_mutex);
+            removed = std::move(*m_objects->Find(id));
+            m_objects->Erase(id);
+         }
+         AddNotification(notifications, removed, true);
+         return;
+      }
+
+      Object* storedObject;
+      if (isNew)
+      {
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
+         storedObject = &m_objects->Insert(id);
+         m_idAllocator.Observe(id);
+         *storedObject = AdoptObject(changed, id);
+         storedObject->MarkObjectAsNew(); // a posted object is always "new"
+      }
+      else
+      {
+         storedObject = FindStoredObject(id);
+         *storedObject = AdoptObject(changed, id);
+      }
+      AddNotification(notifications, *storedObject, false);
+   }
+
+   RestfulResult CollectionBase::PatchMany(const std::vector<const Object*>& patches)
+   {
+      std::vector<jude_id_t> ids;
+      for (auto patch : patches)
+      {
+         if (!patch->IsIdAssigned())
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Can't PATCH object with unknown ID");
+         }
+         ids.push_back(patch->Id());
+      }
+
+      if (ContainsDuplicates(ids))
+      {
+         return RestfulResult(jude_rest_Bad_Request, "Batch contains the same id more than once");
+      }
+
+      PendingNotifications notifications;
+      {
+         auto objectLocks = LockObjects(ids);
+
+         std::vector<Object*> storedObjects;
+         for (auto id : ids)
+         {
+            auto storedObject = FindStoredObject(id);
+            if (storedObject == nullptr)
+            {
+               return RestfulResult(jude_rest_Not_Found, "No object with id " + std::to_string(id));
+            }
+            storedObjects.push_back(storedObject);
+         }
+
+         bool hasValidators;
+         {
+            std::shared_lock<jude::Mutex> lock(*m_mutex);
+            hasValidators = !m_validators.empty();
          }
-      }
 
-      // It's valid - add it to our list
-      std::lock_guard<jude::Mutex> lock(*m_mutex);
+         if (hasValidators)
+         {
+            // Validators need to see whole objects so validate every edited copy before storing any of them
+            std::vector<Object> editedCopies;
+            editedCopies.reserve(patches.size());
+            for (size_t index = 0; index < patches.size(); index++)
+            {
+               editedCopies.push_back(storedObjects[index]->Clone(false));
+               auto& editedCopy = editedCopies.back();
+               if (!editedCopy.Patch(*patches[index]))
+               {
+                  continue;
+               }
+
+               Validation<> validation(&editedCopy, [&, index] { return *storedObjects[index]; }, false);
+               auto result = Validate(validation);
+               if (!result)
+               {
+                  return RestfulResult(jude_rest_Bad_Request, "Entry " + std::to_string(index) + ": " + result.error);
+               }
+            }
 
-      if (Full())
-      {
-         return RestfulResult(jude_rest_Bad_Request, "Collection '" + m_name + "' is full");
+            for (size_t index = 0; index < patches.size(); index++)
+            {
+               if (editedCopies[index].IsChanged())
+               {
+                  *storedObjects[index] = AdoptObject(editedCopies[index], ids[index]);
+                  AddNotification(notifications, *storedObjects[index], false);
+               }
+            }
+         }
+         else
+         {
+            for (size_t index = 0; index < patches.size(); index++)
+            {
+               UnshareStoredObject(*storedObjects[index], ids[index]);
+               if (jude_object_merge_data(storedObjects[index]->m_object, patches[index]->m_object))
+               {
+                  AddNotification(notifications, *storedObjects[index], false);
+               }
+            }
+         }
       }
 
-      auto &storedObject = m_objects[uuid];
-      // We create our final clone of the candidate storedObject here with the correct callbacks for editing
-      // NOTE: move-assingment to prevent the callbacks 
-      storedObject = std::move(candidateObject.Clone(false, 
-                                                [this, uuid] { OnEdited(uuid); },          // This may be called on each change to an object
-                                                [this, uuid] { OnEditCompleted(uuid); })); // This will be called when the refcount of the object is back to 1
-
-      storedObject.MarkObjectAsNew(); // a posted object is always "new"
-      PublishChangesToQueue(storedObject, false); // We've just been added
-      storedObject.ClearChangeMarkers();
-
-      return RestfulResult(uuid);
+      PublishNotifications(std::move(notifications));
+      return jude_rest_OK;
    }
 
    RestfulResult CollectionBase::RestoreEntry(std::istream& input)
@@ -507,103 +1990,439 @@ namespace jude
          return RestfulResult(jude_rest_Bad_Request, std::move(isValid.error));
       }
 
-      m_objects.erase(id);
+      {
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
+         m_objects->Erase(id);
+      }
 
       PublishChangesToQueue(resource, true);
       
       return jude_rest_No_Content;
    }
 
+   RestfulResult CollectionBase::DeleteMany(const std::vector<jude_id_t>& ids)
+   {
+      if (ContainsDuplicates(ids))
+      {
+         return RestfulResult(jude_rest_Bad_Request, "Batch contains the same id more than once");
+      }
+
+      std::vector<DeleteCandidate> candidates;
+      candidates.reserve(ids.size());
+      for (auto id : ids)
+      {
+         candidates.push_back({ id, 0 });
+      }
+
+      size_t deletedCount;
+      auto result = DeleteBatch(candidates, nullptr, true, deletedCount);
+      return result.IsOK() ? RestfulResult(jude_rest_No_Content) : result;
+   }
+
+   size_t CollectionBase::EraseIf(const std::function<bool(const Object&)>& matches)
+   {
+      // Only the ids of the matches are collected while reading - they are deleted as one batch afterwards
+      std::vector<DeleteCandidate> candidates;
+      ForEachObject([&] (const Object& object) {
+         auto id = object.Id();
+         auto version = object.Version(); // as it was when matched
+         if (matches(object))
+         {
+            candidates.push_back({ id, version });
+         }
+         return true;
+      });
+
+      size_t deletedCount = 0;
+      DeleteBatch(candidates, matches, false, deletedCount);
+      return deletedCount;
+   }
+
+   RestfulResult CollectionBase::DeleteBatch(const std::vector<DeleteCandidate>& candidates, const std::function<bool(const Object&)>& stillMatches, bool allOrNothing, size_t& deletedCount)
+   {
+      deletedCount = 0;
+      if (candidates.empty())
+      {
+         return jude_rest_OK;
+      }
+
+      std::vector<jude_id_t> ids;
+      ids.reserve(candidates.size());
+      for (const auto& candidate : candidates)
+      {
+         ids.push_back(candidate.id);
+      }
+
+      // Nobody can edit the objects while we hold their locks, so what we validate is what we delete
+      auto objectLocks = LockObjects(ids);
+
+      ids.clear();
+      for (size_t index = 0; index < candidates.size(); index++)
+      {
+         auto id = candidates[index].id;
+         auto storedObject = FindStoredObject(id);
+         if (storedObject == nullptr)
+         {
+            if (allOrNothing)
+            {
+               return RestfulResult(jude_rest_Not_Found, "Entry " + std::to_string(index) + ": not found");
+            }
+            continue;
+         }
+
+         if (  stillMatches 
+            && candidates[index].matchedVersion != 0 
+            && storedObject->Version() != candidates[index].matchedVersion
+            && !stillMatches(storedObject->Clone(false)))
+         {
+            continue; // changed since it was chosen
+         }
+
+         Validation<Object> info(*storedObject, {}, true);
+         auto isValid = Validate(info);
+         if (!isValid)
+         {
+            if (allOrNothing)
+            {
+               return RestfulResult(jude_rest_Bad_Request, "Entry " + std::to_string(index) + ": " + isValid.error);
+            }
+            continue;
+         }
+         ids.push_back(id);
+      }
+
+      std::vector<Object> removed(ids.size());
+      {
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
+         for (size_t index = 0; index < ids.size(); index++)
+         {
+            removed[index] = std::move(*m_objects->Find(ids[index]));
+            m_objects->Erase(ids[index]);
+         }
+      }
+
+      PendingNotifications notifications;
+      notifications.reserve(removed.size());
+      for (auto& object : removed)
+      {
+         AddNotification(notifications, object, true);
+      }
+      objectLocks.clear();
+
+      PublishNotifications(std::move(notifications));
+      deletedCount = removed.size();
+      return jude_rest_OK;
+   }
+
    void CollectionBase::PublishChangesToQueue(jude_id_t id)
    {
-      auto ref = m_objects.find(id);
-      bool isDeleted = (ref == m_objects.end());
+      auto storedObject = FindStoredObject(id);
+      bool isDeleted = (storedObject == nullptr);
       if (isDeleted)
       {
          return;
       }
 
-      PublishChangesToQueue(ref->second, false);
+      PublishChangesToQueue(*storedObject, false);
    }
 
    void CollectionBase::PublishChangesToQueue(Object& changedObject, bool isDeleted)
    {  
+      PendingNotifications notifications;
+      AddNotification(notifications, changedObject, isDeleted);
+      PublishNotifications(std::move(notifications));
+   }
+
+   void CollectionBase::AddNotification(PendingNotifications& notifications, Object& changedObject, bool isDeleted)
+   {
       auto id = changedObject.Id();
 
-      // Create a Notification object - this makes a read copy that captures the change markers...
-      Notification<Object> event(changedObject, [&, id] { return *GenericLock(id); }, isDeleted);
+      // Create a Notification object - this makes a read copy that captures the change markers. It is made once and
+      // shared by every subscriber and queue, and not at all if nobody is listening.
+      if (HasInterestedSubscribers(changedObject, isDeleted))
+      {
+         notifications.push_back({ id, Notification<Object>(changedObject, [this, id] { return *GenericLock(id); }, isDeleted) });
+      }
+      // Indexes must see the change markers too
+      UpdateIndexes(changedObject, isDeleted);
+      if (m_expiryInUse)
+      {
+         UpdateExpiry(id, isDeleted);
+      }
+      OnSnapshotChange(id);
+      auto version = ++m_version;
+      if (isDeleted && changedObject.RefCount() > 1)
+      {
+         // A snapshot still shares the deleted object and must not see it change
+         return;
+      }
+      if (changedObject.m_sharedRoot) // not set while a stored object is being destroyed
+      {
+         changedObject.m_sharedRoot->version = version;
+      }
       // Now we can clear the change markers of the underlying object before notifying - this helps prevent gratuitous notifications
       changedObject.ClearChangeMarkers();
+   }
+
+   bool CollectionBase::HasInterestedSubscribers(const Object& changedObject, bool isDeleted) const
+   {
+      if (m_subscriberCount == 0)
+      {
+         return false;
+      }
 
-      set<NotifyQueue*> queues;
+      auto changes = isDeleted ? FieldMask::ForFields({ JUDE_ID_FIELD_INDEX }) : changedObject.GetChanges();
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      return m_subscriberIndex.AnyInterested(changedObject.Id(), changes);
+   }
+
+   void CollectionBase::PublishNotifications(PendingNotifications&& notifications)
+   {
+      NotificationBatch batch;
+      AddToBatch(std::move(notifications), batch);
+      batch.Publish();
+   }
 
-      auto changes = event.GetChangeMask();
-      for (auto& entry : m_subscribers)
+   void CollectionBase::AddToBatch(PendingNotifications&& notifications, NotificationBatch& batch)
+   {
+      std::vector<std::pair<size_t, Subscriber>> immediateCallbacks;        // notification index and who to call
+      std::vector<std::pair<NotifyQueue*, std::vector<size_t>>> queued;    // notification indexes for each queue
+
+      // Decide who to notify under the lock but call them without it - callbacks are free to lock objects
       {
-         auto& subscriber = entry.second;
-         if (   queues.find(subscriber.queue) == queues.end()
-            && (subscriber.id == JUDE_AUTO_ID || subscriber.id == id)
-            && (subscriber.filter && changes))
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+         std::vector<uint32_t> interested;
+         for (size_t index = 0; index < notifications.size(); index++)
          {
-            if (subscriber.queue->IsImmediate())
+            interested.clear();
+            m_subscriberIndex.FindInterested(notifications[index].id, notifications[index].event.GetChangeMask(), interested);
+            for (auto subscriberId : interested)
             {
-               subscriber.callback(event);
+               auto& subscriber = m_subscribers.at(subscriberId);
+               if (subscriber.queue->IsImmediate())
+               {
+                  immediateCallbacks.emplace_back(index, subscriber.callback);
+                  continue;
+               }
+
+               // Each queue gets one message per batch, listing each notification once
+               auto queue = std::find_if(queued.begin(), queued.end(), [&] (auto& entry) { return entry.first == subscriber.queue; });
+               if (queue == queued.end())
+               {
+                  queued.emplace_back(subscriber.queue, std::vector<size_t>{ index });
+               }
+               else if (queue->second.back() != index)
+               {
+                  queue->second.push_back(index);
+               }
             }
-            else
+         }
+      }
+
+      if (immediateCallbacks.empty() && queued.empty())
+      {
+         return;
+      }
+
+      auto sharedNotifications = std::make_shared<const PendingNotifications>(std::move(notifications));
+      for (auto& call : immediateCallbacks)
+      {
+         batch.Add(NotifyQueue::Immediate, [sharedNotifications, index = call.first, callback = std::move(call.second)] {
+            callback((*sharedNotifications)[index].event);
+         });
+      }
+
+      for (auto& entry : queued)
+      {
+         auto queue = entry.first;
+         auto indexes = std::move(entry.second);
+         if (queue->IsCoalescingPerObject())
+         {
+            // Only the first change since the last delivery needs a message on the queue
+            bool needsMessage;
             {
-               // not already queued and filter is overlapping
-               queues.insert(subscriber.queue);
-               auto origin = subscriber.queue;
-               subscriber.queue->Send([=] { HandleChangesFromQueue(event, origin); });
+               std::lock_guard<std::mutex> lock(m_coalescedMutex);
+               auto& pending = m_coalesced[queue];
+               for (auto index : indexes)
+               {
+                  CoalesceNotification(pending, (*sharedNotifications)[index]);
+               }
+               needsMessage = !pending.messageSent;
+               pending.messageSent = true;
             }
+            if (needsMessage)
+            {
+               // If the queue drops the message the changes wait for the next one
+               batch.Add(*queue, [this, queue] { HandleCoalescedChangesFromQueue(queue); }, [this, queue] {
+                  std::lock_guard<std::mutex> lock(m_coalescedMutex);
+                  auto pending = m_coalesced.find(queue);
+                  if (pending != m_coalesced.end())
+                  {
+                     pending->second.messageSent = false;
+                  }
+               });
+            }
+            continue;
          }
+         batch.Add(*queue, [this, sharedNotifications, indexes, queue] { HandleChangesFromQueue(*sharedNotifications, indexes, queue); });
+      }
+   }
+
+   void CollectionBase::CoalesceNotification(CoalescedNotifications& pending, const PendingNotification& notification)
+   {
+      auto id = notification.id;
+      auto existing = pending.byId.find(id);
+      if (existing == pending.byId.end())
+      {
+         pending.order.push_back(id);
+         pending.byId.emplace(id, CoalescedChange{ notification, notification.event.GetChangeMask(), false });
+         return;
       }
+
+      // Keep the latest copy - it is only copied and marked with the earlier changes once, when delivered
+      auto changes = existing->second.changes;
+      changes |= notification.event.GetChangeMask();
+      pending.byId.erase(existing);
+      pending.byId.emplace(id, CoalescedChange{ notification, changes, true });
    }
 
-   void CollectionBase::HandleChangesFromQueue(const Notification<Object>& notification, NotifyQueue* origin)
+   void CollectionBase::HandleCoalescedChangesFromQueue(NotifyQueue* origin)
    {
-      for (auto& entry : m_subscribers)
+      std::vector<CoalescedChange> changes;
+      {
+         std::lock_guard<std::mutex> lock(m_coalescedMutex);
+         auto pending = m_coalesced.find(origin);
+         if (pending == m_coalesced.end())
+         {
+            return;
+         }
+         changes.reserve(pending->second.order.size());
+         for (auto id : pending->second.order)
+         {
+            changes.push_back(std::move(pending->second.byId.at(id)));
+         }
+         m_coalesced.erase(pending);
+      }
+
+      PendingNotifications notifications;
+      notifications.reserve(changes.size());
+      for (auto& change : changes)
       {
-         auto& subscriber = entry.second;
-         if (subscriber.queue == origin    // waitng on same queue
-            && (subscriber.filter && notification->GetChanges())) // filter overlaps
+         if (!change.merged)
          {
-            subscriber.callback(notification);
+            notifications.push_back(std::move(change.latest));
+            continue;
+         }
+
+         // The latest copy may be shared with other subscribers so we mark our own copy
+         auto id = change.latest.id;
+         auto merged = change.latest.event->Clone(false);
+         for (auto index : change.changes.AsVector())
+         {
+            if (index < merged.Type().field_count)
+            {
+               jude_object_mark_field_changed(merged.m_object, index, true);
+            }
          }
+         notifications.push_back({ id, Notification<Object>(&merged, [this, id] { return *GenericLock(id); }, change.latest.event.IsDeleted()) });
+      }
+
+      std::vector<size_t> indexes(notifications.size());
+      for (size_t index = 0; index < indexes.size(); index++)
+      {
+         indexes[index] = index;
       }
+      HandleChangesFromQueue(notifications, indexes, origin);
    }
 
-   void CollectionBase::clear()
+   void CollectionBase::HandleChangesFromQueue(const PendingNotifications& notifications, const std::vector<size_t>& indexes, NotifyQueue* origin)
    {
-      std::vector<jude_id_t> ids;
-
+      std::vector<std::pair<size_t, Subscriber>> callbacks;
       {
-         std::lock_guard<jude::Mutex> lock(*m_mutex);
-         for (const auto& id : m_objects)
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         std::vector<uint32_t> interested;
+         for (auto index : indexes)
          {
-            ids.push_back(id.first);
+            // filter overlaps - deletes only mark the id
+            interested.clear();
+            m_subscriberIndex.FindInterested(notifications[index].id, notifications[index].event.GetChangeMask(), interested);
+            for (auto subscriberId : interested)
+            {
+               auto& subscriber = m_subscribers.at(subscriberId);
+               if (subscriber.queue == origin) // waiting on same queue
+               {
+                  callbacks.emplace_back(index, subscriber.callback);
+               }
+            }
          }
       }
 
-      for (const auto& id : ids)
+      for (auto& call : callbacks)
+      {
+         call.second(notifications[call.first].event);
+      }
+   }
+
+   void CollectionBase::clear()
+   {
+      auto ids = GetIds();
+      std::vector<DeleteCandidate> candidates;
+      candidates.reserve(ids.size());
+      for (auto id : ids)
       {
-         Delete(id);
+         candidates.push_back({ id, 0 });
       }
+
+      size_t deletedCount;
+      DeleteBatch(candidates, nullptr, false, deletedCount);
    }
 
    void CollectionBase::ClearAllDataAndSubscribers()
    {
-      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      {
+         std::lock_guard<jude::Mutex> lock(*m_mutex);
 
-      m_subscribers.clear();
-      m_validators.clear();
+         m_subscribers.clear();
+         m_subscriberIndex.Clear();
+         m_subscriberCount = 0;
+         m_validators.clear();
+      }
+      {
+         std::lock_guard<std::mutex> lock(m_coalescedMutex);
+         m_coalesced.clear();
+      }
 
       clear(); 
    }
 
    size_t CollectionBase::count() const
    {
-      return m_objects.size();
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      return m_objects->Size();
+   }
+
+   bool CollectionBase::Full() const
+   {
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      return m_objects->Size() + m_reservedInserts >= m_capacity;
+   }
+
+   bool CollectionBase::ReserveInserts(size_t count)
+   {
+      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      if (m_objects->Size() + m_reservedInserts + count > m_capacity)
+      {
+         return false;
+      }
+      m_reservedInserts += count;
+      return true;
+   }
+
+   void CollectionBase::ReleaseInserts(size_t count)
+   {
+      std::lock_guard<jude::Mutex> lock(*m_mutex);
+      m_reservedInserts -= count;
    }
 
    RestfulResult CollectionBase::RestGet(const char* fullpath, std::ostream& output, const AccessControl& accessControl) const
@@ -613,18 +2432,92 @@ namespace jude
          return jude_rest_Forbidden;
       }
 
-      bool isRootPath;
-      auto resource = const_cast<CollectionBase*>(this)->LockForEditFromPath(&fullpath, isRootPath).Clone();
+      auto token = RestApiInterface::GetNextUrlToken(fullpath, &fullpath); // Note: updates fullpath to next token...
 
-      if (isRootPath) // no id token given
+      // Whole-collection reads are served from a snapshot so writers are never held up by slow readers
+      if (token.size() == 0) // no id token given
       {         
+         // Optional paging: "?count" gives the number of entries, "?after=<id>&limit=<n>" gives a page in id order
+         // Optional query: "?where=<field op value>" filters the entries, "?fields=<a,b>" chooses what is output
+         // "?aggregate=<name>" gives the totals of an aggregate added with AddAggregate() instead of the entries
+         auto query = RestApiInterface::GetUrlQuery(fullpath);
+
+         auto aggregate = query.find("aggregate");
+         if (aggregate != query.end())
+         {
+            std::lock_guard<std::mutex> lock(m_indexMutex);
+            auto found = m_aggregates.find(aggregate->second);
+            if (found == m_aggregates.end())
+            {
+               return RestfulResult(jude_rest_Not_Found, "Unknown aggregate '" + aggregate->second + "'");
+            }
+            found->second.ToJSON(output);
+            return jude_rest_OK;
+         }
+
+         CollectionQuery filter(m_rtti);
+         auto param = query.find("where");
+         if (param != query.end())
+         {
+            auto result = filter.Where(param->second);
+            if (!result)
+            {
+               return result;
+            }
+         }
+         param = query.find("fields");
+         if (param != query.end())
+         {
+            auto result = filter.Select(param->second);
+            if (!result)
+            {
+               return result;
+            }
+         }
+
+         if (query.count("count"))
+         {
+            output << (filter.HasFilter() ? FindIds(filter).size() : count());
+            return jude_rest_OK;
+         }
+
+         jude_id_t after = JUDE_INVALID_ID;
+         size_t limit = SIZE_MAX;
+         char* end;
+         param = query.find("after");
+         if (param != query.end())
+         {
+            after = (jude_id_t)strtoull(param->second.c_str(), &end, 10);
+            if (param->second.empty() || *end != '\0')
+            {
+               return RestfulResult(jude_rest_Bad_Request, "'after' must be an id");
+            }
+         }
+         param = query.find("limit");
+         if (param != query.end())
+         {
+            limit = (size_t)strtoull(param->second.c_str(), &end, 10);
+            if (param->second.empty() || *end != '\0')
+            {
+               return RestfulResult(jude_rest_Bad_Request, "'limit' must be a number");
+            }
+         }
+
          output << (Options::SerialiseCollectionAsObjectMap ? "{" : "[");
 
          bool commaNeeded = false;
+         RestfulResult result = jude_rest_OK;
+
+         auto projection = filter.HasProjection() ? AccessControl(accessControl.GetAccessLevel(), &filter.Fields().Get()) : accessControl;
+
+         // Get all resources in the collection (or the requested page)...
+         ForEachMatch(filter, [&] (const Object& resource) {
+            if (limit == 0)
+            {
+               return false;
+            }
+            limit--;
 
-         // Get all resources in the collection...
-         for (const auto& resource : m_objects)
-         {
             if (commaNeeded)
             {
                output << ',';
@@ -636,31 +2529,66 @@ namespace jude
 
             if (Options::SerialiseCollectionAsObjectMap)
             {
-               output << '"' << resource.first << "\":";
+               output << '"' << resource.Id() << "\":";
             }
 
-            auto result = resource.second.RestGet("/", output, accessControl);
-            if (!result)
-            {
-               return result;
-            }
+            result = resource.RestGet("/", output, projection);
+            return result.IsOK() && limit > 0;
+         }, after);
+
+         if (!result)
+         {
+            return result;
          }
 
          output << (Options::SerialiseCollectionAsObjectMap ? "}" : "]");
 
          return jude_rest_OK;
       }
-      else if (resource)
+
+      // Get a single resource
+      RestfulResult result = jude_rest_Not_Found;
+      ReadObject(FindObjectIdFromPath(token.c_str()), [&] (const Object& resource) {
+         result = resource.RestGet(fullpath, output, accessControl);
+      });
+      return result;
+   }
+
+   RestfulResult CollectionBase::RestGetVersion(const char* fullpath, uint64_t& version, const AccessControl& accessControl) const
+   {
+      if (accessControl.GetAccessLevel() < m_access.canRead)
+      {
+         return jude_rest_Forbidden;
+      }
+
+      auto token = RestApiInterface::GetNextUrlToken(fullpath);
+      if (token.size() == 0)
       {
-         // Get a single resource
-         return resource.RestGet(fullpath, output, accessControl);
+         version = m_version;
+         return jude_rest_OK;
       }
 
-      return jude_rest_Not_Found;
+      // Versions are per object so a path into an object changes along with the rest of it
+      RestfulResult result = jude_rest_Not_Found;
+      ReadObject(FindObjectIdFromPath(token.c_str()), [&] (const Object& resource) {
+         version = resource.Version();
+         result = jude_rest_OK;
+      });
+      return result;
    }
 
    RestfulResult CollectionBase::RestPost(const char* fullpath, std::istream& input, const AccessControl& accessControl)
    {
+      // A JSON array posted to the collection itself is added as one batch
+      if (RestApiInterface::GetNextUrlToken(fullpath, nullptr).length() == 0 && (input >> std::ws).peek() == '[')
+      {
+         if (accessControl.GetAccessLevel() < GetAccessLevel(CRUD::CREATE))
+         {
+            return jude_rest_Forbidden;
+         }
+         return RestPostMany(input, accessControl);
+      }
+
       bool isRootPath;
       auto transaction = CreateTransactionFromPath(&fullpath, isRootPath);
 
@@ -684,6 +2612,33 @@ namespace jude
       return transaction.Commit();
    }
 
+   RestfulResult CollectionBase::RestPostMany(std::istream& input, const AccessControl& accessControl)
+   {
+      std::vector<std::string> elements;
+      std::string error;
+      if (!SplitJsonArray(input, elements, error))
+      {
+         return RestfulResult(jude_rest_Bad_Request, error);
+      }
+
+      std::vector<Object> newObjects;
+      newObjects.reserve(elements.size());
+      for (size_t index = 0; index < elements.size(); index++)
+      {
+         // As for a single POST, each entry is "put" into a new object
+         Object newObject(m_rtti);
+         std::stringstream element(elements[index]);
+         auto result = newObject.RestPut("", element, accessControl);
+         if (!result)
+         {
+            return RestfulResult(result.GetCode(), "Entry " + std::to_string(index) + ": " + result.GetDetails());
+         }
+         newObjects.push_back(std::move(newObject));
+      }
+
+      return PostMany(newObjects, true, true);
+   }
+
    RestfulResult CollectionBase::RestPatch(const char* fullpath, std::istream& input, const AccessControl& accessControl)
    {
       if (accessControl.GetAccessLevel() < m_access.canUpdate)
@@ -704,6 +2659,15 @@ namespace jude
          transaction.Abort();
          return RestfulResult(jude_rest_Method_Not_Allowed, "Cannot PATCH to root of collection");
       }
+
+      // Optimistic concurrency: "?ifVersion=<n>" only applies the patch if nobody else has changed the object since
+      auto query = RestApiInterface::GetUrlQuery(fullpath);
+      auto expected = query.find("ifVersion");
+      if (expected != query.end() && expected->second != std::to_string(transaction->Version()))
+      {
+         transaction.Abort();
+         return RestfulResult(jude_rest_Precondition_Failed, "Object is not at version " + expected->second);
+      }
       
       auto result = transaction->RestPatch(fullpath, input, accessControl);
       if (!result)
@@ -830,6 +2794,8 @@ namespace jude
       std::lock_guard<jude::Mutex> lock(*m_mutex);
       auto subscriberId = ++nextSubscriberId;
       m_subscribers[subscriberId] = { filter, callback, &queue, id };
+      m_subscriberIndex.Add(subscriberId, id, filter);
+      m_subscriberCount = m_subscriberIndex.Size();
 
       return SubscriptionHandle([=] { Unsubscribe(subscriberId); });
    }
@@ -838,6 +2804,8 @@ namespace jude
    {
       std::lock_guard<jude::Mutex> lock(*m_mutex);
       m_subscribers.erase(subscriberId);
+      m_subscriberIndex.Remove(subscriberId);
+      m_subscriberCount = m_subscriberIndex.Size();
    }
 
    SubscriptionHandle CollectionBase::ValidateWith(Validatable<>::Validator callback)
@@ -892,21 +2860,25 @@ namespace jude
       std::string info = "CollectionBase " + m_name + ":\n";
       
       info += "Objects: [\n";
-      for (const auto& resource : m_objects)
-      {
+      ForEachObject([&] (const Object& resource) {
          char tmp[32];
-         snprintf(tmp, sizeof(tmp), "%" PRIjudeID " :\n", resource.first);
+         snprintf(tmp, sizeof(tmp), "%" PRIjudeID " :\n", resource.Id());
          info += tmp;
-         info += resource.second.DebugInfo();
+         info += resource.DebugInfo();
          info += "\n";
-      }
+         return true;
+      });
       info += "\n]\n";
 
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+
       info += "CollectionBase Subscribers: {\n";
       for (const auto& subscriber : m_subscribers)
       {
          info += "subscriber filter: ";
          info += DebugInfoForFilter(subscriber.second.filter.Get()).c_str();
+         info += " queue: ";
+         info += subscriber.second.queue->DebugInfo();
          info += "\n";
       }
       info += "}\n";
@@ -33,7 +33,7 @@ namespace jude
 
    CollectionBaseConstIterator::CollectionBaseConstIterator(const CollectionBase& collection, jude_id_t id, bool findNext)
       : m_collection(&collection)
-      , m_object(const_cast<CollectionBase*>(m_collection)->LockForEdit(id, findNext))
+      , m_object(m_collection->LockForRead(id, findNext))
    {}
 
    CollectionBaseConstIterator& CollectionBaseConstIterator::operator=(CollectionBaseConstIterator& rhs)
@@ -54,7 +54,7 @@ namespace jude
    {
       if (m_object)
       {
-         m_object = const_cast<CollectionBase*>(m_collection)->LockForEdit(m_object.Id(), true);
+         m_object = m_collection->LockForRead(m_object.Id(), true);
       }
       return *this;
    }
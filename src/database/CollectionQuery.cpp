@@ -0,0 +1,309 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <jude/database/CollectionQuery.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+   std::string Trim(const std::string& text)
+   {
+      auto start = text.find_first_not_of(" \t");
+      if (start == std::string::npos)
+      {
+         return "";
+      }
+      auto end = text.find_last_not_of(" \t");
+      return text.substr(start, end - start + 1);
+   }
+
+   template<typename T>
+   bool Compare(const T& lhs, jude::CollectionQuery::Operator op, const T& rhs)
+   {
+      using Operator = jude::CollectionQuery::Operator;
+      switch (op)
+      {
+      case Operator::Equal:          return lhs == rhs;
+      case Operator::NotEqual:       return lhs != rhs;
+      case Operator::Less:           return lhs < rhs;
+      case Operator::LessOrEqual:    return lhs <= rhs;
+      case Operator::Greater:        return lhs > rhs;
+      case Operator::GreaterOrEqual: return lhs >= rhs;
+      }
+      return false;
+   }
+
+   // Same walk as jude_iterator_next() - data_offset is relative to the end of the previous field
+   size_t DataOffset(const jude_rtti_t& rtti, jude_index_t index)
+   {
+      size_t offset = rtti.field_list[0].data_offset;
+      for (jude_index_t i = 1; i <= index; i++)
+      {
+         auto& previous = rtti.field_list[i - 1];
+         offset += previous.data_size * (jude_field_is_array(&previous) ? previous.array_size : 1) + rtti.field_list[i].data_offset;
+      }
+      return offset;
+   }
+
+   int64_t ReadSigned(const uint8_t* data, jude_size_t size)
+   {
+      switch (size)
+      {
+      case 1:  return *(const int8_t*)data;
+      case 2:  return *(const int16_t*)data;
+      case 4:  return *(const int32_t*)data;
+      default: return *(const int64_t*)data;
+      }
+   }
+
+   uint64_t ReadUnsigned(const uint8_t* data, jude_size_t size)
+   {
+      switch (size)
+      {
+      case 1:  return *(const uint8_t*)data;
+      case 2:  return *(const uint16_t*)data;
+      case 4:  return *(const uint32_t*)data;
+      default: return *(const uint64_t*)data;
+      }
+   }
+}
+
+namespace jude
+{
+   bool CollectionQuery::Predicate::Matches(const jude_object_t& object) const
+   {
+      if (!jude_filter_is_touched(object.__mask, field->index))
+      {
+         return false;
+      }
+
+      auto data = (const uint8_t*)&object + offset;
+      switch (field->type)
+      {
+      case JUDE_TYPE_BOOL:
+         return Compare<uint64_t>(*(const bool*)data ? 1 : 0, op, unsignedValue);
+
+      case JUDE_TYPE_SIGNED:
+      case JUDE_TYPE_ENUM:
+         return Compare(ReadSigned(data, field->data_size), op, signedValue);
+
+      case JUDE_TYPE_UNSIGNED:
+      case JUDE_TYPE_BITMASK:
+         return Compare(ReadUnsigned(data, field->data_size), op, unsignedValue);
+
+      case JUDE_TYPE_FLOAT:
+         return Compare(field->data_size == sizeof(float) ? (double)*(const float*)data : *(const double*)data, op, floatValue);
+
+      case JUDE_TYPE_STRING:
+         return Compare(strncmp((const char*)data, stringValue.c_str(), field->data_size), op, 0);
+
+      default:
+         return false;
+      }
+   }
+
+   bool CollectionQuery::Predicate::IndexKey(std::string& key) const
+   {
+      if (op != Operator::Equal)
+      {
+         return false;
+      }
+
+      // Must match Object::GetFieldAsString() for the field
+      switch (field->type)
+      {
+      case JUDE_TYPE_BOOL:     key = unsignedValue ? "true" : "false";    return true;
+      case JUDE_TYPE_SIGNED:   key = std::to_string(signedValue);         return true;
+      case JUDE_TYPE_UNSIGNED: key = std::to_string(unsignedValue);       return true;
+      case JUDE_TYPE_STRING:   key = stringValue;                         return true;
+      default:                 return false;
+      }
+   }
+
+   RestfulResult CollectionQuery::Where(const std::string& expression)
+   {
+      // Find each term - the value of a quoted string can contain " and "
+      std::vector<std::string> terms;
+      size_t start = 0;
+      bool inQuotes = false;
+      for (size_t pos = 0; pos < expression.length(); pos++)
+      {
+         if (expression[pos] == '"')
+         {
+            inQuotes = !inQuotes;
+         }
+         else if (!inQuotes && expression.compare(pos, 5, " and ") == 0)
+         {
+            terms.push_back(expression.substr(start, pos - start));
+            start = pos + 5;
+            pos += 4;
+         }
+      }
+      terms.push_back(expression.substr(start));
+
+      for (const auto& term : terms)
+      {
+         auto opStart = term.find_first_of("=!<>");
+         if (opStart == std::string::npos)
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Expected 'field op value' in '" + term + "'");
+         }
+         auto opEnd = term.find_first_not_of("=!<>", opStart);
+         auto opText = term.substr(opStart, opEnd == std::string::npos ? std::string::npos : opEnd - opStart);
+         auto fieldName = Trim(term.substr(0, opStart));
+         auto valueText = opEnd == std::string::npos ? std::string() : Trim(term.substr(opEnd));
+
+         Predicate predicate;
+         if      (opText == "=" || opText == "==") predicate.op = Operator::Equal;
+         else if (opText == "!=")                  predicate.op = Operator::NotEqual;
+         else if (opText == "<")                   predicate.op = Operator::Less;
+         else if (opText == "<=")                  predicate.op = Operator::LessOrEqual;
+         else if (opText == ">")                   predicate.op = Operator::Greater;
+         else if (opText == ">=")                  predicate.op = Operator::GreaterOrEqual;
+         else
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Unknown operator '" + opText + "'");
+         }
+
+         predicate.field = jude_rtti_find_field(&m_rtti, fieldName.c_str());
+         if (predicate.field == nullptr)
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Unknown field '" + fieldName + "'");
+         }
+
+         auto field = predicate.field;
+         if (jude_field_is_array(field) || field->type == JUDE_TYPE_OBJECT || field->type == JUDE_TYPE_BYTES)
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Can't filter on field '" + fieldName + "'");
+         }
+
+         predicate.offset = DataOffset(m_rtti, field->index);
+
+         predicate.signedValue = 0;
+         predicate.unsignedValue = 0;
+         predicate.floatValue = 0;
+
+         if (valueText.length() >= 2 && valueText.front() == '"' && valueText.back() == '"')
+         {
+            valueText = valueText.substr(1, valueText.length() - 2);
+         }
+
+         char* end = nullptr;
+         errno = 0;
+         switch (field->type)
+         {
+         case JUDE_TYPE_BOOL:
+            if (valueText != "true" && valueText != "false")
+            {
+               return RestfulResult(jude_rest_Bad_Request, "'" + fieldName + "' must be compared with true or false");
+            }
+            predicate.unsignedValue = valueText == "true";
+            break;
+
+         case JUDE_TYPE_ENUM:
+            if (auto value = jude_enum_find_value(field->details.enum_map, valueText.c_str()))
+            {
+               predicate.signedValue = *value;
+               break;
+            }
+            // fall through - enums can be given as numbers
+         case JUDE_TYPE_SIGNED:
+            predicate.signedValue = strtoll(valueText.c_str(), &end, 10);
+            break;
+
+         case JUDE_TYPE_UNSIGNED:
+         case JUDE_TYPE_BITMASK:
+            predicate.unsignedValue = strtoull(valueText.c_str(), &end, 10);
+            break;
+
+         case JUDE_TYPE_FLOAT:
+            predicate.floatValue = strtod(valueText.c_str(), &end);
+            break;
+
+         case JUDE_TYPE_STRING:
+            predicate.stringValue = valueText;
+            break;
+
+         case JUDE_TYPE_BYTES:
+         case JUDE_TYPE_OBJECT:
+         case JUDE_TYPE_NULL:
+         default:
+            break;
+         }
+
+         if (end && (valueText.empty() || *end != '\0' || errno != 0))
+         {
+            return RestfulResult(jude_rest_Bad_Request, "Invalid value for '" + fieldName + "': " + valueText);
+         }
+
+         m_predicates.push_back(std::move(predicate));
+      }
+
+      return jude_rest_OK;
+   }
+
+   RestfulResult CollectionQuery::Select(const std::string& fieldList)
+   {
+      m_fields = FieldMask::ForFields({ JUDE_ID_FIELD_INDEX });
+
+      size_t start = 0;
+      while (start <= fieldList.length())
+      {
+         auto end = fieldList.find(',', start);
+         if (end == std::string::npos)
+         {
+            end = fieldList.length();
+         }
+
+         auto fieldName = Trim(fieldList.substr(start, end - start));
+         if (!fieldName.empty())
+         {
+            auto field = jude_rtti_find_field(&m_rtti, fieldName.c_str());
+            if (field == nullptr)
+            {
+               return RestfulResult(jude_rest_Bad_Request, "Unknown field '" + fieldName + "'");
+            }
+            m_fields.Set(field->index);
+            m_fields.SetChanged(field->index);
+         }
+         start = end + 1;
+      }
+
+      m_hasProjection = true;
+      return jude_rest_OK;
+   }
+
+   bool CollectionQuery::Matches(const Object& object) const
+   {
+      for (const auto& predicate : m_predicates)
+      {
+         if (!predicate.Matches(*object.RawData()))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+}
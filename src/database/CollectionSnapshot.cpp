@@ -0,0 +1,75 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <jude/database/CollectionSnapshot.h>
+#include <algorithm>
+
+namespace jude
+{
+   namespace
+   {
+      bool IdLessThan(const CollectionSnapshot::Entry& entry, jude_id_t id) { return entry.first < id; }
+      bool IdGreaterThan(jude_id_t id, const CollectionSnapshot::Entry& entry) { return id < entry.first; }
+      bool LastIdLessThan(const std::shared_ptr<const CollectionSnapshot::Chunk>& chunk, jude_id_t id) { return chunk->back().first < id; }
+      bool IdLessThanLast(jude_id_t id, const std::shared_ptr<const CollectionSnapshot::Chunk>& chunk) { return id < chunk->back().first; }
+   }
+
+   const Object* CollectionSnapshot::Find(jude_id_t id) const
+   {
+      // The first chunk that could hold the id is the first whose last id is not less than it
+      auto chunk = std::lower_bound(m_table->chunks.begin(), m_table->chunks.end(), id, LastIdLessThan);
+      if (chunk == m_table->chunks.end())
+      {
+         return nullptr;
+      }
+
+      auto entry = std::lower_bound((*chunk)->begin(), (*chunk)->end(), id, IdLessThan);
+      if (entry == (*chunk)->end() || entry->first != id)
+      {
+         return nullptr;
+      }
+      return &entry->second;
+   }
+
+   void CollectionSnapshot::ForEach(const std::function<bool(const Object&)>& visitor, jude_id_t after) const
+   {
+      auto chunk = m_table->chunks.begin();
+      if (after != JUDE_INVALID_ID)
+      {
+         // Skip every chunk that ends at or before "after"
+         chunk = std::upper_bound(m_table->chunks.begin(), m_table->chunks.end(), after, IdLessThanLast);
+      }
+
+      for (; chunk != m_table->chunks.end(); ++chunk)
+      {
+         auto entry = (after == JUDE_INVALID_ID) ? (*chunk)->begin() : std::upper_bound((*chunk)->begin(), (*chunk)->end(), after, IdGreaterThan);
+         for (; entry != (*chunk)->end(); ++entry)
+         {
+            if (!visitor(entry->second))
+            {
+               return;
+            }
+         }
+      }
+   }
+}
@@ -302,6 +302,15 @@ namespace jude
       return fullpath ? jude_rest_Not_Found : jude_rest_Method_Not_Allowed; // method not allowed on root db object
    }
 
+   RestfulResult Database::RestGetVersion(const char* fullpath, uint64_t& version, const AccessControl& accessControl) const
+   {
+      if (auto entry = FindEntryForPath(&fullpath, accessControl.GetAccessLevel()))
+      {
+         return entry->RestGetVersion(fullpath, version, accessControl);
+      }
+      return fullpath ? jude_rest_Not_Found : jude_rest_Method_Not_Allowed; // method not allowed on root db object
+   }
+
    SubscriptionHandle Database::OnChangeToPath(
          const std::string& subscriptionPath,
          Subscriber callback,
@@ -0,0 +1,276 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/DatabaseTransaction.h>
+#include <algorithm>
+#include <mutex>
+#include <inttypes.h>
+
+namespace jude
+{
+   namespace
+   {
+      std::string PathOf(const CollectionBase& collection, jude_id_t id)
+      {
+         return "'" + collection.GetName() + "/" + std::to_string(id) + "'";
+      }
+   }
+
+   // Releases the room held for the new entries of a commit once they have been applied or abandoned
+   class DatabaseTransaction::InsertReservation
+   {
+      CollectionBase* m_collection;
+      size_t          m_count;
+
+   public:
+      InsertReservation(CollectionBase& collection, size_t count)
+         : m_collection(&collection)
+         , m_count(count)
+      {}
+
+      InsertReservation(InsertReservation&& rhs)
+         : m_collection(rhs.m_collection)
+         , m_count(rhs.m_count)
+      {
+         rhs.m_count = 0;
+      }
+
+      InsertReservation(const InsertReservation&) = delete;
+      InsertReservation& operator=(const InsertReservation&) = delete;
+      InsertReservation& operator=(InsertReservation&&) = delete;
+
+      ~InsertReservation()
+      {
+         if (m_count > 0)
+         {
+            m_collection->ReleaseInserts(m_count);
+         }
+      }
+   };
+
+   DatabaseTransaction::~DatabaseTransaction()
+   {
+      auto result = Commit();
+      if (!result)
+      {
+         // Failure in a destructor... we must at least warn!!
+         jude_debug("ERROR: Database transaction failed with '%s'", result.GetDetails().c_str());
+      }
+   }
+
+   DatabaseTransaction::Entry* DatabaseTransaction::Find(const CollectionBase& collection, jude_id_t id)
+   {
+      for (auto& entry : m_entries)
+      {
+         if (entry.collection == &collection && entry.id == id)
+         {
+            return &entry;
+         }
+      }
+      return nullptr;
+   }
+
+   Object* DatabaseTransaction::StageEdit(CollectionBase& collection, jude_id_t id)
+   {
+      if (auto entry = Find(collection, id))
+      {
+         return entry->isDeleted ? nullptr : &entry->object;
+      }
+
+      auto copy = collection.LockForRead(id);
+      if (!copy)
+      {
+         return nullptr;
+      }
+
+      auto version = copy.Version();
+      m_entries.push_back({ &collection, id, false, false, version, std::move(copy) });
+      return &m_entries.back().object;
+   }
+
+   Object* DatabaseTransaction::StagePost(CollectionBase& collection, Object& newObject)
+   {
+      if (Find(collection, newObject.Id()))
+      {
+         return nullptr;
+      }
+
+      m_entries.push_back({ &collection, newObject.Id(), true, false, 0, std::move(newObject) });
+      return &m_entries.back().object;
+   }
+
+   bool DatabaseTransaction::Delete(CollectionBase& collection, jude_id_t id)
+   {
+      if (auto entry = Find(collection, id))
+      {
+         if (entry->isNew)
+         {
+            // Posted and deleted in the same transaction - nothing to do
+            m_entries.erase(m_entries.begin() + (entry - m_entries.data()));
+            return true;
+         }
+         entry->isDeleted = true;
+         entry->object = nullptr;
+         return true;
+      }
+
+      uint64_t version = 0;
+      if (!collection.ReadObject(id, [&] (const Object& object) { version = object.Version(); }))
+      {
+         return false;
+      }
+
+      m_entries.push_back({ &collection, id, false, true, version, nullptr });
+      return true;
+   }
+
+   void DatabaseTransaction::Abort()
+   {
+      m_done = true;
+      m_entries.clear();
+   }
+
+   RestfulResult DatabaseTransaction::Commit()
+   {
+      if (m_done)
+      {
+         return jude_rest_OK;
+      }
+      m_done = true;
+
+      auto entries = std::move(m_entries);
+      if (entries.empty())
+      {
+         return jude_rest_OK;
+      }
+
+      // Collections we touch, in the order they were first used, with the notifications for each
+      std::vector<std::pair<CollectionBase*, CollectionBase::PendingNotifications>> collections;
+      for (auto& entry : entries)
+      {
+         if (std::none_of(collections.begin(), collections.end(), [&] (auto& c) { return c.first == entry.collection; }))
+         {
+            collections.emplace_back(entry.collection, CollectionBase::PendingNotifications{});
+         }
+      }
+
+      {
+         // Lock in address order so two transactions can't deadlock each other. As everywhere else,
+         // object locks are taken before collection locks (which is what ObjectMutex() is without object locking).
+         std::vector<jude::Mutex*> objectMutexes;
+         std::vector<jude::Mutex*> collectionMutexes;
+         for (auto& entry : entries)
+         {
+            auto& mutexes = entry.collection->HasObjectLocking() ? objectMutexes : collectionMutexes;
+            mutexes.push_back(&entry.collection->ObjectMutex(entry.id));
+         }
+
+         std::vector<std::unique_lock<jude::Mutex>> locks;
+         for (auto mutexes : { &objectMutexes, &collectionMutexes })
+         {
+            std::sort(mutexes->begin(), mutexes->end());
+            mutexes->erase(std::unique(mutexes->begin(), mutexes->end()), mutexes->end());
+            for (auto mutex : *mutexes)
+            {
+               locks.emplace_back(*mutex);
+            }
+         }
+
+         // Check everything before changing anything... starting with room for the new entries. The object locks don't
+         // stop other inserts so the room is held from now until everything has been applied.
+         std::vector<InsertReservation> reservations;
+         reservations.reserve(collections.size());
+         for (auto& collection : collections)
+         {
+            auto newEntries = (size_t)std::count_if(entries.begin(), entries.end(), [&] (auto& entry) { return entry.collection == collection.first && entry.isNew; });
+            if (newEntries == 0)
+            {
+               continue;
+            }
+            if (!collection.first->ReserveInserts(newEntries))
+            {
+               return RestfulResult(jude_rest_Bad_Request, "Collection '" + collection.first->GetName() + "' does not have room for " + std::to_string(newEntries) + " new entries");
+            }
+            reservations.emplace_back(*collection.first, newEntries);
+         }
+
+         for (auto& entry : entries)
+         {
+            auto storedObject = entry.collection->FindStoredObject(entry.id);
+            if (entry.isNew)
+            {
+               if (storedObject)
+               {
+                  return RestfulResult(jude_rest_Conflict, PathOf(*entry.collection, entry.id) + " already exists");
+               }
+            }
+            else if (!storedObject)
+            {
+               return RestfulResult(jude_rest_Not_Found, PathOf(*entry.collection, entry.id) + " has been deleted");
+            }
+            else if (storedObject->Version() != entry.version)
+            {
+               return RestfulResult(jude_rest_Conflict, PathOf(*entry.collection, entry.id) + " has changed since the transaction started");
+            }
+         }
+
+         // Unchanged edits are dropped so they neither validate nor notify
+         entries.erase(std::remove_if(entries.begin(), entries.end(), [] (auto& entry) {
+            return !entry.isNew && !entry.isDeleted && !entry.object.IsChanged();
+         }), entries.end());
+
+         for (auto& entry : entries)
+         {
+            if (entry.object && entry.object.Id() != entry.id)
+            {
+               jude_debug("WARNING: Transaction attempted change of id to %" PRIjudeID " - restting it to %" PRIjudeID, entry.object.Id(), entry.id);
+               entry.object.AssignId(entry.id);
+            }
+
+            auto isValid = entry.collection->ValidateChange(entry.id, entry.object, entry.isNew, entry.isDeleted);
+            if (!isValid)
+            {
+               return RestfulResult(jude_rest_Bad_Request, PathOf(*entry.collection, entry.id) + ": " + isValid.error);
+            }
+         }
+
+         // ... then apply it all
+         for (auto& entry : entries)
+         {
+            auto& notifications = std::find_if(collections.begin(), collections.end(), [&] (auto& c) { return c.first == entry.collection; })->second;
+            entry.collection->ApplyChange(entry.id, entry.object, entry.isNew, entry.isDeleted, notifications);
+         }
+      }
+
+      // One batch for everything, published without any locks held
+      NotificationBatch batch;
+      for (auto& collection : collections)
+      {
+         collection.first->AddToBatch(std::move(collection.second), batch);
+      }
+      batch.Publish();
+
+      return jude_rest_OK;
+   }
+}
@@ -0,0 +1,155 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/ExpiryWheel.h>
+
+namespace jude
+{
+   uint64_t ExpiryWheel::ToTicks(Clock::time_point time, bool roundUp) const
+   {
+      if (time <= m_start)
+      {
+         return 0;
+      }
+      auto elapsed = time - m_start;
+      uint64_t ticks = elapsed / m_resolution;
+      if (roundUp && elapsed % m_resolution != Clock::duration::zero())
+      {
+         ticks++;
+      }
+      return ticks;
+   }
+
+   void ExpiryWheel::Insert(const Entry& entry)
+   {
+      // An entry goes in the lowest level whose span covers its deadline. Higher level slots are cascaded
+      // down a level as the wheel reaches them so each entry ends up in level 0 on its deadline tick.
+      uint64_t delta = entry.deadline > m_currentTick ? entry.deadline - m_currentTick : 0;
+      for (unsigned level = 0; level < Levels; level++)
+      {
+         if (delta < (uint64_t(1) << (SlotBits * (level + 1))))
+         {
+            auto tick = entry.deadline > m_currentTick ? entry.deadline : m_currentTick;
+            m_levels[level][(tick >> (SlotBits * level)) & (Slots - 1)].push_back(entry);
+            return;
+         }
+      }
+
+      // Beyond the wheel - park it in the last top level slot to be reached and it is reinserted from there
+      auto top = Levels - 1;
+      auto slot = ((m_currentTick >> (SlotBits * top)) + Slots - 1) & (Slots - 1);
+      m_levels[top][slot].push_back(entry);
+   }
+
+   void ExpiryWheel::Arm(jude_id_t id, Clock::time_point expiry)
+   {
+      // Never in the current tick - it may already have been processed
+      auto deadline = std::max(ToTicks(expiry, true), m_currentTick + 1);
+      auto existing = m_deadlines.find(id);
+      if (existing != m_deadlines.end())
+      {
+         if (existing->second == deadline)
+         {
+            return;
+         }
+         existing->second = deadline;
+      }
+      else
+      {
+         m_deadlines.emplace(id, deadline);
+      }
+      Insert({ id, deadline });
+   }
+
+   void ExpiryWheel::Cancel(jude_id_t id)
+   {
+      m_deadlines.erase(id); // the wheel entry becomes stale
+   }
+
+   void ExpiryWheel::Advance(Clock::time_point now, std::vector<jude_id_t>& expired)
+   {
+      auto targetTick = ToTicks(now, false);
+
+      if (m_deadlines.empty())
+      {
+         // Only stale entries left - skip straight there
+         if (targetTick > m_currentTick)
+         {
+            for (auto& level : m_levels)
+            {
+               for (auto& slot : level)
+               {
+                  slot.clear();
+               }
+            }
+            m_currentTick = targetTick;
+         }
+         return;
+      }
+
+      Slot due;
+      while (m_currentTick < targetTick)
+      {
+         m_currentTick++;
+
+         // Cascade each level whose lower levels have all wrapped round
+         for (unsigned level = 1; level < Levels; level++)
+         {
+            if ((m_currentTick & ((uint64_t(1) << (SlotBits * level)) - 1)) != 0)
+            {
+               break;
+            }
+
+            due.clear();
+            due.swap(m_levels[level][(m_currentTick >> (SlotBits * level)) & (Slots - 1)]);
+            for (const auto& entry : due)
+            {
+               auto armed = m_deadlines.find(entry.id);
+               if (armed != m_deadlines.end() && armed->second == entry.deadline)
+               {
+                  Insert(entry);
+               }
+            }
+         }
+
+         auto& slot = m_levels[0][m_currentTick & (Slots - 1)];
+         for (const auto& entry : slot)
+         {
+            auto armed = m_deadlines.find(entry.id);
+            if (armed != m_deadlines.end() && armed->second == entry.deadline)
+            {
+               expired.push_back(entry.id);
+               m_deadlines.erase(armed);
+            }
+         }
+         slot.clear();
+
+         if (m_deadlines.empty())
+         {
+            m_currentTick = targetTick;
+            break;
+         }
+      }
+   }
+}
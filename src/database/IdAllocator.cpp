@@ -0,0 +1,168 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/IdAllocator.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
+
+namespace
+{
+   std::atomic<uint64_t> nextSerial{1};
+
+   struct IdBlock
+   {
+      uint64_t serial; // the allocator this block came from - 0 for none
+      uint64_t next;
+      uint64_t end;
+   };
+
+   // Each thread keeps blocks for the last few allocators it used. A destroyed allocator's block is simply
+   // overwritten later so the cache never grows - an allocator that gets pushed out just starts a new block.
+   constexpr size_t CachedBlocksPerThread = 4;
+
+   bool IsUsable(uint64_t id)
+   {
+      auto asId = (jude_id_t)id;
+      return asId != 0 && asId != JUDE_AUTO_ID && asId != JUDE_INVALID_ID;
+   }
+}
+
+namespace jude
+{
+   IdAllocator::IdAllocator()
+      : m_policy(IdPolicy::Uuid)
+      , m_blockSize(DefaultBlockSize)
+      , m_serial(nextSerial++)
+   {}
+
+   void IdAllocator::SetPolicy(IdPolicy policy, jude_id_t firstUnusedId, size_t blockSize)
+   {
+      m_policy = policy;
+      m_blockSize = blockSize > 0 ? blockSize : 1;
+      m_next = firstUnusedId > 0 ? firstUnusedId : 1;
+      m_wrapped = false;
+   }
+
+   IdPolicy IdAllocator::ActivePolicy() const
+   {
+      // Protobuf compatibility: "collection size" ids have to be unique too, so count up from the highest id in use
+      if (m_policy == IdPolicy::Uuid && Options::GenerateIDsBAsedOnCollectionSize)
+      {
+         return IdPolicy::Sequential;
+      }
+      return m_policy;
+   }
+
+   bool IdAllocator::CanCollide() const
+   {
+      if (ActivePolicy() != IdPolicy::Sequential)
+      {
+         return true;
+      }
+      // Past the end of the jude_id_t range ids start again from the bottom, where objects may still be stored
+      return m_wrapped;
+   }
+
+   jude_id_t IdAllocator::Next()
+   {
+      switch (ActivePolicy())
+      {
+      case IdPolicy::Sequential:
+         for (;;)
+         {
+            auto id = m_next++;
+            if (id == 0 || id > (uint64_t)std::numeric_limits<jude_id_t>::max())
+            {
+               m_wrapped = true;
+            }
+            if (IsUsable(id))
+            {
+               return (jude_id_t)id;
+            }
+         }
+
+      case IdPolicy::Blocks:
+      {
+         thread_local std::array<IdBlock, CachedBlocksPerThread> blocks{};
+         thread_local size_t oldest = 0;
+
+         auto block = std::find_if(blocks.begin(), blocks.end(), [this] (const IdBlock& cached) { return cached.serial == m_serial; });
+         if (block == blocks.end())
+         {
+            block = blocks.begin() + oldest;
+            oldest = (oldest + 1) % blocks.size();
+            *block = IdBlock{ m_serial, 0, 0 };
+         }
+
+         for (;;)
+         {
+            if (block->next >= block->end)
+            {
+               block->next = m_next.fetch_add(m_blockSize);
+               block->end = block->next + m_blockSize;
+            }
+            auto id = block->next++;
+            if (IsUsable(id))
+            {
+               return (jude_id_t)id;
+            }
+         }
+      }
+
+      case IdPolicy::Random:
+      {
+         thread_local std::mt19937_64 generator(std::random_device{}());
+         for (;;)
+         {
+            auto id = generator();
+            if (IsUsable(id))
+            {
+               return (jude_id_t)id;
+            }
+         }
+      }
+
+      default:
+         return jude_generate_uuid();
+      }
+   }
+
+   void IdAllocator::Observe(jude_id_t id)
+   {
+      auto policy = ActivePolicy();
+      if (policy != IdPolicy::Sequential && policy != IdPolicy::Blocks)
+      {
+         return;
+      }
+
+      // Lock free "max": only ever moves forward
+      uint64_t following = (uint64_t)id + 1;
+      auto next = m_next.load();
+      while (next < following && !m_next.compare_exchange_weak(next, following))
+      {
+      }
+   }
+}
@@ -0,0 +1,238 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <jude/database/ObjectStore.h>
+#include <algorithm>
+
+namespace jude
+{
+   std::unique_ptr<ObjectStore> ObjectStore::Create(StoragePolicy policy)
+   {
+      switch (policy)
+      {
+      case StoragePolicy::Hashed:  return std::make_unique<HashedObjectStore>();
+      case StoragePolicy::Ordered: return std::make_unique<OrderedObjectStore>();
+      case StoragePolicy::Tiered:  return nullptr; // needs a spill file - see TieredObjectStore
+      }
+      return std::make_unique<OrderedObjectStore>();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////////
+   // OrderedObjectStore
+   /////////////////////////////////////////////////////////////////////////////////
+   Object* OrderedObjectStore::Find(jude_id_t id)
+   {
+      auto it = m_objects.find(id);
+      return it == m_objects.end() ? nullptr : &it->second;
+   }
+
+   const Object* OrderedObjectStore::Find(jude_id_t id) const
+   {
+      auto it = m_objects.find(id);
+      return it == m_objects.end() ? nullptr : &it->second;
+   }
+
+   Object& OrderedObjectStore::Insert(jude_id_t id)
+   {
+      return m_objects[id];
+   }
+
+   bool OrderedObjectStore::Erase(jude_id_t id)
+   {
+      return m_objects.erase(id) > 0;
+   }
+
+   jude_id_t OrderedObjectStore::NextId(jude_id_t id) const
+   {
+      auto it = (id == JUDE_INVALID_ID) ? m_objects.begin() : m_objects.upper_bound(id);
+      return it == m_objects.end() ? JUDE_INVALID_ID : it->first;
+   }
+
+   void OrderedObjectStore::ForEach(const Visitor& visitor, jude_id_t after) const
+   {
+      auto it = (after == JUDE_INVALID_ID) ? m_objects.begin() : m_objects.upper_bound(after);
+      for (; it != m_objects.end(); ++it)
+      {
+         if (!visitor(it->second))
+         {
+            return;
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////////
+   // HashedObjectStore
+   /////////////////////////////////////////////////////////////////////////////////
+   size_t HashedObjectStore::SlotFor(jude_id_t id) const
+   {
+      // ids are often sequential so mix the bits before masking (murmur3 finaliser)
+      uint64_t hash = (uint64_t)id;
+      hash ^= hash >> 33;
+      hash *= 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 33;
+      return (size_t)hash & (m_slots.size() - 1);
+   }
+
+   // Returns the slot holding the id or the empty slot where it would be inserted
+   size_t HashedObjectStore::FindSlot(jude_id_t id) const
+   {
+      auto mask = m_slots.size() - 1;
+      auto slot = SlotFor(id);
+      while (m_slots[slot].entry != EmptySlot && m_slots[slot].id != id)
+      {
+         slot = (slot + 1) & mask;
+      }
+      return slot;
+   }
+
+   void HashedObjectStore::Grow()
+   {
+      std::vector<Slot> oldSlots(std::max<size_t>(16, m_slots.size() * 2), Slot{ 0, EmptySlot });
+      oldSlots.swap(m_slots);
+
+      for (const auto& slot : oldSlots)
+      {
+         if (slot.entry != EmptySlot)
+         {
+            m_slots[FindSlot(slot.id)] = slot;
+         }
+      }
+   }
+
+   Object* HashedObjectStore::Find(jude_id_t id)
+   {
+      return const_cast<Object*>(static_cast<const HashedObjectStore*>(this)->Find(id));
+   }
+
+   const Object* HashedObjectStore::Find(jude_id_t id) const
+   {
+      if (m_size == 0)
+      {
+         return nullptr;
+      }
+
+      auto& slot = m_slots[FindSlot(id)];
+      return slot.entry == EmptySlot ? nullptr : &m_entries[slot.entry];
+   }
+
+   Object& HashedObjectStore::Insert(jude_id_t id)
+   {
+      // Keep the load factor below 3/4 so probe sequences stay short
+      if ((m_size + 1) * 4 > m_slots.size() * 3)
+      {
+         Grow();
+      }
+
+      auto& slot = m_slots[FindSlot(id)];
+      if (slot.entry != EmptySlot)
+      {
+         return m_entries[slot.entry];
+      }
+
+      if (m_freeEntries.empty())
+      {
+         slot.entry = (uint32_t)m_entries.size();
+         m_entries.emplace_back();
+      }
+      else
+      {
+         slot.entry = m_freeEntries.back();
+         m_freeEntries.pop_back();
+      }
+      slot.id = id;
+      m_size++;
+
+      // Ids are commonly allocated in ascending order, which only appends
+      m_orderedIds.insert(std::upper_bound(m_orderedIds.begin(), m_orderedIds.end(), id), id);
+
+      return m_entries[slot.entry];
+   }
+
+   bool HashedObjectStore::Erase(jude_id_t id)
+   {
+      if (m_size == 0)
+      {
+         return false;
+      }
+
+      auto hole = FindSlot(id);
+      auto entry = m_slots[hole].entry;
+      if (entry == EmptySlot)
+      {
+         return false;
+      }
+
+      // Take the object out but only release it once the store is consistent again,
+      // as releasing the last reference can call back into the collection
+      Object erased(std::move(m_entries[entry]));
+      m_entries[entry] = nullptr;
+      m_freeEntries.push_back(entry);
+      m_size--;
+
+      // Backward shift deletion - move any displaced entries into the hole so lookups need no tombstones
+      auto mask = m_slots.size() - 1;
+      auto next = hole;
+      for (;;)
+      {
+         next = (next + 1) & mask;
+         if (m_slots[next].entry == EmptySlot)
+         {
+            break;
+         }
+
+         auto home = SlotFor(m_slots[next].id);
+         bool canMove = (next > hole) ? (home <= hole || home > next)
+                                      : (home <= hole && home > next);
+         if (canMove)
+         {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+         }
+      }
+      m_slots[hole].entry = EmptySlot;
+
+      m_orderedIds.erase(std::lower_bound(m_orderedIds.begin(), m_orderedIds.end(), id));
+
+      return true;
+   }
+
+   jude_id_t HashedObjectStore::NextId(jude_id_t id) const
+   {
+      auto& ids = m_orderedIds;
+      auto it = (id == JUDE_INVALID_ID) ? ids.begin() : std::upper_bound(ids.begin(), ids.end(), id);
+      return it == ids.end() ? JUDE_INVALID_ID : *it;
+   }
+
+   void HashedObjectStore::ForEach(const Visitor& visitor, jude_id_t after) const
+   {
+      auto& ids = m_orderedIds;
+      auto it = (after == JUDE_INVALID_ID) ? ids.begin() : std::upper_bound(ids.begin(), ids.end(), after);
+      for (; it != ids.end(); ++it)
+      {
+         if (!visitor(*Find(*it)))
+         {
+            return;
+         }
+      }
+   }
+}
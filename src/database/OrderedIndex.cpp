@@ -0,0 +1,206 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/OrderedIndex.h>
+#include <cstring>
+
+namespace
+{
+   void AppendBigEndian(std::string& key, uint64_t value, size_t bytes)
+   {
+      for (size_t byte = bytes; byte > 0; byte--)
+      {
+         key.push_back((char)(uint8_t)(value >> (8 * (byte - 1))));
+      }
+   }
+}
+
+namespace jude
+{
+   bool OrderedIndex::CanOrder(const jude_field_t& field)
+   {
+      if (jude_field_is_array(&field))
+      {
+         return false;
+      }
+
+      switch (field.type)
+      {
+      case JUDE_TYPE_BOOL:
+      case JUDE_TYPE_SIGNED:
+      case JUDE_TYPE_UNSIGNED:
+      case JUDE_TYPE_ENUM:
+      case JUDE_TYPE_BITMASK:
+      case JUDE_TYPE_FLOAT:
+      case JUDE_TYPE_STRING:
+         return true;
+
+      default:
+         return false;
+      }
+   }
+
+   bool OrderedIndex::ReadKey(const jude_field_t& field, const Object& object, std::string& key)
+   {
+      key.clear();
+      if (!object.Has(field.index))
+      {
+         return false;
+      }
+
+      if (field.type == JUDE_TYPE_STRING)
+      {
+         key = object.GetFieldAsString(field.index);
+         return true;
+      }
+
+      auto data = (const uint8_t*)jude_object_get_value_in_array(const_cast<jude_object_t*>(object.RawData()), field.index, 0);
+      if (data == nullptr)
+      {
+         return false;
+      }
+
+      switch (field.type)
+      {
+      case JUDE_TYPE_BOOL:
+         key.push_back(*(const bool*)data ? 1 : 0);
+         return true;
+
+      case JUDE_TYPE_SIGNED:
+      case JUDE_TYPE_ENUM:
+      {
+         int64_t value;
+         switch (field.data_size)
+         {
+         case 1:  value = *(const int8_t*)data;  break;
+         case 2:  value = *(const int16_t*)data; break;
+         case 4:  value = *(const int32_t*)data; break;
+         default: value = *(const int64_t*)data; break;
+         }
+         AppendBigEndian(key, (uint64_t)value ^ 0x8000000000000000ull, 8); // flipping the sign bit puts negatives first
+         return true;
+      }
+
+      case JUDE_TYPE_UNSIGNED:
+      case JUDE_TYPE_BITMASK:
+      {
+         uint64_t value;
+         switch (field.data_size)
+         {
+         case 1:  value = *(const uint8_t*)data;  break;
+         case 2:  value = *(const uint16_t*)data; break;
+         case 4:  value = *(const uint32_t*)data; break;
+         default: value = *(const uint64_t*)data; break;
+         }
+         AppendBigEndian(key, value, 8);
+         return true;
+      }
+
+      case JUDE_TYPE_FLOAT:
+      {
+         double value = field.data_size == sizeof(float) ? *(const float*)data : *(const double*)data;
+         uint64_t bits;
+         memcpy(&bits, &value, sizeof(bits));
+         // Negative numbers order backwards so flip all their bits, positive ones just need the sign bit set
+         bits = (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+         AppendBigEndian(key, bits, 8);
+         return true;
+      }
+
+      default:
+         return false;
+      }
+   }
+
+   void OrderedIndex::Update(const Object& object)
+   {
+      auto id = object.Id();
+      std::string key;
+      if (!ReadKey(m_field, object, key))
+      {
+         Remove(id);
+         return;
+      }
+
+      auto existing = m_keyById.find(id);
+      if (existing != m_keyById.end())
+      {
+         if (existing->second == key)
+         {
+            return;
+         }
+         Remove(id);
+      }
+
+      m_order.emplace(key, id);
+      m_keyById.emplace(id, std::move(key));
+   }
+
+   void OrderedIndex::Remove(jude_id_t id)
+   {
+      auto existing = m_keyById.find(id);
+      if (existing == m_keyById.end())
+      {
+         return;
+      }
+
+      m_order.erase({ existing->second, id });
+      m_keyById.erase(existing);
+   }
+
+   bool OrderedIndex::Next(std::vector<jude_id_t>& ids, size_t count, bool descending, Cursor& cursor) const
+   {
+      auto position = std::make_pair(cursor.key, cursor.id);
+      size_t added = 0;
+
+      if (!descending)
+      {
+         auto it = cursor.started ? m_order.upper_bound(position) : m_order.begin();
+         for (; it != m_order.end() && added < count; ++it, ++added)
+         {
+            ids.push_back(it->second);
+            position = *it;
+         }
+      }
+      else
+      {
+         auto it = cursor.started ? m_order.lower_bound(position) : m_order.end();
+         while (it != m_order.begin() && added < count)
+         {
+            --it;
+            ids.push_back(it->second);
+            position = *it;
+            added++;
+         }
+      }
+
+      if (added > 0)
+      {
+         cursor.started = true;
+         cursor.key = std::move(position.first);
+         cursor.id = position.second;
+      }
+      return added == count;
+   }
+}
@@ -23,33 +23,13 @@
  */
 
 #include <jude/database/Relationships.h>
+#include <algorithm>
+#include <utility>
 
 namespace jude 
 {
    namespace detail
    {
-      void CheckForDeletion(const Notification<Object>& notification, Relationships::ReferenceId reference)
-      {
-         std::vector<jude_id_t> idsToDelete;
-         // find all resources that reference the id that has just been deleted
-         for (auto& resource : reference.collection)
-         {
-            if (!resource.Has(reference.fieldIndex))
-               continue;
-
-            auto referenceId = resource.GetFieldAsNumber<jude_id_t>(reference.fieldIndex);
-            if (referenceId == notification->Id())
-            {
-               idsToDelete.push_back(resource.Id());
-            }
-         }
-
-         for (auto& id : idsToDelete)
-         {
-            reference.collection.Delete(id);
-         }            
-      }
-
       std::vector<jude_id_t> GetAllValues(const Object& resource, jude_index_t fieldIndex)
       {
          std::vector<jude_id_t> values;
@@ -60,12 +40,22 @@ namespace jude
          return values;
       }
 
+      void CheckForDeletion(const Notification<Object>& notification, const Relationships::ReferenceIndex& index)
+      {
+         // delete all resources that reference the id that has just been deleted
+         for (auto& id : index.ReferrersOf(notification->Id()))
+         {
+            index.reference.collection.Delete(id);
+         }            
+      }
+
       ValidationResult ValidateReference(
          Notification<Object>& changedObject, 
-         Relationships::ReferenceId referencePath, 
+         const Relationships::ReferenceIndex& index, 
          CollectionBase& targetCollection,
          bool allowMulitpleReferencesToOneTarget)
       {
+         const auto& referencePath = index.reference;
          if (changedObject.IsDeleted() || !changedObject->IsChanged(referencePath.fieldIndex))
          { 
             return true; // not interested in deleted resource or if the path field is not changed
@@ -114,45 +104,49 @@ namespace jude
          }
 
          // Check for duplicate references in other members of reference collection
-         for (const auto& other : referencePath.collection)
+         for (auto id : changedIdList)
          {
-            if (other.Id() == changedObject->Id())
+            for (auto otherId : index.ReferrersOf((jude_id_t)id))
             {
-               continue;
-            }
-
-            for (auto& id : GetAllValues(other, referencePath.fieldIndex))
-            {
-               if (changedIdList.find(id) != changedIdList.end())
+               if (otherId == changedObject->Id())
                {
-                  char errorBuffer[128];
-                  std::string idString = changedObject.IsNew() ? "<new>" : std::to_string(changedObject->Id()).c_str();
-                  snprintf(errorBuffer, sizeof(errorBuffer),
-                     "'%s/%s/%s' and '%s/%" PRIjudeID "/%s' have duplucate id: %" PRIjudeID,
-                     referencePath.collection.GetName().c_str(),
-                     idString.c_str(),
-                     changedObject->Type().field_list[referencePath.fieldIndex].label,
-                     referencePath.collection.GetName().c_str(),
-                     other.Id(),
-                     changedObject->Type().field_list[referencePath.fieldIndex].label,
-                     id);
-                  return errorBuffer;
+                  continue;
                }
+
+               char errorBuffer[128];
+               std::string idString = changedObject.IsNew() ? "<new>" : std::to_string(changedObject->Id()).c_str();
+               snprintf(errorBuffer, sizeof(errorBuffer),
+                  "'%s/%s/%s' and '%s/%" PRIjudeID "/%s' have duplucate id: %" PRIjudeID,
+                  referencePath.collection.GetName().c_str(),
+                  idString.c_str(),
+                  changedObject->Type().field_list[referencePath.fieldIndex].label,
+                  referencePath.collection.GetName().c_str(),
+                  otherId,
+                  changedObject->Type().field_list[referencePath.fieldIndex].label,
+                  (jude_id_t)id);
+               return errorBuffer;
             }
          }
          return true;
       }
 
-      void ClearReferenceFieldIfNecessary(const Notification<Object>& notification, Relationships::ReferenceId referencePath)
+      void ClearReferenceFieldIfNecessary(const Notification<Object>& notification, const Relationships::ReferenceIndex& index)
       {     
-         // clear all instances of the reference id in this collection
-         for (auto& resource : referencePath.collection)
+         // clear all instances of the reference id in the objects that refer to it
+         const auto& referencePath = index.reference;
+         for (auto id : index.ReferrersOf(notification->Id()))
          {
-            for (jude_index_t arrayIndex = 0; arrayIndex < resource.CountField(referencePath.fieldIndex); arrayIndex++)
+            auto resource = referencePath.collection.GenericLock(id);
+            if (!resource)
+            {
+               continue;
+            }
+
+            for (jude_index_t arrayIndex = 0; arrayIndex < resource->CountField(referencePath.fieldIndex); arrayIndex++)
             {
-               if (resource.GetFieldAsNumber<jude_id_t>(referencePath.fieldIndex, arrayIndex) == notification->Id())
+               if (resource->GetFieldAsNumber<jude_id_t>(referencePath.fieldIndex, arrayIndex) == notification->Id())
                {
-                  resource.Clear(referencePath.fieldIndex, arrayIndex);
+                  resource->Clear(referencePath.fieldIndex, arrayIndex);
                   arrayIndex--;
                }
             }
@@ -161,6 +155,110 @@ namespace jude
 
    }
 
+   void Relationships::ReferenceIndex::RemoveLocked(jude_id_t referrerId)
+   {
+      auto targets = m_targetsOf.find(referrerId);
+      if (targets == m_targetsOf.end())
+      {
+         return;
+      }
+
+      for (auto targetId : targets->second)
+      {
+         auto referrers = m_referrers.find(targetId);
+         if (referrers != m_referrers.end())
+         {
+            referrers->second.erase(referrerId);
+            if (referrers->second.empty())
+            {
+               m_referrers.erase(referrers);
+            }
+         }
+      }
+      m_targetsOf.erase(targets);
+   }
+
+   void Relationships::ReferenceIndex::Update(const Object& referrer)
+   {
+      auto targets = detail::GetAllValues(referrer, reference.fieldIndex);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      RemoveLocked(referrer.Id());
+      if (targets.empty())
+      {
+         return;
+      }
+
+      for (auto targetId : targets)
+      {
+         m_referrers[targetId][referrer.Id()]++;
+      }
+      m_targetsOf.emplace(referrer.Id(), std::move(targets));
+   }
+
+   void Relationships::ReferenceIndex::Remove(jude_id_t referrerId)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      RemoveLocked(referrerId);
+   }
+
+   std::vector<jude_id_t> Relationships::ReferenceIndex::ReferrersOf(jude_id_t targetId) const
+   {
+      std::vector<jude_id_t> ids;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         auto referrers = m_referrers.find(targetId);
+         if (referrers == m_referrers.end())
+         {
+            return ids;
+         }
+         for (const auto& referrer : referrers->second)
+         {
+            ids.push_back(referrer.first);
+         }
+      }
+      std::sort(ids.begin(), ids.end());
+      return ids;
+   }
+
+   std::shared_ptr<Relationships::ReferenceIndex> Relationships::IndexOf(ReferenceId reference)
+   {
+      for (const auto& index : m_referenceIndexes)
+      {
+         if (&index->reference.collection == &reference.collection && index->reference.fieldIndex == reference.fieldIndex)
+         {
+            return index;
+         }
+      }
+
+      auto index = std::make_shared<ReferenceIndex>(reference);
+
+      // Subscribe before reading what is there already so no change is missed
+      m_subscribers.push_back(
+         reference.collection.OnChangeToObject(
+            [index](const Notification<Object>& notification) {
+               if (notification.IsDeleted())
+               {
+                  index->Remove(notification->Id());
+               }
+               else
+               {
+                  index->Update(*notification);
+               }
+            },
+            FieldMask::ForFields({ JUDE_ID_FIELD_INDEX, reference.fieldIndex }),
+            NotifyQueue::Immediate)
+      );
+
+      for (const auto& resource : std::as_const(reference.collection))
+      {
+         index->Update(resource);
+      }
+
+      m_referenceIndexes.push_back(index);
+      return index;
+   }
+
    void Relationships::DeleteTogether(CollectionBase& collection1, CollectionBase& collection2)
    {
       m_subscribers.push_back(collection1.OnObjectDeleted([&](const Notification<Object>& notification) { 
@@ -176,10 +274,11 @@ namespace jude
 
    void Relationships::CascadeDelete(jude::CollectionBase& from, ReferenceId to)
    {
+      auto index = IndexOf(to);
       m_subscribers.push_back(
          from.OnObjectDeleted(
-            [=](const Notification<Object>& notification) { 
-               detail::CheckForDeletion(notification, to);
+            [index](const Notification<Object>& notification) { 
+               detail::CheckForDeletion(notification, *index);
             },
             "",
             NotifyQueue::Immediate)
@@ -188,20 +287,22 @@ namespace jude
 
    void Relationships::EnforceReference(ReferenceId from, jude::CollectionBase& to, bool allowMultipleReferences)
    {
+      auto index = IndexOf(from);
+
       // if the field in "from" is changed, ensure it exists in the "to" collection
       m_subscribers.push_back(
          from.collection.ValidateWith( 
-            [from, allowMultipleReferences, &to](Notification<Object>& resource)
+            [index, allowMultipleReferences, &to](Notification<Object>& resource)
             { 
-               return detail::ValidateReference(resource, from, to, allowMultipleReferences);
+               return detail::ValidateReference(resource, *index, to, allowMultipleReferences);
             })
       );
 
       // If a resource is removed in "to" collection, scrub field in "from" path
       m_subscribers.push_back(
          to.OnObjectDeleted(
-            [from](const Notification<Object>& notification) { 
-               detail::ClearReferenceFieldIfNecessary(notification, from);
+            [index](const Notification<Object>& notification) { 
+               detail::ClearReferenceFieldIfNecessary(notification, *index);
             }, 
             "",
             NotifyQueue::Immediate)
@@ -25,6 +25,7 @@
 #include <jude/database/Swagger.h>
 #include <algorithm>
 #include <mutex>
+#include <shared_mutex>
 #include <set>
 #include <sstream>
 
@@ -54,12 +55,10 @@ namespace jude
    void GenericResource::OnEditCompleted()
    {
       PublishChangesToQueue();
-      
-      if (m_object.RefCount() == 2)
-      {
-         // About to become single reference again
-         m_mutex->unlock();
-      }
+
+      // Back to a single reference - release the lock taken in GenericLock().
+      // Only called while the edit lock is held, see Object::ReleaseSharedData()
+      m_mutex->unlock();
    }
 
    RestApiSecurityLevel::Value GenericResource::GetAccessLevel(CRUD crud) const
@@ -240,55 +239,81 @@ namespace jude
 
    void GenericResource::PublishChangesToQueue()
    {
+      std::vector<Subscriber> immediateCallbacks;
+      std::vector<NotifyQueue*> queues; // almost always one or two
+
+      // Decide who to notify under the lock but call them without it - callbacks are free to lock the resource
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
+      if (m_subscribers.empty())
+      {
+         m_object.ClearChangeMarkers(); // no need for a copy
+         return;
+      }
+
       Notification<Object> notification(m_object, [&] { return GenericLock(); });
       m_object.ClearChangeMarkers();
-      set<NotifyQueue*> queues;
 
       auto changes = notification.GetChangeMask();
       for (auto& entry : m_subscribers)
       {
          auto& subscriber = entry.second;
-         if (  queues.find(subscriber.queue) == queues.end()
-            && (subscriber.filter && changes)
-            )
+         if (subscriber.filter && changes)
          {
             if (subscriber.queue->IsImmediate())
             {
-               subscriber.callback(notification);
+               immediateCallbacks.push_back(subscriber.callback);
             }
-            else
+            else if (std::find(queues.begin(), queues.end(), subscriber.queue) == queues.end())
             {
                // not already queued and filter is overlapping
-               queues.insert(subscriber.queue);
-               auto origin = subscriber.queue;
-               subscriber.queue->Send([=] { HandleChangesFromQueue(notification, origin); });
+               queues.push_back(subscriber.queue);
             }
          }
       }
+      lock.unlock();
+
+      for (auto& callback : immediateCallbacks)
+      {
+         callback(notification);
+      }
+      for (auto queue : queues)
+      {
+         queue->Send([=] { HandleChangesFromQueue(notification, queue); });
+      }
    }
 
    void GenericResource::HandleChangesFromQueue(const Notification<Object> notification, NotifyQueue *origin)
    {
-      for (auto& entry : m_subscribers)
+      std::vector<Subscriber> callbacks;
       {
-         auto& subscriber = entry.second;
-         if (subscriber.queue == origin    // waitng on same queue
-            && (subscriber.filter && notification->GetChanges()) // filter overlaps
-            ) 
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         for (auto& entry : m_subscribers)
          {
-            subscriber.callback(notification);
+            auto& subscriber = entry.second;
+            if (subscriber.queue == origin    // waitng on same queue
+               && (subscriber.filter && notification->GetChanges()) // filter overlaps
+               ) 
+            {
+               callbacks.push_back(subscriber.callback);
+            }
          }
-      }      
+      }
+
+      for (auto& callback : callbacks)
+      {
+         callback(notification);
+      }
    }
 
    Object GenericResource::GenericLock()
    {
       std::lock_guard<jude::Mutex> lock(*m_mutex);
 
-      if (m_object.RefCount() == 1)
+      if (!m_object.m_sharedRoot->editLocked)
       {
-         // First time lock...
+         // First time lock... released by OnEditCompleted() once the last editable copy is dropped
          m_mutex->lock();
+         m_object.m_sharedRoot->editLocked = true;
       }
 
       return m_object;
@@ -310,6 +335,7 @@ namespace jude
 
    std::vector<std::string> GenericResource::SearchForPath(CRUD operationType, const char* pathPrefix, jude_size_t maxPaths, RestApiSecurityLevel::Value userLevel) const
    {
+      std::shared_lock<jude::Mutex> lock(*m_mutex);
       return m_object.SearchForPath(operationType, pathPrefix, maxPaths, userLevel);
    }
 
@@ -334,7 +360,14 @@ namespace jude
          return jude_rest_Forbidden;
       }
 
-      return m_object.Clone().RestGet(fullpath, output, accessControl);
+      // Readers only need the shared side of the lock to take their copy so concurrent GETs do not serialise.
+      // Serialise from the copy: it has no callbacks so child objects made while writing can't re-enter OnEditCompleted()
+      Object copy(nullptr);
+      {
+         std::shared_lock<jude::Mutex> lock(*m_mutex);
+         copy = m_object.Clone();
+      }
+      return copy.RestGet(fullpath, output, accessControl);
    }
 
    RestfulResult ApplyAndCommit(Transaction<Object>& transaction, RestfulResult initialResult)
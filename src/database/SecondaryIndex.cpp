@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <jude/database/SecondaryIndex.h>
+#include <algorithm>
+
+namespace jude
+{
+   void SecondaryIndex::Update(const Object& object)
+   {
+      auto id = object.Id();
+      auto value = object.GetFieldAsString(m_field.index);
+
+      auto existing = m_valueById.find(id);
+      if (existing != m_valueById.end())
+      {
+         if (existing->second == value)
+         {
+            return;
+         }
+         Remove(id);
+      }
+
+      auto& ids = m_idsByValue[value];
+      ids.insert(std::upper_bound(ids.begin(), ids.end(), id), id);
+      m_valueById.emplace(id, std::move(value));
+   }
+
+   void SecondaryIndex::Remove(jude_id_t id)
+   {
+      auto existing = m_valueById.find(id);
+      if (existing == m_valueById.end())
+      {
+         return;
+      }
+
+      auto bucket = m_idsByValue.find(existing->second);
+      if (bucket != m_idsByValue.end())
+      {
+         auto& ids = bucket->second;
+         auto it = std::lower_bound(ids.begin(), ids.end(), id);
+         if (it != ids.end() && *it == id)
+         {
+            ids.erase(it);
+         }
+         if (ids.empty())
+         {
+            m_idsByValue.erase(bucket);
+         }
+      }
+
+      m_valueById.erase(existing);
+   }
+
+   const std::vector<jude_id_t>* SecondaryIndex::Find(const std::string& value) const
+   {
+      auto bucket = m_idsByValue.find(value);
+      return bucket == m_idsByValue.end() ? nullptr : &bucket->second;
+   }
+}
@@ -0,0 +1,190 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+
+#include <jude/database/SubscriberIndex.h>
+
+namespace jude
+{
+   void SubscriberIndex::Add(uint32_t subscriberId, jude_id_t id, const FieldMask& filter)
+   {
+      Remove(subscriberId);
+
+      if (id != JUDE_AUTO_ID)
+      {
+         m_entries[subscriberId] = { id, filter, 0 };
+         m_byId[id].push_back(subscriberId);
+         return;
+      }
+
+      size_t slot;
+      if (m_freeSlots.empty())
+      {
+         slot = m_slots.size();
+         m_slots.push_back(subscriberId);
+      }
+      else
+      {
+         slot = m_freeSlots.back();
+         m_freeSlots.pop_back();
+         m_slots[slot] = subscriberId;
+      }
+      m_entries[subscriberId] = { id, filter, slot };
+
+      auto word = slot / 64;
+      auto bit = uint64_t(1) << (slot % 64);
+      for (auto field : filter.AsVector())
+      {
+         auto& bitmap = m_fieldBitmaps[field];
+         if (bitmap.size() <= word)
+         {
+            bitmap.resize(word + 1, 0);
+         }
+         bitmap[word] |= bit;
+      }
+   }
+
+   void SubscriberIndex::Remove(uint32_t subscriberId)
+   {
+      auto entry = m_entries.find(subscriberId);
+      if (entry == m_entries.end())
+      {
+         return;
+      }
+
+      if (entry->second.id != JUDE_AUTO_ID)
+      {
+         auto subscribers = m_byId.find(entry->second.id);
+         auto& list = subscribers->second;
+         list.erase(std::find(list.begin(), list.end(), subscriberId));
+         if (list.empty())
+         {
+            m_byId.erase(subscribers);
+         }
+      }
+      else
+      {
+         auto slot = entry->second.slot;
+         auto word = slot / 64;
+         auto bit = uint64_t(1) << (slot % 64);
+         for (auto field : entry->second.filter.AsVector())
+         {
+            m_fieldBitmaps[field][word] &= ~bit;
+         }
+         m_freeSlots.push_back(slot);
+      }
+      m_entries.erase(entry);
+   }
+
+   void SubscriberIndex::Clear()
+   {
+      m_entries.clear();
+      m_byId.clear();
+      m_slots.clear();
+      m_freeSlots.clear();
+      for (auto& bitmap : m_fieldBitmaps)
+      {
+         bitmap.clear();
+      }
+   }
+
+   void SubscriberIndex::FindInterested(jude_id_t id, const FieldMask& changes, std::vector<uint32_t>& subscriberIds) const
+   {
+      auto firstFound = subscriberIds.size();
+
+      auto subscribers = m_byId.find(id);
+      if (subscribers != m_byId.end())
+      {
+         for (auto subscriberId : subscribers->second)
+         {
+            if (m_entries.at(subscriberId).filter && changes)
+            {
+               subscriberIds.push_back(subscriberId);
+            }
+         }
+      }
+
+      if (!m_slots.empty())
+      {
+         auto changedFields = changes.AsVector();
+         auto words = (m_slots.size() + 63) / 64;
+         for (size_t word = 0; word < words; word++)
+         {
+            uint64_t interested = 0;
+            for (auto field : changedFields)
+            {
+               auto& bitmap = m_fieldBitmaps[field];
+               if (word < bitmap.size())
+               {
+                  interested |= bitmap[word];
+               }
+            }
+
+            for (size_t bit = 0; interested; bit++, interested >>= 1)
+            {
+               if (interested & 1)
+               {
+                  subscriberIds.push_back(m_slots[word * 64 + bit]);
+               }
+            }
+         }
+      }
+
+      // subscriber ids are handed out in increasing order
+      std::sort(subscriberIds.begin() + firstFound, subscriberIds.end());
+   }
+
+   bool SubscriberIndex::AnyInterested(jude_id_t id, const FieldMask& changes) const
+   {
+      auto subscribers = m_byId.find(id);
+      if (subscribers != m_byId.end())
+      {
+         for (auto subscriberId : subscribers->second)
+         {
+            if (m_entries.at(subscriberId).filter && changes)
+            {
+               return true;
+            }
+         }
+      }
+
+      if (m_slots.size() == m_freeSlots.size())
+      {
+         return false; // no wildcard subscribers
+      }
+
+      for (auto field : changes.AsVector())
+      {
+         for (auto word : m_fieldBitmaps[field])
+         {
+            if (word)
+            {
+               return true;
+            }
+         }
+      }
+      return false;
+   }
+}
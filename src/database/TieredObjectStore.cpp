@@ -0,0 +1,327 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2022 James Parker
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <jude/database/TieredObjectStore.h>
+#include <cstdio>
+
+namespace jude
+{
+   TieredObjectStore::TieredObjectStore(Codec codec, std::string path, size_t maxResident)
+      : m_codec(std::move(codec))
+      , m_path(std::move(path))
+      , m_maxResident(maxResident)
+   {
+      m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+   }
+
+   TieredObjectStore::~TieredObjectStore()
+   {
+      // The spill file only ever holds a cache of objects owned by the collection
+      if (m_file.is_open())
+      {
+         m_file.close();
+         std::remove(m_path.c_str());
+      }
+   }
+
+   bool TieredObjectStore::ReadBytes(const Entry& entry, std::string& bytes) const
+   {
+      bytes.resize(entry.length);
+      m_file.clear();
+      m_file.seekg((std::streamoff)entry.offset);
+      m_file.read(&bytes[0], entry.length);
+      return m_file.gcount() == (std::streamsize)entry.length;
+   }
+
+   Object* TieredObjectStore::Load(jude_id_t id, Entry& entry) const
+   {
+      std::string bytes;
+      Object copy;
+      if (!ReadBytes(entry, bytes) || !(copy = m_codec.decode(id, entry.version, bytes)))
+      {
+         // Leave the entry spilled so a later find can try again
+         m_stats.readErrors++;
+         return nullptr;
+      }
+
+      entry.object = m_codec.adopt(copy, id);
+      m_recent.push_front(id);
+      entry.recent = m_recent.begin();
+      m_stats.misses++;
+      return &entry.object;
+   }
+
+   Object* TieredObjectStore::Find(jude_id_t id)
+   {
+      return const_cast<Object*>(static_cast<const TieredObjectStore*>(this)->Find(id));
+   }
+
+   const Object* TieredObjectStore::Find(jude_id_t id) const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto it = m_entries.find(id);
+      if (it == m_entries.end())
+      {
+         return nullptr;
+      }
+
+      auto& entry = it->second;
+      if (!entry.object)
+      {
+         return Load(id, entry);
+      }
+
+      m_recent.splice(m_recent.begin(), m_recent, entry.recent);
+      m_stats.hits++;
+      return &entry.object;
+   }
+
+   Object& TieredObjectStore::Insert(jude_id_t id)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto inserted = m_entries.emplace(id, Entry());
+      auto& entry = inserted.first->second;
+      if (inserted.second)
+      {
+         m_recent.push_front(id);
+         entry.recent = m_recent.begin();
+      }
+      else if (!entry.object && !Load(id, entry))
+      {
+         // The caller is replacing the object anyway so carry on without the unreadable copy
+         m_recent.push_front(id);
+         entry.recent = m_recent.begin();
+      }
+      return entry.object;
+   }
+
+   bool TieredObjectStore::Erase(jude_id_t id)
+   {
+      // Only release the object once the store is consistent again, as releasing the last reference can call back into the collection
+      Object erased;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+
+         auto it = m_entries.find(id);
+         if (it == m_entries.end())
+         {
+            return false;
+         }
+
+         auto& entry = it->second;
+         m_unusedBytes += entry.length;
+         if (entry.object)
+         {
+            m_recent.erase(entry.recent);
+            erased = std::move(entry.object);
+         }
+         m_entries.erase(it);
+      }
+      return true;
+   }
+
+   jude_id_t TieredObjectStore::NextId(jude_id_t id) const
+   {
+      auto it = (id == JUDE_INVALID_ID) ? m_entries.begin() : m_entries.upper_bound(id);
+      return it == m_entries.end() ? JUDE_INVALID_ID : it->first;
+   }
+
+   void TieredObjectStore::ForEach(const Visitor& visitor, jude_id_t after) const
+   {
+      auto it = (after == JUDE_INVALID_ID) ? m_entries.begin() : m_entries.upper_bound(after);
+      for (; it != m_entries.end(); ++it)
+      {
+         // A scan shouldn't push everything else out of memory so spilled objects are only decoded for the visitor.
+         // Resident objects can't be evicted while the caller holds the collection lock.
+         const Object* object;
+         Object copy;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto& entry = it->second;
+            if (entry.object)
+            {
+               object = &entry.object;
+            }
+            else
+            {
+               std::string bytes;
+               if (!ReadBytes(entry, bytes) || !(copy = m_codec.decode(it->first, entry.version, bytes)))
+               {
+                  m_stats.readErrors++;
+                  continue; // nothing to visit - the scan carries on with the objects we can read
+               }
+               object = &copy;
+            }
+         }
+
+         if (!visitor(*object))
+         {
+            return;
+         }
+      }
+   }
+
+   bool TieredObjectStore::NeedsEviction() const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_recent.size() > m_maxResident;
+   }
+
+   std::vector<jude_id_t> TieredObjectStore::EvictionCandidates() const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      std::vector<jude_id_t> candidates;
+      if (m_recent.size() > m_maxResident)
+      {
+         candidates.reserve(m_recent.size() - m_maxResident);
+         for (auto it = m_recent.rbegin(); candidates.size() < m_recent.size() - m_maxResident; ++it)
+         {
+            candidates.push_back(*it);
+         }
+      }
+      return candidates;
+   }
+
+   bool TieredObjectStore::Evict(jude_id_t id)
+   {
+      Object evicted;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+
+         auto it = m_entries.find(id);
+         if (it == m_entries.end() || !it->second.object || it->second.object.RefCount() > 1)
+         {
+            return false;
+         }
+
+         auto& entry = it->second;
+         if (entry.length == 0 || entry.version != entry.object.Version())
+         {
+            std::string bytes;
+            if (!m_codec.encode(entry.object, bytes))
+            {
+               return false;
+            }
+
+            m_file.clear();
+            m_file.seekp((std::streamoff)m_stats.fileBytes);
+            if (!m_file.write(bytes.data(), (std::streamsize)bytes.size()) || !m_file.flush())
+            {
+               return false; // keep the object in memory rather than rely on a copy we may not be able to read back
+            }
+
+            m_unusedBytes += entry.length;
+            entry.offset = m_stats.fileBytes;
+            entry.length = (uint32_t)bytes.size();
+            entry.version = entry.object.Version();
+            m_stats.fileBytes += bytes.size();
+            m_stats.bytesSpilled += bytes.size();
+         }
+
+         m_recent.erase(entry.recent);
+         evicted = std::move(entry.object);
+         entry.object = nullptr;
+         m_stats.evictions++;
+
+         if (m_unusedBytes > MinimumCompactionBytes && m_unusedBytes * 2 > m_stats.fileBytes)
+         {
+            Compact();
+         }
+      }
+      return true;
+   }
+
+   void TieredObjectStore::Compact()
+   {
+      auto compactedPath = m_path + ".compact";
+      std::fstream compacted(compactedPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!compacted.is_open())
+      {
+         return; // carry on with the file we have
+      }
+
+      std::map<jude_id_t, uint64_t> offsets;
+      uint64_t size = 0;
+      std::string bytes;
+      for (auto& [id, entry] : m_entries)
+      {
+         if (entry.length == 0)
+         {
+            continue;
+         }
+
+         if (!ReadBytes(entry, bytes) || !compacted.write(bytes.data(), (std::streamsize)bytes.size()))
+         {
+            compacted.close();
+            std::remove(compactedPath.c_str());
+            return;
+         }
+         offsets[id] = size;
+         size += entry.length;
+      }
+
+      compacted.close();
+      if (!compacted)
+      {
+         std::remove(compactedPath.c_str());
+         return;
+      }
+
+      // The spill file holds the only copy of evicted objects - it is replaced in one step or not at all.
+      // rename() replaces the old file, which stays readable through our handle should we fail to open the new one.
+      if (std::rename(compactedPath.c_str(), m_path.c_str()) != 0)
+      {
+         std::remove(compactedPath.c_str());
+         return;
+      }
+
+      std::fstream replacement(m_path, std::ios::in | std::ios::out | std::ios::binary);
+      if (!replacement.is_open())
+      {
+         return; // carry on with the old data through the handle we already have
+      }
+      m_file = std::move(replacement);
+
+      for (auto& [id, offset] : offsets)
+      {
+         m_entries[id].offset = offset;
+      }
+      m_stats.fileBytes = size;
+      m_unusedBytes = 0;
+   }
+
+   TieredObjectStore::Stats TieredObjectStore::GetStats() const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto stats = m_stats;
+      stats.residentObjects = m_recent.size();
+      stats.spilledObjects = m_entries.size() - m_recent.size();
+      return stats;
+   }
+}
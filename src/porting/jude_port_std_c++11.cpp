@@ -25,6 +25,8 @@
 #include <condition_variable>
 #include <queue>
 #include <chrono>
+#include <thread>
+#include <vector>
 #include <assert.h>
 
 #include <jude/jude.h>
@@ -144,14 +146,16 @@ static void queue_destroy(jude_queue_t *q)
    delete q;
 }
 
-static void queue_send(jude_queue_t *q, const void *e)
+static bool queue_send(jude_queue_t *q, const void *e)
 {
    std::unique_lock<std::mutex> lck(q->mut);
-   if (q->m_queue.size() < q->max)
+   if (q->m_queue.size() >= q->max)
    {
-      q->m_queue.emplace((char *)e, (char*)e + q->elementSize);
-      q->cv.notify_one();
+      return false;
    }
+   q->m_queue.emplace((char *)e, (char*)e + q->elementSize);
+   q->cv.notify_one();
+   return true;
 }
 
 static bool queue_receive(jude_queue_t *q, void *e, uint32_t maxWaitMs)
@@ -177,6 +181,150 @@ static bool queue_receive(jude_queue_t *q, void *e, uint32_t maxWaitMs)
    return true;
 }
 
+// reader/writer lock
+struct jude_rwlock_t
+{
+   std::mutex mut;
+   std::condition_variable cv;
+   std::thread::id writer;          // thread that holds exclusive access (if any)
+   unsigned writerDepth{0};         // recursive locks taken by the writer (exclusive or shared)
+   unsigned waitingWriters{0};
+   std::vector<std::pair<std::thread::id, unsigned>> readers; // shared lock depth of each reading thread
+};
+
+static std::pair<std::thread::id, unsigned>* find_reader(jude_rwlock_t *rw, std::thread::id thread)
+{
+   for (auto& reader : rw->readers)
+   {
+      if (reader.first == thread)
+      {
+         return &reader;
+      }
+   }
+   return nullptr;
+}
+
+static jude_rwlock_t *rwlock_create()
+{
+   auto rw = new jude_rwlock_t;
+   rw->readers.reserve(16); // avoid allocating on the read path for typical thread counts
+   return rw;
+}
+
+static void rwlock_destroy(jude_rwlock_t *rw)
+{
+   jude_assert(rw != nullptr);
+   delete rw;
+}
+
+static bool rwlock_lock(jude_rwlock_t *rw, uint32_t timeoutMs)
+{
+   jude_assert(rw != nullptr);
+
+   auto self = std::this_thread::get_id();
+   std::unique_lock<std::mutex> lck(rw->mut);
+
+   if (rw->writer == self)
+   {
+      rw->writerDepth++; // recursive
+      return true;
+   }
+
+   if (find_reader(rw, self))
+   {
+      // Upgrading a shared lock is not supported - two readers upgrading at once would wait on each other forever
+      return false;
+   }
+
+   auto isAvailable = [&] { return rw->writer == std::thread::id() && rw->readers.empty(); };
+
+   rw->waitingWriters++;
+   bool acquired = rw->cv.wait_for(lck, std::chrono::milliseconds(timeoutMs), isAvailable);
+   rw->waitingWriters--;
+
+   if (!acquired)
+   {
+      rw->cv.notify_all(); // readers may have been held back waiting on us
+      return false;
+   }
+
+   rw->writer = self;
+   rw->writerDepth = 1;
+   return true;
+}
+
+// Caller must hold rw->mut and be the writer
+static void rwlock_release_writer(jude_rwlock_t *rw)
+{
+   jude_assert(rw->writer == std::this_thread::get_id());
+
+   if (--rw->writerDepth == 0)
+   {
+      rw->writer = std::thread::id();
+      rw->cv.notify_all();
+   }
+}
+
+static void rwlock_unlock(jude_rwlock_t *rw)
+{
+   jude_assert(rw != nullptr);
+
+   std::unique_lock<std::mutex> lck(rw->mut);
+   rwlock_release_writer(rw);
+}
+
+static bool rwlock_lock_shared(jude_rwlock_t *rw, uint32_t timeoutMs)
+{
+   jude_assert(rw != nullptr);
+
+   auto self = std::this_thread::get_id();
+   std::unique_lock<std::mutex> lck(rw->mut);
+
+   if (rw->writer == self)
+   {
+      rw->writerDepth++; // already have exclusive access
+      return true;
+   }
+
+   if (auto reader = find_reader(rw, self))
+   {
+      reader->second++; // recursive - don't block behind a waiting writer or we would deadlock
+      return true;
+   }
+
+   // New readers wait behind waiting writers so that writers are not starved
+   if (!rw->cv.wait_for(lck, std::chrono::milliseconds(timeoutMs), [&] { return rw->writer == std::thread::id() && rw->waitingWriters == 0; }))
+   {
+      return false;
+   }
+
+   rw->readers.emplace_back(self, 1);
+   return true;
+}
+
+static void rwlock_unlock_shared(jude_rwlock_t *rw)
+{
+   jude_assert(rw != nullptr);
+
+   auto self = std::this_thread::get_id();
+   std::unique_lock<std::mutex> lck(rw->mut);
+
+   auto reader = find_reader(rw, self);
+   if (reader == nullptr)
+   {
+      // shared lock was taken while we had exclusive access
+      rwlock_release_writer(rw);
+      return;
+   }
+
+   if (--reader->second == 0)
+   {
+      *reader = rw->readers.back();
+      rw->readers.pop_back();
+      rw->cv.notify_all();
+   }
+}
+
 extern "C" 
 {
    jude_os_interface_t jude_porting_interface_cpp11 =
@@ -199,7 +347,15 @@ extern "C"
       queue_create,
       queue_destroy,
       queue_send,
-      queue_receive
+      queue_receive,
+
+      // reader/writer lock
+      rwlock_create,
+      rwlock_destroy,
+      rwlock_lock,
+      rwlock_unlock,
+      rwlock_lock_shared,
+      rwlock_unlock_shared
    };
 }
 
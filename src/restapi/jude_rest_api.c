@@ -29,6 +29,7 @@ static jude_enum_map_t restapi_result_map[] =
    JUDE_ENUM_MAP_ENTRY(OK                , 200, "OK"),
    JUDE_ENUM_MAP_ENTRY(Created           , 201, "Created, OK"),
    JUDE_ENUM_MAP_ENTRY(No_Content        , 204, "No Content, OK"),
+   JUDE_ENUM_MAP_ENTRY(Not_Modified      , 304, "Not Modified"),
 
    JUDE_ENUM_MAP_ENTRY(Bad_Request       , 400, "Bad Request"),
    JUDE_ENUM_MAP_ENTRY(Unauthorized      , 401, "Unauthorized"),
@@ -36,6 +37,7 @@ static jude_enum_map_t restapi_result_map[] =
    JUDE_ENUM_MAP_ENTRY(Not_Found         , 404, "Not Found"),
    JUDE_ENUM_MAP_ENTRY(Method_Not_Allowed, 405, "Method Not Allowed"),
    JUDE_ENUM_MAP_ENTRY(Conflict          , 409, "Conflict"),
+   JUDE_ENUM_MAP_ENTRY(Precondition_Failed, 412, "Precondition Failed"),
 
    JUDE_ENUM_MAP_ENTRY(Internal_Server_Error, 500, "Internal Server Error" ),
 
@@ -80,8 +82,9 @@ const char* jude_restapi_get_next_path_token_no_strip(const char* fullpath, char
       fullpath++;
    }
 
+   // A query string ("?name=value&...") is not part of the path - it is left in the suffix for the caller
    size_t length_of_token = 0;
-   const char *start_of_next_token = strchr(fullpath, '/');
+   const char *start_of_next_token = strpbrk(fullpath, "/?");
    if (start_of_next_token)
    {
       length_of_token = start_of_next_token - fullpath;
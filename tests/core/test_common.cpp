@@ -17,3 +17,21 @@ TEST(jude_common, jude_remove_const)
    ASSERT_TRUE(ptr != NULL);
    ASSERT_EQ(ptr->__child_index, 123);
 }
+
+TEST(jude_common, url_query_is_not_part_of_path)
+{
+   const char* suffix;
+   ASSERT_EQ("items", jude::RestApiInterface::GetNextUrlToken("/items?limit=2", &suffix));
+   ASSERT_STREQ("?limit=2", suffix);
+   ASSERT_EQ("", jude::RestApiInterface::GetNextUrlToken(suffix, &suffix));
+   ASSERT_STREQ("?limit=2", suffix);
+
+   auto query = jude::RestApiInterface::GetUrlQuery("/items?limit=2&count&name=a%20b+c&&=x");
+   ASSERT_EQ(4, query.size());
+   ASSERT_EQ("2", query["limit"]);
+   ASSERT_EQ("", query["count"]);
+   ASSERT_EQ("a b c", query["name"]);
+   ASSERT_EQ("x", query[""]);
+
+   ASSERT_TRUE(jude::RestApiInterface::GetUrlQuery("/items").empty());
+}
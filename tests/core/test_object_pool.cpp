@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/core/cpp/ObjectPool.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class ObjectPoolTests : public JudeTestBase
+{
+public:
+   bool m_usePools;
+
+   ObjectPoolTests()
+      : m_usePools(Options::UseObjectPools)
+   {
+      Options::UseObjectPools = true;
+   }
+
+   ~ObjectPoolTests()
+   {
+      Options::UseObjectPools = m_usePools;
+   }
+};
+
+TEST_F(ObjectPoolTests, objects_are_allocated_from_pool)
+{
+   auto before = ObjectPool::GetStatistics();
+   {
+      auto object = SubMessage::New();
+      object.Set_substuff1("pooled").Set_substuff2(42);
+
+      auto during = ObjectPool::GetStatistics();
+      ASSERT_EQ(before.blocksInUse + 1, during.blocksInUse);
+      ASSERT_EQ(before.poolAllocations + 1, during.poolAllocations);
+
+      ASSERT_EQ("pooled", object.Get_substuff1());
+      ASSERT_EQ(42, object.Get_substuff2());
+   }
+   ASSERT_EQ(before.blocksInUse, ObjectPool::GetStatistics().blocksInUse);
+}
+
+TEST_F(ObjectPoolTests, freed_blocks_are_reused)
+{
+   // Warm up so the pool has free blocks
+   {
+      std::vector<SubMessage> objects;
+      for (size_t i = 0; i < ObjectPool::BlocksPerChunk; i++)
+      {
+         objects.push_back(SubMessage::New());
+      }
+   }
+
+   auto before = ObjectPool::GetStatistics();
+   for (int i = 0; i < 1000; i++)
+   {
+      auto object = SubMessage::New();
+      object.Set_substuff2(i);
+   }
+   auto after = ObjectPool::GetStatistics();
+
+   ASSERT_EQ(before.heapAllocations, after.heapAllocations);
+   ASSERT_EQ(before.poolAllocations + 1000, after.poolAllocations);
+}
+
+TEST_F(ObjectPoolTests, clones_and_sub_objects_work_with_pools)
+{
+   auto object = SubMessage::New();
+   object.Set_substuff1("original");
+
+   auto clone = object.Clone();
+   clone.Set_substuff1("clone");
+
+   ASSERT_EQ("original", object.Get_substuff1());
+   ASSERT_EQ("clone", clone.Get_substuff1());
+}
+
+TEST_F(ObjectPoolTests, pools_can_be_disabled)
+{
+   Options::UseObjectPools = false;
+
+   auto before = ObjectPool::GetStatistics();
+   {
+      auto object = SubMessage::New();
+      object.Set_substuff1("unpooled");
+      ASSERT_EQ("unpooled", object.Get_substuff1());
+   }
+   auto after = ObjectPool::GetStatistics();
+
+   ASSERT_EQ(before.poolAllocations, after.poolAllocations);
+   ASSERT_EQ(before.heapAllocations + 2, after.heapAllocations);
+}
+
+TEST_F(ObjectPoolTests, steady_state_posts_do_not_touch_the_heap_for_objects)
+{
+   Collection<SubMessage> collection("MyCollection", 100);
+
+   auto postAndDelete = [&] {
+      for (jude_id_t id = 1; id <= 50; id++)
+      {
+         collection.Post(id)->Set_substuff2((int32_t)id);
+      }
+      for (jude_id_t id = 1; id <= 50; id++)
+      {
+         collection.Delete(id);
+      }
+   };
+
+   postAndDelete();
+
+   auto before = ObjectPool::GetStatistics();
+   postAndDelete();
+   auto after = ObjectPool::GetStatistics();
+
+   ASSERT_EQ(before.heapAllocations, after.heapAllocations);
+   ASSERT_EQ(before.blocksInUse, after.blocksInUse);
+}
+
+TEST_F(ObjectPoolTests, post_does_not_copy_new_object)
+{
+   Collection<SubMessage> collection("MyCollection", 100);
+
+   auto before = ObjectPool::GetStatistics();
+   collection.Post(1)->Set_substuff2(1);
+   auto after = ObjectPool::GetStatistics();
+
+   // Just the new object, which is stored as it is - nobody is subscribed so no copy is made for notifications
+   ASSERT_EQ(before.poolAllocations + 1, after.poolAllocations);
+
+   auto subscription1 = collection.OnChange([] (const Notification<SubMessage>&) {}, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   auto subscription2 = collection.OnChange([] (const Notification<SubMessage>&) {}, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+
+   before = ObjectPool::GetStatistics();
+   collection.Post(2)->Set_substuff2(2);
+   after = ObjectPool::GetStatistics();
+
+   // and one copy for the subscribers to share
+   ASSERT_EQ(before.poolAllocations + 2, after.poolAllocations);
+}
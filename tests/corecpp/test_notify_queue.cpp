@@ -0,0 +1,342 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../core/test_base.h"
+#include "jude/core/cpp/NotifyQueue.h"
+#include "jude/core/cpp/NotificationRing.h"
+
+using namespace jude;
+
+TEST(NotificationRingTests, callbacks_come_out_in_order)
+{
+   NotificationRing ring(4);
+   std::vector<int> order;
+
+   for (int value = 0; value < 4; value++)
+   {
+      ASSERT_TRUE(ring.Push([&order, value] { order.push_back(value); }));
+   }
+
+   std::function<void()> callback;
+   while (ring.Pop(callback, 0))
+   {
+      callback();
+   }
+   ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3 }), order);
+}
+
+TEST(NotificationRingTests, full_ring_refuses_and_recovers)
+{
+   NotificationRing ring(3);
+   ASSERT_EQ(4, ring.Capacity());
+
+   int calls = 0;
+   for (int i = 0; i < 4; i++)
+   {
+      ASSERT_TRUE(ring.Push([&calls] { calls++; }));
+   }
+   ASSERT_FALSE(ring.Push([&calls] { calls++; }));
+
+   std::function<void()> callback;
+   ASSERT_TRUE(ring.Pop(callback, 0));
+   callback();
+   ASSERT_TRUE(ring.Push([&calls] { calls += 10; }));
+
+   while (ring.Pop(callback, 0))
+   {
+      callback();
+   }
+   ASSERT_EQ(14, calls);
+}
+
+TEST(NotificationRingTests, consumer_is_woken_by_producer)
+{
+   NotificationRing ring(8);
+   std::atomic<bool> called{false};
+
+   std::thread producer([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      ring.Push([&] { called = true; });
+   });
+
+   std::function<void()> callback;
+   auto start = std::chrono::steady_clock::now();
+   ASSERT_TRUE(ring.Pop(callback, 5000));
+   ASSERT_GT(std::chrono::seconds(5), std::chrono::steady_clock::now() - start);
+   callback();
+   ASSERT_TRUE(called);
+   producer.join();
+}
+
+TEST(NotificationRingTests, many_producers_lose_nothing)
+{
+   constexpr int Producers = 4;
+   constexpr int PerProducer = 20000;
+
+   NotificationRing ring(256);
+   std::vector<int> lastSeen(Producers, -1);
+   bool inOrder = true;
+   int received = 0;
+
+   std::vector<std::thread> producers;
+   for (int producer = 0; producer < Producers; producer++)
+   {
+      producers.emplace_back([&, producer] {
+         for (int sequence = 0; sequence < PerProducer; sequence++)
+         {
+            std::function<void()> callback = [&, producer, sequence] {
+               inOrder = inOrder && (lastSeen[producer] == sequence - 1);
+               lastSeen[producer] = sequence;
+               received++;
+            };
+            while (!ring.Push(std::move(callback)))
+            {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+
+   // Pop() can return early (e.g. on a wake-up left over from an earlier wait) so keep going until done
+   auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+   std::function<void()> callback;
+   while (received < Producers * PerProducer && std::chrono::steady_clock::now() < deadline)
+   {
+      if (ring.Pop(callback, 100))
+      {
+         callback();
+      }
+   }
+
+   for (auto& producer : producers)
+   {
+      producer.join();
+   }
+   ASSERT_EQ(Producers * PerProducer, received);
+   ASSERT_TRUE(inOrder) << "Each producer's callbacks should arrive in the order they were sent";
+}
+
+class LockFreeQueueTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   NotifyQueue m_queue;
+
+   LockFreeQueueTests()
+      : m_collection("MyCollection", 10)
+      , m_queue("LockFree", 16, NotifyQueue::Type::LockFree)
+   {}
+};
+
+TEST_F(LockFreeQueueTests, subscriptions_are_delivered_through_the_ring)
+{
+   ASSERT_EQ(NotifyQueue::Type::LockFree, m_queue.GetType());
+   ASSERT_FALSE(m_queue.IsImmediate());
+
+   std::vector<int32_t> values;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>& info) {
+      values.push_back(info->Get_substuff2());
+   }, FieldMask::ForAllChanges(), m_queue);
+
+   m_collection.Post(1)->Set_substuff2(1);
+   m_collection.TransactionLock(1)->Set_substuff2(2);
+   ASSERT_TRUE(values.empty()) << "Nothing is delivered until the queue is processed";
+
+   while (m_queue.Process(0)) {}
+   ASSERT_EQ(std::vector<int32_t>({ 1, 2 }), values);
+}
+
+TEST_F(LockFreeQueueTests, pause_and_default_queue)
+{
+   int calls = 0;
+   m_queue.Pause();
+   m_queue.Send([&] { calls++; });
+   ASSERT_FALSE(m_queue.Process(0));
+   m_queue.Play();
+   ASSERT_EQ(1, calls);
+
+   NotifyQueue::SetDefaultQueue("DefaultLockFree", 8, NotifyQueue::Type::LockFree);
+   ASSERT_EQ(NotifyQueue::Type::LockFree, NotifyQueue::Default.GetType());
+   NotifyQueue::Default.Send([&] { calls++; });
+   ASSERT_TRUE(NotifyQueue::Default.Process(0));
+   ASSERT_EQ(2, calls);
+
+   NotifyQueue::SetDefaultQueueAsImmediate();
+   ASSERT_TRUE(NotifyQueue::Default.IsImmediate());
+}
+
+class QueueOverflowTests : public JudeTestBase
+                         , public ::testing::WithParamInterface<NotifyQueue::Type>
+{
+public:
+   NotifyQueue m_queue;
+   std::vector<int> m_order;
+   std::shared_ptr<int> m_token = std::make_shared<int>(0); // copies are held by every pending callback
+
+   QueueOverflowTests()
+      : m_queue("Overflow", 4, GetParam())
+   {}
+
+   bool Send(int value)
+   {
+      return m_queue.Send([this, value, token = m_token] { m_order.push_back(value); });
+   }
+
+   void ProcessAll()
+   {
+      while (m_queue.Process(0)) {}
+   }
+};
+
+TEST_P(QueueOverflowTests, drop_newest_by_default_and_nothing_leaks)
+{
+   ASSERT_EQ(NotifyQueue::Overflow::DropNewest, m_queue.GetOverflowPolicy());
+   for (int value = 0; value < 6; value++)
+   {
+      ASSERT_EQ(value < 4, Send(value));
+   }
+   ASSERT_EQ(5, m_token.use_count()) << "Dropped callbacks are destroyed straight away";
+
+   auto stats = m_queue.GetStats();
+   ASSERT_EQ(6, stats.sent);
+   ASSERT_EQ(2, stats.dropped);
+   ASSERT_EQ(4, stats.depth);
+   ASSERT_EQ(4, stats.highWaterMark);
+
+   ProcessAll();
+   ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3 }), m_order);
+   ASSERT_EQ(1, m_token.use_count());
+   ASSERT_EQ(0, m_queue.GetStats().depth);
+   ASSERT_EQ(4, m_queue.GetStats().processed);
+}
+
+TEST_P(QueueOverflowTests, drop_oldest_keeps_the_latest)
+{
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::DropOldest);
+   for (int value = 0; value < 6; value++)
+   {
+      ASSERT_TRUE(Send(value));
+   }
+   ProcessAll();
+   ASSERT_EQ(std::vector<int>({ 2, 3, 4, 5 }), m_order);
+   ASSERT_EQ(2, m_queue.GetStats().dropped);
+   ASSERT_EQ(1, m_token.use_count());
+}
+
+TEST_P(QueueOverflowTests, reject_tells_the_sender)
+{
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::Reject);
+   for (int value = 0; value < 4; value++)
+   {
+      ASSERT_TRUE(Send(value));
+   }
+   ASSERT_FALSE(Send(4));
+   ASSERT_EQ(1, m_queue.GetStats().rejected);
+   ASSERT_EQ(0, m_queue.GetStats().dropped);
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_TRUE(Send(5)) << "Room again once one is processed";
+   ProcessAll();
+   ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3, 5 }), m_order);
+}
+
+TEST_P(QueueOverflowTests, coalesce_keeps_everything_in_order)
+{
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::Coalesce);
+   for (int value = 0; value < 10; value++)
+   {
+      ASSERT_TRUE(Send(value));
+   }
+   ASSERT_EQ(6, m_queue.GetStats().coalesced);
+   ASSERT_EQ(4, m_queue.GetStats().depth) << "The overflow takes no queue slots";
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_TRUE(Send(10)) << "Joins the overflow batch even though there is room, to keep the order";
+   ASSERT_EQ(3, m_queue.GetStats().depth);
+
+   ProcessAll();
+   ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }), m_order);
+   ASSERT_EQ(11, m_queue.GetStats().processed);
+   ASSERT_EQ(0, m_queue.GetStats().dropped);
+}
+
+TEST_P(QueueOverflowTests, coalesce_batch_is_bounded)
+{
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::Coalesce);
+   m_queue.SetMaxOverflowBatch(3);
+   for (int value = 0; value < 7; value++)
+   {
+      ASSERT_TRUE(Send(value));
+   }
+   ASSERT_FALSE(Send(7)) << "The overflow batch is full";
+   ASSERT_EQ(3, m_queue.GetStats().coalesced);
+   ASSERT_EQ(1, m_queue.GetStats().dropped);
+
+   ProcessAll();
+   ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3, 4, 5, 6 }), m_order);
+   ASSERT_TRUE(Send(8)) << "Room again once the batch has been processed";
+}
+
+TEST_P(QueueOverflowTests, block_waits_for_the_consumer)
+{
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::Block, 50);
+   for (int value = 0; value < 4; value++)
+   {
+      ASSERT_TRUE(Send(value));
+   }
+   ASSERT_FALSE(Send(4)) << "Nobody is consuming so we time out";
+   ASSERT_EQ(1, m_queue.GetStats().blocked);
+   ASSERT_EQ(1, m_queue.GetStats().dropped);
+
+   m_queue.SetOverflowPolicy(NotifyQueue::Overflow::Block, JUDE_WAIT_FOREVER);
+   std::atomic<bool> done{false};
+   std::thread producer([&] {
+      for (int value = 5; value < 20; value++)
+      {
+         m_queue.Send([&, value] { m_order.push_back(value); });
+      }
+      done = true;
+   });
+
+   auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+   while ((!done || m_queue.GetStats().depth > 0) && std::chrono::steady_clock::now() < deadline)
+   {
+      m_queue.Process(10);
+   }
+   producer.join();
+
+   ASSERT_EQ(19, m_order.size());
+   ASSERT_EQ(19, m_order.back());
+   ASSERT_EQ(4, m_queue.GetStats().highWaterMark);
+   ASSERT_EQ(1, m_queue.GetStats().dropped);
+}
+
+TEST_P(QueueOverflowTests, pending_callbacks_are_freed_with_the_queue)
+{
+   {
+      NotifyQueue queue("Temporary", 4, GetParam());
+      queue.Send([token = m_token] {});
+      queue.Send([token = m_token] {});
+      ASSERT_EQ(3, m_token.use_count());
+   }
+   ASSERT_EQ(1, m_token.use_count());
+}
+
+TEST_P(QueueOverflowTests, debug_info_shows_the_counters)
+{
+   for (int value = 0; value < 5; value++)
+   {
+      Send(value);
+   }
+   auto info = m_queue.DebugInfo();
+   ASSERT_NE(std::string::npos, info.find("depth 4/4")) << info;
+   ASSERT_NE(std::string::npos, info.find("high water 4")) << info;
+   ASSERT_NE(std::string::npos, info.find("dropped 1")) << info;
+   ASSERT_NE(std::string::npos, info.find("DropNewest")) << info;
+
+   ASSERT_EQ("ImmediateQueue (immediate)", NotifyQueue::Immediate.DebugInfo());
+}
+
+INSTANTIATE_TEST_SUITE_P(AllTypes, QueueOverflowTests, ::testing::Values(NotifyQueue::Type::Ported, NotifyQueue::Type::LockFree));
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class BulkOperationTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   NotifyQueue m_queue;
+   size_t m_notificationCount;
+   size_t m_newObjectCount;
+   SubscriptionHandle m_subscription;
+
+   BulkOperationTests()
+      : m_collection("MyCollection", 5, jude_user_Root)
+      , m_queue("BulkQueue")
+      , m_notificationCount(0)
+      , m_newObjectCount(0)
+   {
+      m_subscription = m_collection.OnChange([&](const Notification<SubMessage>& notification) {
+         m_notificationCount++;
+         if (notification.IsNew())
+         {
+            m_newObjectCount++;
+         }
+      }, FieldMask::ForAllChanges(), m_queue);
+   }
+
+   SubMessage NewEntry(jude_id_t id, int32_t value)
+   {
+      auto entry = SubMessage::New();
+      if (id != JUDE_AUTO_ID)
+      {
+         entry.AssignId(id);
+      }
+      entry.Set_substuff2(value);
+      return entry;
+   }
+
+   // id and substuff2 of each entry
+   std::vector<SubMessage> Batch(std::initializer_list<std::pair<jude_id_t, int32_t>> values)
+   {
+      std::vector<SubMessage> batch;
+      for (auto& value : values)
+      {
+         batch.push_back(NewEntry(value.first, value.second));
+      }
+      return batch;
+   }
+
+   std::vector<SubMessage> Patches(std::initializer_list<SubMessage*> patches)
+   {
+      std::vector<SubMessage> batch;
+      for (auto patch : patches)
+      {
+         batch.emplace_back(*patch);
+      }
+      return batch;
+   }
+};
+
+TEST_F(BulkOperationTests, post_many_adds_all_entries)
+{
+   std::vector<jude_id_t> createdIds;
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 10, 1 }, { JUDE_AUTO_ID, 2 }, { 30, 3 } }), &createdIds));
+
+   ASSERT_EQ(3, m_collection.count());
+   ASSERT_EQ(3, createdIds.size());
+   ASSERT_EQ(10, createdIds[0]);
+   ASSERT_EQ(30, createdIds[2]);
+   ASSERT_EQ(2, m_collection.ReadLock(createdIds[1])->Get_substuff2());
+}
+
+TEST_F(BulkOperationTests, post_many_is_one_queue_message)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 } })));
+
+   ASSERT_EQ(0, m_notificationCount) << "Nothing delivered until the queue is processed";
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_EQ(3, m_notificationCount);
+   ASSERT_EQ(3, m_newObjectCount);
+   ASSERT_FALSE(m_queue.Process(0)) << "The whole batch should arrive as one message";
+}
+
+TEST_F(BulkOperationTests, post_many_is_all_or_nothing)
+{
+   ASSERT_REST_FAIL(m_collection.PostMany(Batch({ { 1, 1 }, { 1, 2 } })));
+   ASSERT_EQ(0, m_collection.count()) << "Duplicate ids in the batch";
+
+   ASSERT_REST_FAIL(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 }, { 6, 6 } })));
+   ASSERT_EQ(0, m_collection.count()) << "Batch is bigger than the capacity";
+
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      if (info->Get_substuff2() < 0)
+      {
+         return "negative";
+      }
+      return true;
+   });
+
+   // Code posts are only validated when ValidatePostOnlyForRestAPI is off, REST posts always are
+   auto result = m_collection.RestPostString("/", R"([ {"id":1,"substuff2":1}, {"id":2,"substuff2":-2} ])");
+   ASSERT_FALSE(result);
+   ASSERT_EQ("Entry 1: negative", result.GetDetails());
+   ASSERT_EQ(0, m_collection.count()) << "One entry failed validation";
+   ASSERT_FALSE(m_queue.Process(0));
+}
+
+TEST_F(BulkOperationTests, patch_many_applies_changed_fields)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 } })));
+   ASSERT_TRUE(m_queue.Process(0));
+   m_notificationCount = 0;
+
+   auto patch1 = SubMessage::New();
+   patch1.AssignId(1);
+   patch1.Set_substuff1("patched");
+   auto patch3 = SubMessage::New();
+   patch3.AssignId(3);
+   patch3.Set_substuff2(33);
+
+   ASSERT_REST_OK(m_collection.PatchMany(Patches({ &patch1, &patch3 })));
+
+   ASSERT_EQ("patched", m_collection.ReadLock(1)->Get_substuff1());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ(2, m_collection.ReadLock(2)->Get_substuff2());
+   ASSERT_EQ(33, m_collection.ReadLock(3)->Get_substuff2());
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_EQ(2, m_notificationCount);
+   ASSERT_FALSE(m_queue.Process(0));
+}
+
+TEST_F(BulkOperationTests, patch_many_is_all_or_nothing)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 } })));
+
+   auto patch1 = NewEntry(1, 11);
+   auto missing = NewEntry(99, 99);
+   ASSERT_EQ(jude_rest_Not_Found, m_collection.PatchMany(Patches({ &patch1, &missing })).GetCode());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      return info->Get_substuff2() >= 0;
+   });
+
+   auto negative = NewEntry(2, -2);
+   ASSERT_REST_FAIL(m_collection.PatchMany(Patches({ &patch1, &negative })));
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ(2, m_collection.ReadLock(2)->Get_substuff2());
+}
+
+TEST_F(BulkOperationTests, rest_post_of_json_array)
+{
+   ASSERT_REST_OK(m_collection.RestPostString("/", R"([ {"id":1,"substuff2":1}, {"substuff1":"a \"}\" b"} ])"));
+   ASSERT_EQ(2, m_collection.count());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+
+   ASSERT_REST_OK(m_collection.RestPostString("", "[]"));
+   ASSERT_EQ(2, m_collection.count());
+
+   ASSERT_EQ(jude_rest_Bad_Request, m_collection.RestPostString("/", R"([ {"id":3}, {"substuff3":wrong} ])").GetCode());
+   ASSERT_EQ(jude_rest_Bad_Request, m_collection.RestPostString("/", R"([ {"id":3}, 4 ])").GetCode());
+   ASSERT_EQ(jude_rest_Bad_Request, m_collection.RestPostString("/", R"([ {"id":3} )").GetCode());
+   ASSERT_EQ(2, m_collection.count());
+}
+
+TEST_F(BulkOperationTests, delete_many_is_one_queue_message)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 } })));
+   m_queue.Process(0);
+   m_notificationCount = 0;
+
+   ASSERT_REST_OK(m_collection.DeleteMany({ 1, 3 }));
+   ASSERT_EQ(1, m_collection.count());
+   ASSERT_TRUE(m_collection.ContainsId(2));
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_EQ(2, m_notificationCount);
+   ASSERT_FALSE(m_queue.Process(0));
+}
+
+TEST_F(BulkOperationTests, delete_many_is_all_or_nothing)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, -2 }, { 3, 3 } })));
+
+   ASSERT_EQ(jude_rest_Not_Found, m_collection.DeleteMany({ 1, 99 }).GetCode());
+   ASSERT_EQ(jude_rest_Bad_Request, m_collection.DeleteMany({ 1, 1 }).GetCode());
+   ASSERT_EQ(3, m_collection.count());
+
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      return !info.IsDeleted() || info->Get_substuff2() >= 0;
+   });
+   ASSERT_REST_FAIL(m_collection.DeleteMany({ 1, 2 }));
+   ASSERT_EQ(3, m_collection.count());
+}
+
+TEST_F(BulkOperationTests, erase_if_deletes_every_match)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 } })));
+   m_queue.Process(0);
+   m_notificationCount = 0;
+
+   ASSERT_EQ(2, m_collection.erase_if([] (const SubMessage& entry) { return entry.Get_substuff2() % 2 == 0; }));
+   ASSERT_EQ(2, m_collection.count());
+   ASSERT_FALSE(m_collection.ContainsId(2));
+   ASSERT_FALSE(m_collection.ContainsId(4));
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_EQ(2, m_notificationCount);
+   ASSERT_FALSE(m_queue.Process(0));
+
+   ASSERT_EQ(0, m_collection.erase_if([] (const SubMessage& entry) { return entry.Get_substuff2() > 10; }));
+}
+
+TEST_F(BulkOperationTests, remove_if_deletes_first_match_only)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 } })));
+
+   m_collection.remove_if([] (const SubMessage& entry) { return entry.Get_substuff2() % 2 == 0; });
+   ASSERT_EQ(3, m_collection.count());
+   ASSERT_FALSE(m_collection.ContainsId(2));
+   ASSERT_TRUE(m_collection.ContainsId(4));
+}
+
+TEST_F(BulkOperationTests, erase_if_skips_objects_validators_keep)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 }, { 3, 3 } })));
+
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      return !info.IsDeleted() || info->Id() != 2;
+   });
+   ASSERT_EQ(2, m_collection.erase_if([] (const SubMessage&) { return true; }));
+   ASSERT_TRUE(m_collection.ContainsId(2));
+
+   m_collection.clear();
+   ASSERT_EQ(1, m_collection.count());
+}
+
+TEST_F(BulkOperationTests, erase_if_rechecks_objects_changed_since_matching)
+{
+   ASSERT_REST_OK(m_collection.PostMany(Batch({ { 1, 1 }, { 2, 2 } })));
+
+   bool changed = false;
+   ASSERT_EQ(1, m_collection.erase_if([&] (const SubMessage& entry) {
+      if (!changed)
+      {
+         changed = true;
+         m_collection.TransactionLock(1)->Set_substuff2(100); // changes after it has been seen
+      }
+      return entry.Get_substuff2() < 10;
+   }));
+   ASSERT_TRUE(m_collection.ContainsId(1));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+}
@@ -378,6 +378,31 @@ TEST_F(CollectionTests, collection_Rest_GET_aka_ToJSON)
    ASSERT_STREQ(R"(#ERROR: Not Found)", m_collection.ToJSON("5").c_str());
 }
 
+TEST_F(CollectionTests, collection_Rest_GET_pages)
+{
+   AddObjectWithId(1, "one");
+   AddObjectWithId(2, "two");
+   AddObjectWithId(5, "five");
+   AddObjectWithId(7, "seven");
+
+   ASSERT_STREQ("4", m_collection.ToJSON("?count").c_str());
+   ASSERT_STREQ(R"({"1":{"id":1,"substuff1":"one"},"2":{"id":2,"substuff1":"two"}})", m_collection.ToJSON("?limit=2").c_str());
+   ASSERT_STREQ(R"({"5":{"id":5,"substuff1":"five"},"7":{"id":7,"substuff1":"seven"}})", m_collection.ToJSON("/?after=2&limit=2").c_str());
+   ASSERT_STREQ(R"({"7":{"id":7,"substuff1":"seven"}})", m_collection.ToJSON("?after=5").c_str());
+   ASSERT_STREQ(R"({"5":{"id":5,"substuff1":"five"}})", m_collection.ToJSON("?after=3&limit=1").c_str()) << "cursor does not need to exist";
+   ASSERT_STREQ("{}", m_collection.ToJSON("?after=7&limit=2").c_str());
+   ASSERT_STREQ("{}", m_collection.ToJSON("?limit=0").c_str());
+
+   ASSERT_STREQ(R"(#ERROR: 'limit' must be a number)", m_collection.ToJSON("?limit=ten").c_str());
+   ASSERT_STREQ(R"(#ERROR: 'after' must be an id)", m_collection.ToJSON("?after=").c_str());
+
+   // Query parameters only apply to the collection itself
+   ASSERT_STREQ(R"({"id":5,"substuff1":"five"})", m_collection.ToJSON("5?limit=1").c_str());
+
+   m_collection.EnableObjectLocking();
+   ASSERT_STREQ(R"({"5":{"id":5,"substuff1":"five"}})", m_collection.ToJSON("?after=2&limit=1").c_str());
+}
+
 TEST_F(CollectionTests, collection_Rest_POST)
 {
    // Create one resource directly...
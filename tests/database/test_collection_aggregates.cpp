@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/AllOptionalTypes.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionAggregateTests : public JudeTestBase
+{
+public:
+   Collection<AllOptionalTypes> m_collection;
+
+   CollectionAggregateTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.Post(1)->Set_int32_type(10).Set_enum_type(TestEnum::First);
+      m_collection.Post(2)->Set_int32_type(-4).Set_enum_type(TestEnum::Truth);
+      m_collection.Post(3)->Set_int32_type(30).Set_enum_type(TestEnum::First);
+      m_collection.Post(4)->Set_enum_type(TestEnum::Truth);
+   }
+};
+
+TEST_F(CollectionAggregateTests, sum_min_max_avg_of_a_field)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("int32", "int32_type"));
+
+   auto totals = m_collection.GetAggregate("int32");
+   ASSERT_EQ(3, totals.count) << "Objects without the field are left out";
+   ASSERT_EQ(36, totals.sum);
+   ASSERT_EQ(-4, totals.min);
+   ASSERT_EQ(30, totals.max);
+   ASSERT_EQ(12, totals.Average());
+}
+
+TEST_F(CollectionAggregateTests, follows_published_changes)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("int32", "int32_type"));
+
+   m_collection.TransactionLock(3)->Set_int32_type(5);
+   ASSERT_EQ(11, m_collection.GetAggregate("int32").sum);
+   ASSERT_EQ(10, m_collection.GetAggregate("int32").max) << "max is recalculated when the largest value goes";
+
+   m_collection.Post(5)->Set_int32_type(100);
+   ASSERT_REST_OK(m_collection.Delete(2));
+   m_collection.TransactionLock(1)->Clear_int32_type();
+
+   auto totals = m_collection.GetAggregate("int32");
+   ASSERT_EQ(2, totals.count);
+   ASSERT_EQ(105, totals.sum);
+   ASSERT_EQ(5, totals.min);
+   ASSERT_EQ(100, totals.max);
+
+   {
+      auto transaction = m_collection.TransactionLock(5);
+      transaction->Set_int32_type(1000);
+      ASSERT_EQ(100, m_collection.GetAggregate("int32").max) << "Edits in progress are not counted";
+   }
+   ASSERT_EQ(1000, m_collection.GetAggregate("int32").max);
+}
+
+TEST_F(CollectionAggregateTests, count_by_enum)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("byEnum", nullptr, "enum_type"));
+   ASSERT_EQ(2, m_collection.GetAggregate("byEnum", "First").count);
+   ASSERT_EQ(2, m_collection.GetAggregate("byEnum", "Truth").count);
+
+   m_collection.TransactionLock(1)->Set_enum_type(TestEnum::Truth);
+   ASSERT_EQ(1, m_collection.GetAggregate("byEnum", "First").count);
+   ASSERT_EQ(3, m_collection.GetAggregate("byEnum", "Truth").count);
+
+   ASSERT_REST_OK(m_collection.Delete(3));
+   auto groups = m_collection.GetAggregateGroups("byEnum");
+   ASSERT_EQ(1, groups.size()) << "Empty groups are dropped";
+   ASSERT_EQ(3, groups["Truth"].count);
+}
+
+TEST_F(CollectionAggregateTests, grouped_sums)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("int32ByEnum", "int32_type", "enum_type"));
+   ASSERT_EQ(40, m_collection.GetAggregate("int32ByEnum", "First").sum);
+   ASSERT_EQ(-4, m_collection.GetAggregate("int32ByEnum", "Truth").sum);
+
+   m_collection.TransactionLock(3)->Set_enum_type(TestEnum::Truth);
+   ASSERT_EQ(10, m_collection.GetAggregate("int32ByEnum", "First").sum);
+   ASSERT_EQ(26, m_collection.GetAggregate("int32ByEnum", "Truth").sum);
+   ASSERT_EQ(13, m_collection.GetAggregate("int32ByEnum", "Truth").Average());
+}
+
+TEST_F(CollectionAggregateTests, bad_aggregates_are_rejected)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("int32", "int32_type"));
+   ASSERT_FALSE(m_collection.AddAggregate("int32", "int16_type")) << "Names are unique";
+   ASSERT_FALSE(m_collection.AddAggregate("x", "nosuchfield"));
+   ASSERT_FALSE(m_collection.AddAggregate("x", "string_type")) << "Only numbers can be summed";
+   ASSERT_FALSE(m_collection.AddAggregate("x", nullptr, "submsg_type"));
+   ASSERT_EQ(0, m_collection.GetAggregate("nosuchaggregate").count);
+}
+
+TEST_F(CollectionAggregateTests, rest_get)
+{
+   ASSERT_TRUE(m_collection.AddAggregate("int32", "int32_type"));
+   ASSERT_TRUE(m_collection.AddAggregate("byEnum", nullptr, "enum_type"));
+
+   ASSERT_STREQ(R"({"count":3,"sum":36,"min":-4,"max":30,"avg":12})", m_collection.ToJSON("?aggregate=int32").c_str());
+   ASSERT_STREQ(R"({"First":{"count":2},"Truth":{"count":2}})", m_collection.ToJSON("?aggregate=byEnum").c_str());
+   ASSERT_STREQ("#ERROR: Unknown aggregate 'nope'", m_collection.ToJSON("?aggregate=nope").c_str());
+}
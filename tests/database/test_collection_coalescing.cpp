@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/DatabaseTransaction.h"
+
+using namespace jude;
+
+struct Received
+{
+   SubMessage object;
+   bool       isNew;
+   bool       isDeleted;
+   FieldMask  updatedFields;
+
+   const SubMessage* operator->() const { return &object; }
+};
+
+class CollectionCoalescingTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   NotifyQueue m_queue;
+   std::vector<Received> m_received;
+   SubscriptionHandle m_subscription;
+
+   CollectionCoalescingTests()
+      : m_collection("MyCollection", 10)
+      , m_queue("Coalescing", 4)
+   {
+      m_queue.SetCoalescePerObject(true);
+      m_collection.Post(1)->Set_substuff2(1);
+      m_collection.Post(2)->Set_substuff2(2);
+
+      m_subscription = m_collection.OnChange([&] (const Notification<SubMessage>& info) {
+         m_received.push_back({ info->CloneAs<SubMessage>(false), info.IsNew(), info.IsDeleted(), info.updatedFields });
+      }, FieldMask::ForAllChanges(), m_queue);
+   }
+
+   void ProcessAll()
+   {
+      while (m_queue.Process(0)) {}
+   }
+};
+
+TEST_F(CollectionCoalescingTests, many_edits_arrive_as_one_notification)
+{
+   for (int32_t value = 10; value < 110; value++)
+   {
+      m_collection.TransactionLock(1)->Set_substuff2(value);
+   }
+   ASSERT_EQ(1, m_queue.GetStats().depth) << "Only the first change needs a message";
+
+   ProcessAll();
+   ASSERT_EQ(1, m_received.size());
+   ASSERT_EQ(109, m_received[0]->Get_substuff2());
+   ASSERT_EQ(0, m_queue.GetStats().dropped);
+}
+
+TEST_F(CollectionCoalescingTests, changed_fields_are_merged)
+{
+   m_collection.TransactionLock(1)->Set_substuff1("one");
+   m_collection.TransactionLock(1)->Set_substuff2(11);
+   m_collection.TransactionLock(1)->Set_substuff3(true);
+   ProcessAll();
+
+   ASSERT_EQ(1, m_received.size());
+   ASSERT_TRUE(m_received[0]->IsChanged(SubMessage::Index::substuff1));
+   ASSERT_TRUE(m_received[0]->IsChanged(SubMessage::Index::substuff2));
+   ASSERT_TRUE(m_received[0]->IsChanged(SubMessage::Index::substuff3));
+   ASSERT_TRUE(m_received[0].updatedFields.IsChanged(SubMessage::Index::substuff1));
+   ASSERT_FALSE(m_received[0].isNew);
+
+   m_received.clear();
+   m_collection.TransactionLock(1)->Set_substuff2(12);
+   ProcessAll();
+   ASSERT_EQ(1, m_received.size());
+   ASSERT_FALSE(m_received[0]->IsChanged(SubMessage::Index::substuff1)) << "Only changes since the last delivery";
+   ASSERT_TRUE(m_received[0]->IsChanged(SubMessage::Index::substuff2));
+}
+
+TEST_F(CollectionCoalescingTests, objects_keep_their_first_change_order)
+{
+   m_collection.TransactionLock(2)->Set_substuff2(20);
+   m_collection.Post(3)->Set_substuff2(3);
+   m_collection.TransactionLock(1)->Set_substuff2(10);
+   m_collection.TransactionLock(2)->Set_substuff2(21);
+   ProcessAll();
+
+   ASSERT_EQ(3, m_received.size());
+   ASSERT_EQ(2, m_received[0]->Id());
+   ASSERT_EQ(21, m_received[0]->Get_substuff2());
+   ASSERT_EQ(3, m_received[1]->Id());
+   ASSERT_TRUE(m_received[1].isNew);
+   ASSERT_EQ(1, m_received[2]->Id());
+}
+
+TEST_F(CollectionCoalescingTests, new_then_edited_is_still_new_and_delete_wins)
+{
+   m_collection.Post(5)->Set_substuff2(5);
+   m_collection.TransactionLock(5)->Set_substuff1("five");
+   m_collection.TransactionLock(2)->Set_substuff2(22);
+   ASSERT_REST_OK(m_collection.Delete(2));
+   ProcessAll();
+
+   ASSERT_EQ(2, m_received.size());
+   ASSERT_TRUE(m_received[0].isNew);
+   ASSERT_EQ("five", m_received[0]->Get_substuff1());
+   ASSERT_TRUE(m_received[1].isDeleted);
+   ASSERT_EQ(22, m_received[1]->Get_substuff2()) << "A delete carries the last state";
+}
+
+TEST_F(CollectionCoalescingTests, filters_see_the_merged_changes)
+{
+   int substuff1Changes = 0;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>&) {
+      substuff1Changes++;
+   }, { SubMessage::Index::substuff1 }, m_queue);
+
+   m_collection.TransactionLock(1)->Set_substuff1("a");
+   m_collection.TransactionLock(1)->Set_substuff2(100);
+   ProcessAll();
+   ASSERT_EQ(1, substuff1Changes);
+   ASSERT_EQ(1, m_received.size());
+}
+
+TEST_F(CollectionCoalescingTests, immediate_subscribers_still_see_every_change)
+{
+   int immediateCalls = 0;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>&) {
+      immediateCalls++;
+   }, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+
+   DatabaseTransaction transaction;
+   transaction.Edit(m_collection, 1).Set_substuff2(5);
+   transaction.Edit(m_collection, 2).Set_substuff2(6);
+   ASSERT_REST_OK(transaction.Commit());
+   m_collection.TransactionLock(1)->Set_substuff2(7);
+
+   ASSERT_EQ(3, immediateCalls);
+   ProcessAll();
+   ASSERT_EQ(2, m_received.size());
+   ASSERT_EQ(7, m_received[0]->Get_substuff2());
+}
+
+TEST_F(CollectionCoalescingTests, changes_are_delivered_after_the_queue_drops_their_message)
+{
+   NotifyQueue fullQueue("Full", 1);
+   fullQueue.SetCoalescePerObject(true);
+   std::vector<Received> received;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>& info) {
+      received.push_back({ info->CloneAs<SubMessage>(false), info.IsNew(), info.IsDeleted(), info.updatedFields });
+   }, FieldMask::ForAllChanges(), fullQueue);
+
+   ASSERT_TRUE(fullQueue.Send([] {}));
+   m_collection.Post(3)->Set_substuff2(3);
+   ASSERT_EQ(1, fullQueue.GetStats().dropped);
+   while (fullQueue.Process(0)) {}
+   ASSERT_EQ(0, received.size());
+
+   m_collection.TransactionLock(3)->Set_substuff1("three");
+   m_collection.TransactionLock(3)->Set_substuff2(33);
+   while (fullQueue.Process(0)) {}
+
+   ASSERT_EQ(1, received.size());
+   ASSERT_TRUE(received[0].isNew) << "The dropped change is still delivered";
+   ASSERT_EQ("three", received[0]->Get_substuff1());
+   ASSERT_EQ(33, received[0]->Get_substuff2());
+}
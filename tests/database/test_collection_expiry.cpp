@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <thread>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+using namespace std::chrono;
+
+class CollectionExpiryTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   size_t m_deleteNotifications;
+   SubscriptionHandle m_subscription;
+
+   CollectionExpiryTests()
+      : m_collection("MyCollection", 1000)
+      , m_deleteNotifications(0)
+   {
+      m_collection.Post(1)->Set_substuff2(1);
+      m_collection.Post(2)->Set_substuff2(2);
+      m_subscription = m_collection.OnChange([&](const Notification<SubMessage>& info) {
+         if (info.IsDeleted())
+         {
+            m_deleteNotifications++;
+         }
+      }, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   }
+
+   static ExpiryWheel::Clock::time_point In(milliseconds delay)
+   {
+      return ExpiryWheel::Clock::now() + delay;
+   }
+};
+
+TEST_F(CollectionExpiryTests, collection_time_to_live)
+{
+   m_collection.SetTimeToLive(seconds(10));
+   ASSERT_EQ(0, m_collection.ExpireObjects(In(seconds(5))));
+   ASSERT_EQ(2, m_collection.count());
+
+   m_collection.Post(3);
+   ASSERT_EQ(3, m_collection.ExpireObjects(In(seconds(11))));
+   ASSERT_EQ(0, m_collection.count());
+   ASSERT_EQ(3, m_deleteNotifications);
+}
+
+TEST_F(CollectionExpiryTests, changes_restart_the_time_to_live)
+{
+   m_collection.SetTimeToLive(seconds(10));
+   auto start = ExpiryWheel::Clock::now();
+
+   std::this_thread::sleep_for(milliseconds(50));
+   m_collection.TransactionLock(1)->Set_substuff2(11);
+
+   ASSERT_EQ(1, m_collection.ExpireObjects(start + seconds(10) + milliseconds(20)));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+   ASSERT_TRUE(m_collection.ContainsId(1));
+   ASSERT_EQ(1, m_collection.ExpireObjects(In(seconds(11))));
+   ASSERT_FALSE(m_collection.ContainsId(1));
+}
+
+TEST_F(CollectionExpiryTests, per_object_expiry)
+{
+   ASSERT_TRUE(m_collection.ExpireAfter(2, minutes(90)));
+   ASSERT_FALSE(m_collection.ExpireAfter(99, seconds(1)));
+
+   ASSERT_EQ(0, m_collection.ExpireObjects(In(minutes(89))));
+   ASSERT_EQ(1, m_collection.ExpireObjects(In(minutes(91))));
+   ASSERT_TRUE(m_collection.ContainsId(1)) << "No collection TTL so nothing else expires";
+   ASSERT_FALSE(m_collection.ContainsId(2));
+}
+
+TEST_F(CollectionExpiryTests, deleted_objects_are_forgotten)
+{
+   m_collection.SetTimeToLive(seconds(10));
+   ASSERT_REST_OK(m_collection.Delete(1));
+   m_collection.Post(1);
+   ASSERT_EQ(1, m_deleteNotifications);
+
+   ASSERT_TRUE(m_collection.ExpireAfter(1, hours(1)));
+   ASSERT_EQ(1, m_collection.ExpireObjects(In(seconds(11))));
+   ASSERT_TRUE(m_collection.ContainsId(1));
+}
+
+TEST_F(CollectionExpiryTests, validators_can_keep_objects)
+{
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      return !info.IsDeleted() || info->Get_substuff2() != 1;
+   });
+
+   m_collection.SetTimeToLive(seconds(1));
+   ASSERT_EQ(1, m_collection.ExpireObjects(In(seconds(2))));
+   ASSERT_TRUE(m_collection.ContainsId(1));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+}
+
+TEST_F(CollectionExpiryTests, turning_off_time_to_live)
+{
+   m_collection.SetTimeToLive(seconds(1));
+   m_collection.SetTimeToLive(seconds(0));
+   m_collection.Post(3);
+   ASSERT_EQ(0, m_collection.ExpireObjects(In(seconds(2))));
+   ASSERT_EQ(3, m_collection.count());
+}
+
+TEST_F(CollectionExpiryTests, many_objects_expire_in_deadline_order)
+{
+   for (jude_id_t id = 10; id < 500; id++)
+   {
+      m_collection.Post(id);
+      m_collection.ExpireAfter(id, milliseconds(id * 100));
+   }
+
+   // Deadlines were set as the objects were posted so check halfway between two of them
+   ASSERT_EQ(0, m_collection.ExpireObjects(In(milliseconds(950))));
+   ASSERT_EQ(41, m_collection.ExpireObjects(In(milliseconds(5050))));
+   ASSERT_TRUE(m_collection.ContainsId(51));
+   ASSERT_FALSE(m_collection.ContainsId(50));
+   ASSERT_EQ(449, m_collection.ExpireObjects(In(minutes(1))));
+   ASSERT_EQ(2, m_collection.count());
+}
+
+TEST_F(CollectionExpiryTests, background_thread)
+{
+   m_collection.SetTimeToLive(milliseconds(20));
+   m_collection.StartExpiryThread(milliseconds(5));
+
+   for (int wait = 0; wait < 200 && m_collection.count() > 0; wait++)
+   {
+      std::this_thread::sleep_for(milliseconds(10));
+   }
+   m_collection.StopExpiryThread();
+   ASSERT_EQ(0, m_collection.count());
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/AllOptionalTypes.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionOrderingTests : public JudeTestBase
+{
+public:
+   Collection<AllOptionalTypes> m_collection;
+
+   CollectionOrderingTests()
+      : m_collection("MyCollection", 500)
+   {
+      m_collection.Post(1)->Set_int32_type(10).Set_uint64_type(1000).Set_string_type("delta");
+      m_collection.Post(2)->Set_int32_type(-20).Set_uint64_type(2).Set_string_type("alpha");
+      m_collection.Post(3)->Set_int32_type(30).Set_uint64_type(30).Set_string_type("charlie");
+      m_collection.Post(4)->Set_int32_type(10).Set_string_type("bravo");
+      m_collection.Post(5);
+   }
+
+   std::vector<jude_id_t> InOrder(const char* field, bool descending = false)
+   {
+      std::vector<jude_id_t> ids;
+      EXPECT_TRUE(m_collection.ForEachIdInOrder(field, [&] (jude_id_t id) {
+         ids.push_back(id);
+         return true;
+      }, descending));
+      return ids;
+   }
+};
+
+using Ids = std::vector<jude_id_t>;
+
+TEST_F(CollectionOrderingTests, top_k_without_index)
+{
+   ASSERT_EQ(Ids({ 3, 4, 1 }), m_collection.TopIds("int32_type", 3));
+   ASSERT_EQ(Ids({ 2, 1 }), m_collection.TopIds("int32_type", 2, false));
+   ASSERT_EQ(Ids({ 1, 3, 2 }), m_collection.TopIds("uint64_type", 10)) << "Unset fields are left out";
+   ASSERT_EQ(Ids({ 2, 4, 3, 1 }), m_collection.TopIds("string_type", 10, false));
+   ASSERT_EQ(Ids({}), m_collection.TopIds("submsg_type", 10));
+}
+
+TEST_F(CollectionOrderingTests, top_k_with_index_gives_same_result)
+{
+   ASSERT_TRUE(m_collection.AddOrderedIndex("int32_type"));
+   ASSERT_TRUE(m_collection.AddOrderedIndex("string_type"));
+   ASSERT_FALSE(m_collection.AddOrderedIndex("int32_type"));
+   ASSERT_FALSE(m_collection.AddOrderedIndex("submsg_type"));
+
+   ASSERT_EQ(Ids({ 3, 4, 1 }), m_collection.TopIds("int32_type", 3));
+   ASSERT_EQ(Ids({ 2, 1 }), m_collection.TopIds("int32_type", 2, false));
+   ASSERT_EQ(Ids({ 2, 4, 3, 1 }), m_collection.TopIds("string_type", 10, false));
+
+   auto top = m_collection.TopK("int32_type", 1);
+   ASSERT_EQ(1, top.size());
+   ASSERT_EQ(30, top[0].Get_int32_type());
+}
+
+TEST_F(CollectionOrderingTests, index_follows_changes)
+{
+   ASSERT_TRUE(m_collection.AddOrderedIndex("int32_type"));
+
+   m_collection.TransactionLock(2)->Set_int32_type(100);
+   m_collection.Post(6)->Set_int32_type(-1);
+   ASSERT_REST_OK(m_collection.Delete(3));
+   m_collection.TransactionLock(4)->Clear_int32_type();
+
+   ASSERT_EQ(Ids({ 6, 1, 2 }), InOrder("int32_type"));
+   ASSERT_EQ(Ids({ 2, 1, 6 }), InOrder("int32_type", true));
+}
+
+TEST_F(CollectionOrderingTests, sorted_iteration)
+{
+   ASSERT_TRUE(m_collection.AddOrderedIndex("uint64_type"));
+   ASSERT_FALSE(m_collection.ForEachIdInOrder("int32_type", [] (jude_id_t) { return true; })) << "Needs an index";
+
+   std::vector<uint64_t> values;
+   ASSERT_TRUE(m_collection.ForEachInOrder("uint64_type", [&] (const AllOptionalTypes& entry) {
+      values.push_back(entry.Get_uint64_type());
+      return values.size() < 2;
+   }, true));
+   ASSERT_EQ(std::vector<uint64_t>({ 1000, 30 }), values);
+}
+
+TEST_F(CollectionOrderingTests, iteration_spans_many_chunks)
+{
+   ASSERT_TRUE(m_collection.AddOrderedIndex("int32_type"));
+   for (jude_id_t id = 100; id < 400; id++)
+   {
+      m_collection.Post(id)->Set_int32_type(1000 - (int32_t)id);
+   }
+
+   auto ascending = InOrder("int32_type");
+   ASSERT_EQ(304, ascending.size());
+   ASSERT_EQ(2, ascending.front());
+   ASSERT_EQ(100, ascending.back());
+
+   auto descending = InOrder("int32_type", true);
+   ASSERT_EQ(Ids(ascending.rbegin(), ascending.rend()), descending);
+   ASSERT_EQ(m_collection.TopIds("int32_type", 50), Ids(descending.begin(), descending.begin() + 50));
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/AllOptionalTypes.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionQueryTests : public JudeTestBase
+{
+public:
+   Collection<AllOptionalTypes> m_collection;
+
+   CollectionQueryTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.Post(1)->Set_int16_type(-5).Set_uint64_type(10).Set_string_type("alpha").Set_bool_type(true).Set_enum_type(TestEnum::First);
+      m_collection.Post(2)->Set_int16_type(0).Set_uint64_type(20).Set_string_type("beta").Set_bool_type(false).Set_enum_type(TestEnum::Truth);
+      m_collection.Post(3)->Set_int16_type(5).Set_uint64_type(30).Set_string_type("gamma and delta");
+      m_collection.Post(4)->Set_uint64_type(20).Set_string_type("beta");
+   }
+
+   std::vector<jude_id_t> Find(const char* where)
+   {
+      CollectionQuery query(*m_collection.GetType());
+      auto result = query.Where(where);
+      EXPECT_TRUE(result.IsOK()) << where << ": " << result.GetDetails();
+      return m_collection.FindIds(query);
+   }
+};
+
+using Ids = std::vector<jude_id_t>;
+
+TEST_F(CollectionQueryTests, comparison_operators)
+{
+   ASSERT_EQ(Ids({ 2, 4 }), Find("uint64_type=20"));
+   ASSERT_EQ(Ids({ 2, 4 }), Find("uint64_type == 20"));
+   ASSERT_EQ(Ids({ 1, 3 }), Find("uint64_type!=20"));
+   ASSERT_EQ(Ids({ 1 }), Find("uint64_type<20"));
+   ASSERT_EQ(Ids({ 1, 2, 4 }), Find("uint64_type<=20"));
+   ASSERT_EQ(Ids({ 3 }), Find("uint64_type>20"));
+   ASSERT_EQ(Ids({ 2, 3, 4 }), Find("uint64_type>=20"));
+}
+
+TEST_F(CollectionQueryTests, field_types)
+{
+   ASSERT_EQ(Ids({ 1 }), Find("int16_type<0"));
+   ASSERT_EQ(Ids({ 2, 3 }), Find("int16_type>=0")) << "unset fields never match";
+   ASSERT_EQ(Ids({ 2, 4 }), Find("string_type=beta"));
+   ASSERT_EQ(Ids({ 3 }), Find(R"(string_type="gamma and delta")"));
+   ASSERT_EQ(Ids({ 1 }), Find("string_type<beta"));
+   ASSERT_EQ(Ids({ 1 }), Find("bool_type=true"));
+   ASSERT_EQ(Ids({ 2 }), Find("enum_type=Truth"));
+   ASSERT_EQ(Ids({ 1 }), Find("enum_type=1"));
+}
+
+TEST_F(CollectionQueryTests, terms_are_anded)
+{
+   ASSERT_EQ(Ids({ 2 }), Find("uint64_type=20 and bool_type=false"));
+   ASSERT_EQ(Ids({}), Find("uint64_type=20 and int16_type>0"));
+}
+
+TEST_F(CollectionQueryTests, bad_queries_are_rejected)
+{
+   CollectionQuery query(*m_collection.GetType());
+   ASSERT_FALSE(query.Where("nosuchfield=1"));
+   ASSERT_FALSE(query.Where("uint64_type"));
+   ASSERT_FALSE(query.Where("uint64_type=abc"));
+   ASSERT_FALSE(query.Where("uint64_type=<1"));
+   ASSERT_FALSE(query.Where("bool_type=1"));
+   ASSERT_FALSE(query.Where("submsg_type=1"));
+   ASSERT_FALSE(query.Select("uint64_type,nosuchfield"));
+}
+
+TEST_F(CollectionQueryTests, secondary_index_gives_same_result)
+{
+   ASSERT_TRUE(m_collection.AddIndex("string_type"));
+   ASSERT_EQ(Ids({ 2, 4 }), Find("string_type=beta"));
+   ASSERT_EQ(Ids({ 2 }), Find("string_type=beta and bool_type=false"));
+   ASSERT_EQ(Ids({}), Find("string_type=omega"));
+
+   m_collection.TransactionLock(4)->Set_string_type("omega");
+   ASSERT_EQ(Ids({ 2 }), Find("string_type=beta"));
+   ASSERT_EQ(Ids({ 4 }), Find("string_type=omega"));
+}
+
+TEST_F(CollectionQueryTests, rest_get_with_where_and_fields)
+{
+   ASSERT_STREQ(R"({"2":{"id":2,"uint64_type":20},"4":{"id":4,"uint64_type":20}})", m_collection.ToJSON("?where=string_type%3Dbeta&fields=uint64_type").c_str());
+   ASSERT_STREQ(R"({"3":{"id":3,"string_type":"gamma and delta"}})", m_collection.ToJSON("?where=uint64_type>=20&fields=string_type&after=2&limit=1").c_str());
+   ASSERT_STREQ("2", m_collection.ToJSON("?where=uint64_type=20&count").c_str());
+   ASSERT_STREQ("#ERROR: Unknown field 'nosuchfield'", m_collection.ToJSON("?where=nosuchfield=1").c_str());
+   ASSERT_STREQ("#ERROR: Unknown field 'nosuchfield'", m_collection.ToJSON("?fields=nosuchfield").c_str());
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionSnapshotTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+
+   CollectionSnapshotTests()
+      : m_collection("MyCollection", 10)
+   {
+      m_collection.Post(1)->Set_substuff2(1);
+      m_collection.Post(2)->Set_substuff2(2);
+      m_collection.Post(3)->Set_substuff2(3);
+   }
+
+   static int32_t Value(const Object& object)
+   {
+      return CollectionSnapshot::As<SubMessage>(object).Get_substuff2();
+   }
+
+   static std::vector<jude_id_t> IdsOf(const CollectionSnapshot& snapshot)
+   {
+      std::vector<jude_id_t> ids;
+      for (const auto& object : snapshot)
+      {
+         ids.push_back(object.Id());
+      }
+      return ids;
+   }
+};
+
+using Ids = std::vector<jude_id_t>;
+
+TEST_F(CollectionSnapshotTests, snapshot_is_unaffected_by_later_changes)
+{
+   auto snapshot = m_collection.Snapshot();
+   ASSERT_EQ(Ids({ 1, 2, 3 }), IdsOf(snapshot));
+
+   m_collection.TransactionLock(2)->Set_substuff2(22);
+   ASSERT_REST_OK(m_collection.Delete(3));
+   m_collection.Post(4)->Set_substuff2(4);
+
+   ASSERT_EQ(Ids({ 1, 2, 3 }), IdsOf(snapshot));
+   ASSERT_EQ(2, Value(*snapshot.Find(2)));
+
+   auto latest = m_collection.Snapshot();
+   ASSERT_EQ(Ids({ 1, 2, 4 }), IdsOf(latest));
+   ASSERT_EQ(22, Value(*latest.Find(2)));
+   ASSERT_EQ(nullptr, latest.Find(3));
+}
+
+TEST_F(CollectionSnapshotTests, unchanged_objects_are_shared_with_the_collection)
+{
+   auto first = m_collection.Snapshot();
+   ASSERT_EQ(first.Find(1), m_collection.Snapshot().Find(1)) << "Nothing changed so the same snapshot is given";
+   ASSERT_EQ(2, first.Find(1)->RefCount()) << "Shared with the stored object rather than copied";
+
+   m_collection.WriteLock(2)->Set_substuff2(22);
+   ASSERT_EQ(2, Value(*first.Find(2))) << "Edits in place are made to the collection's own copy";
+   ASSERT_EQ(1, first.Find(2)->RefCount());
+
+   auto second = m_collection.Snapshot();
+   ASSERT_EQ(22, Value(*second.Find(2)));
+   ASSERT_EQ(3, second.Find(1)->RefCount());
+}
+
+TEST_F(CollectionSnapshotTests, unused_snapshot_is_released)
+{
+   m_collection.Snapshot();
+   ASSERT_EQ(2, m_collection.Snapshot().Find(1)->RefCount()) << "The previous table is no longer kept";
+}
+
+TEST_F(CollectionSnapshotTests, unchanged_chunks_are_shared_between_snapshots)
+{
+   Collection<SubMessage> collection("Big", 1000);
+   for (jude_id_t id = 1; id <= 200; id++)
+   {
+      collection.Post(id)->Set_substuff2((int32_t)id);
+   }
+
+   auto first = collection.Snapshot();
+   collection.WriteLock(150)->Set_substuff2(-150);
+   ASSERT_REST_OK(collection.Delete(10));
+   collection.Post(500)->Set_substuff2(500);
+
+   auto second = collection.Snapshot();
+   ASSERT_EQ(200, second.size());
+   ASSERT_EQ(first.Find(100), second.Find(100)) << "No changes in this chunk";
+   ASSERT_NE(first.Find(150), second.Find(150));
+   ASSERT_EQ(-150, Value(*second.Find(150)));
+   ASSERT_EQ(nullptr, second.Find(10));
+   ASSERT_EQ(500, Value(*second.Find(500)));
+
+   jude_id_t previous = 0;
+   for (const auto& object : second)
+   {
+      ASSERT_LT(previous, object.Id());
+      previous = object.Id();
+   }
+}
+
+TEST_F(CollectionSnapshotTests, snapshot_does_not_lock_objects)
+{
+   auto snapshot = m_collection.Snapshot();
+   for (const auto& object : snapshot)
+   {
+      // Writers can carry on while we read
+      m_collection.TransactionLock(object.Id())->Set_substuff2(Value(object) * 10);
+   }
+
+   ASSERT_EQ(3, Value(*snapshot.Find(3)));
+   ASSERT_EQ(30, m_collection.ReadLock(3)->Get_substuff2());
+}
+
+TEST_F(CollectionSnapshotTests, snapshot_with_object_locking)
+{
+   m_collection.EnableObjectLocking();
+   auto snapshot = m_collection.Snapshot();
+
+   m_collection.TransactionLock(1)->Set_substuff2(11);
+   ASSERT_EQ(1, Value(*snapshot.Find(1)));
+   ASSERT_EQ(11, Value(*m_collection.Snapshot().Find(1)));
+}
+
+TEST_F(CollectionSnapshotTests, snapshot_paging)
+{
+   std::vector<jude_id_t> visited;
+   m_collection.Snapshot().ForEach([&] (const Object& object) {
+      visited.push_back(object.Id());
+      return true;
+   }, 1);
+   ASSERT_EQ(Ids({ 2, 3 }), visited);
+}
+
+TEST_F(CollectionSnapshotTests, as_vector_gives_copies)
+{
+   auto entries = m_collection.AsVector();
+   ASSERT_EQ(3, entries.size());
+
+   entries[0].Set_substuff2(100);
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+
+   auto evens = m_collection.find_all([] (const SubMessage& entry) { return entry.Get_substuff2() % 2 == 0; });
+   ASSERT_EQ(1, evens.size());
+   ASSERT_EQ(2, evens[0].Id());
+}
+
+TEST_F(CollectionSnapshotTests, writers_carry_on_while_collection_is_read)
+{
+   auto matches = m_collection.find_all([&] (const SubMessage& entry) {
+      m_collection.TransactionLock(entry.Id())->Set_substuff2(entry.Get_substuff2() * 10);
+      return entry.Get_substuff2() > 1;
+   });
+   ASSERT_EQ(2, matches.size());
+   ASSERT_EQ(30, m_collection.ReadLock(3)->Get_substuff2());
+
+   ASSERT_STREQ("1", m_collection.ToJSON("?where=substuff2=30&count").c_str());
+   ASSERT_NE(std::string::npos, m_collection.ToJSON("/").find("\"substuff2\":30"));
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/AllOptionalTypes.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionSpillTests : public JudeTestBase
+{
+public:
+   Collection<AllOptionalTypes> m_collection;
+   std::string m_path;
+
+   CollectionSpillTests()
+      : m_collection("MyCollection", 1000)
+      , m_path(::testing::TempDir() + "jude_spill_test.bin")
+   {
+      EXPECT_TRUE(m_collection.EnableSpillToDisk(m_path, 4));
+   }
+
+   void Post(jude_id_t id)
+   {
+      m_collection.Post(id)->Set_int32_type(id * 10).Set_string_type("object " + std::to_string(id));
+   }
+
+   static bool FileExists(const std::string& path)
+   {
+      return std::ifstream(path).good();
+   }
+};
+
+TEST_F(CollectionSpillTests, only_recent_objects_stay_in_memory)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+
+   auto stats = m_collection.GetSpillStats();
+   ASSERT_EQ(StoragePolicy::Tiered, m_collection.GetStoragePolicy());
+   ASSERT_EQ(4, stats.residentObjects);
+   ASSERT_EQ(6, stats.spilledObjects);
+   ASSERT_EQ(6, stats.evictions);
+   ASSERT_LT(0, stats.bytesSpilled);
+   ASSERT_EQ(stats.bytesSpilled, stats.fileBytes);
+   ASSERT_EQ(10, m_collection.count());
+}
+
+TEST_F(CollectionSpillTests, spilled_objects_are_read_back_transparently)
+{
+   {
+      auto object = m_collection.Post(1);
+      object->Set_int8_type(-8).Set_uint64_type(UINT64_MAX).Set_bool_type(true).Set_enum_type(TestEnum::Truth)
+             .Set_string_type("hello").Set_bytes_type(std::vector<uint8_t>({ 1, 2, 3 }));
+      object->Get_submsg_type().Set_substuff1("child").Set_substuff2(22);
+   }
+   auto version = m_collection.ReadLock(1)->Version();
+
+   for (jude_id_t id = 2; id <= 10; id++)
+   {
+      Post(id);
+   }
+   ASSERT_EQ(0, m_collection.GetSpillStats().misses);
+
+   auto copy = m_collection.ReadLock(1);
+   ASSERT_EQ(1, copy->Id());
+   ASSERT_EQ(-8, copy->Get_int8_type());
+   ASSERT_EQ(UINT64_MAX, copy->Get_uint64_type());
+   ASSERT_TRUE(copy->Get_bool_type());
+   ASSERT_EQ(TestEnum::Truth, copy->Get_enum_type());
+   ASSERT_EQ("hello", copy->Get_string_type());
+   ASSERT_EQ(std::vector<uint8_t>({ 1, 2, 3 }), copy->Get_bytes_type());
+   ASSERT_EQ("child", copy->Get_submsg_type().Get_substuff1());
+   ASSERT_EQ(22, copy->Get_submsg_type().Get_substuff2());
+   ASSERT_FALSE(copy->Has_int16_type());
+   ASSERT_EQ(version, copy->Version()) << "Versions survive a trip to disk";
+
+   auto stats = m_collection.GetSpillStats();
+   ASSERT_EQ(1, stats.misses);
+   ASSERT_EQ(4, stats.residentObjects);
+   ASSERT_GT(1.0, stats.HitRate());
+}
+
+TEST_F(CollectionSpillTests, spilled_objects_can_be_edited_and_deleted)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+
+   m_collection.WriteLock(1)->Set_int32_type(11);
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_int32_type());
+
+   // Push it back out to disk and read the edited copy back
+   for (jude_id_t id = 6; id <= 10; id++)
+   {
+      m_collection.ReadLock(id);
+   }
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_int32_type());
+   ASSERT_EQ("object 1", m_collection.ReadLock(1)->Get_string_type());
+
+   ASSERT_REST_OK(m_collection.Delete(2));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+   ASSERT_EQ(9, m_collection.count());
+}
+
+TEST_F(CollectionSpillTests, scans_do_not_load_objects)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+   auto before = m_collection.GetSpillStats();
+
+   ASSERT_TRUE(m_collection.ContainsId(1));
+   ASSERT_EQ(std::vector<jude_id_t>({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }), m_collection.GetIds());
+   ASSERT_NE(std::string::npos, m_collection.ToJSON("/").find("\"object 10\""));
+   ASSERT_STREQ(R"({"id":3,"int32_type":30,"string_type":"object 3"})", m_collection.ReadLock(3)->ToJSON().c_str());
+
+   auto after = m_collection.GetSpillStats();
+   ASSERT_EQ(before.misses + 1, after.misses) << "Only the read lock should load an object";
+   ASSERT_EQ(4, after.residentObjects);
+}
+
+TEST_F(CollectionSpillTests, objects_in_use_are_not_evicted)
+{
+   Post(1);
+   {
+      auto edit = m_collection.WriteLock(1);
+      for (jude_id_t id = 2; id <= 10; id++)
+      {
+         Post(id);
+      }
+      edit->Set_int32_type(11);
+   }
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_int32_type());
+   ASSERT_EQ(4, m_collection.GetSpillStats().residentObjects);
+}
+
+TEST_F(CollectionSpillTests, unchanged_objects_are_not_written_again)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      m_collection.ReadLock(id);
+   }
+   auto written = m_collection.GetSpillStats().bytesSpilled;
+
+   // Every object now has a copy on disk that is still up to date
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      m_collection.ReadLock(id);
+   }
+   ASSERT_EQ(written, m_collection.GetSpillStats().bytesSpilled);
+}
+
+TEST_F(CollectionSpillTests, spill_file_is_compacted)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+
+   // Rewrite every object many times - the file shouldn't keep growing
+   for (int round = 0; round < 2000; round++)
+   {
+      for (jude_id_t id = 1; id <= 10; id++)
+      {
+         m_collection.WriteLock(id)->Set_int32_type(round);
+      }
+   }
+
+   auto stats = m_collection.GetSpillStats();
+   ASSERT_LT(256 * 1024, stats.bytesSpilled);
+   ASSERT_GT(128 * 1024, stats.fileBytes);
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      ASSERT_EQ(1999, m_collection.ReadLock(id)->Get_int32_type());
+   }
+}
+
+TEST_F(CollectionSpillTests, failed_compaction_keeps_the_spill_file)
+{
+   // Nothing can be written where the compacted file would go
+   auto blocked = m_path + ".compact";
+   std::filesystem::create_directory(blocked);
+
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+   for (int round = 0; round < 1000; round++)
+   {
+      for (jude_id_t id = 1; id <= 10; id++)
+      {
+         m_collection.WriteLock(id)->Set_int32_type(round);
+      }
+   }
+
+   auto stats = m_collection.GetSpillStats();
+   ASSERT_EQ(stats.bytesSpilled, stats.fileBytes) << "Never compacted";
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      ASSERT_EQ(999, m_collection.ReadLock(id)->Get_int32_type());
+   }
+   ASSERT_EQ(0, m_collection.GetSpillStats().readErrors);
+
+   std::filesystem::remove(blocked);
+}
+
+TEST_F(CollectionSpillTests, policy_rules)
+{
+   ASSERT_TRUE(FileExists(m_path));
+   ASSERT_FALSE(m_collection.SetStoragePolicy(StoragePolicy::Tiered));
+   Post(1);
+   ASSERT_FALSE(m_collection.EnableSpillToDisk(m_path, 10));
+   ASSERT_FALSE(m_collection.SetStoragePolicy(StoragePolicy::Ordered));
+
+   Collection<AllOptionalTypes> other("Other", 10);
+   ASSERT_EQ(0, other.GetSpillStats().residentObjects);
+   ASSERT_FALSE(other.EnableSpillToDisk(m_path + ".other", 0));
+   ASSERT_FALSE(other.EnableSpillToDisk(::testing::TempDir() + "no/such/directory/spill.bin", 10));
+}
+
+TEST_F(CollectionSpillTests, spill_file_is_removed_with_the_collection)
+{
+   auto path = m_path + ".removed";
+   {
+      Collection<AllOptionalTypes> other("Other", 10);
+      ASSERT_TRUE(other.EnableSpillToDisk(path, 1));
+      ASSERT_TRUE(FileExists(path));
+   }
+   ASSERT_FALSE(FileExists(path));
+}
+
+TEST_F(CollectionSpillTests, unreadable_spilled_objects_are_reported_not_fatal)
+{
+   for (jude_id_t id = 1; id <= 10; id++)
+   {
+      Post(id);
+   }
+
+   // Lose the spill file's contents from under the store
+   std::ofstream(m_path, std::ios::trunc).close();
+
+   ASSERT_FALSE(m_collection.ReadLock(1)) << "Object 1 was spilled";
+   ASSERT_EQ(1, m_collection.GetSpillStats().readErrors);
+   ASSERT_EQ(10, m_collection.count()) << "The spilled entry is kept";
+
+   size_t visited = 0;
+   for (auto& object : m_collection)
+   {
+      (void)object;
+      visited++;
+   }
+   ASSERT_EQ(4, visited) << "Only resident objects can be visited";
+   ASSERT_TRUE(m_collection.ReadLock(10)) << "Resident objects are unaffected";
+}
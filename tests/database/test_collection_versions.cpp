@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class CollectionVersionTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+
+   CollectionVersionTests()
+      : m_collection("MyCollection", 10)
+   {
+      m_collection.Post(1)->Set_substuff2(1);
+      m_collection.Post(2)->Set_substuff2(2);
+   }
+
+   uint64_t VersionOf(const char* path)
+   {
+      uint64_t version = 0;
+      EXPECT_TRUE(m_collection.RestGetVersion(path, version)) << path;
+      return version;
+   }
+};
+
+TEST_F(CollectionVersionTests, versions_increase_on_every_change)
+{
+   auto collectionVersion = m_collection.Version();
+   auto version1 = m_collection.ReadLock(1)->Version();
+   auto version2 = m_collection.ReadLock(2)->Version();
+   ASSERT_NE(0, version1);
+   ASSERT_LT(version1, version2);
+   ASSERT_EQ(version2, collectionVersion);
+
+   m_collection.TransactionLock(1)->Set_substuff2(11);
+   ASSERT_LT(version2, m_collection.ReadLock(1)->Version());
+   ASSERT_EQ(version2, m_collection.ReadLock(2)->Version()) << "Other objects keep their version";
+   ASSERT_EQ(m_collection.ReadLock(1)->Version(), m_collection.Version());
+
+   ASSERT_REST_OK(m_collection.Delete(2));
+   ASSERT_LT(m_collection.ReadLock(1)->Version(), m_collection.Version());
+}
+
+TEST_F(CollectionVersionTests, unchanged_transaction_keeps_version)
+{
+   auto version = m_collection.ReadLock(1)->Version();
+   {
+      auto transaction = m_collection.TransactionLock(1);
+      transaction->Set_substuff2(1); // same value
+   }
+   ASSERT_EQ(version, m_collection.ReadLock(1)->Version());
+}
+
+TEST_F(CollectionVersionTests, rest_versions)
+{
+   ASSERT_EQ(m_collection.Version(), VersionOf("/"));
+   ASSERT_EQ(m_collection.ReadLock(1)->Version(), VersionOf("/1"));
+   ASSERT_EQ(m_collection.ReadLock(1)->Version(), VersionOf("/1/substuff2"));
+
+   uint64_t version;
+   ASSERT_EQ(jude_rest_Not_Found, m_collection.RestGetVersion("/99", version).GetCode());
+}
+
+TEST_F(CollectionVersionTests, conditional_patch)
+{
+   auto version = std::to_string(VersionOf("/1"));
+
+   ASSERT_REST_OK(m_collection.RestPatchString(("/1?ifVersion=" + version).c_str(), R"({"substuff2":11})"));
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_substuff2());
+
+   auto result = m_collection.RestPatchString(("/1?ifVersion=" + version).c_str(), R"({"substuff2":12})");
+   ASSERT_EQ(jude_rest_Precondition_Failed, result.GetCode()) << "Someone else changed it first";
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_substuff2());
+
+   version = std::to_string(VersionOf("/1"));
+   ASSERT_REST_OK(m_collection.RestPatchString(("/1/substuff2?ifVersion=" + version).c_str(), "12"));
+   ASSERT_EQ(12, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(CollectionVersionTests, database_versions)
+{
+   TestDatabase database;
+   ASSERT_TRUE(database.AddToDB(m_collection));
+
+   uint64_t version;
+   ASSERT_REST_OK(database.RestGetVersion("/MyCollection/1", version));
+   ASSERT_EQ(m_collection.ReadLock(1)->Version(), version);
+   ASSERT_EQ(jude_rest_Method_Not_Allowed, database.RestGetVersion("/", version).GetCode());
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "autogen/alltypes_test/AllOptionalTypes.h"
+#include "jude/database/DatabaseTransaction.h"
+
+using namespace jude;
+
+class DatabaseTransactionTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_orders;
+   Collection<AllOptionalTypes> m_stock;
+   NotifyQueue m_queue;
+   size_t m_orderNotifications;
+   size_t m_stockNotifications;
+   SubscriptionHandle m_orderSubscription;
+   SubscriptionHandle m_stockSubscription;
+
+   DatabaseTransactionTests()
+      : m_orders("Orders", 10)
+      , m_stock("Stock", 10)
+      , m_queue("TransactionQueue")
+      , m_orderNotifications(0)
+      , m_stockNotifications(0)
+   {
+      m_orders.Post(1)->Set_substuff2(1);
+      m_stock.Post(1)->Set_int32_type(100);
+      m_stock.Post(2)->Set_int32_type(200);
+
+      m_orderSubscription = m_orders.OnChange([&](const Notification<SubMessage>&) { m_orderNotifications++; }, FieldMask::ForAllChanges(), m_queue);
+      m_stockSubscription = m_stock.OnChange([&](const Notification<AllOptionalTypes>&) { m_stockNotifications++; }, FieldMask::ForAllChanges(), m_queue);
+   }
+};
+
+TEST_F(DatabaseTransactionTests, changes_to_several_collections_are_applied_together)
+{
+   DatabaseTransaction transaction;
+   transaction.Edit(m_orders, 1).Set_substuff2(2);
+   transaction.Edit(m_stock, 1).Set_int32_type(99);
+   transaction.Post(m_orders, 5).Set_substuff1("new order");
+   ASSERT_TRUE(transaction.Delete(m_stock, 2));
+
+   ASSERT_EQ(1, m_orders.ReadLock(1)->Get_substuff2()) << "Nothing changes until commit";
+   ASSERT_REST_OK(transaction.Commit());
+
+   ASSERT_EQ(2, m_orders.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ("new order", m_orders.ReadLock(5)->Get_substuff1());
+   ASSERT_EQ(99, m_stock.ReadLock(1)->Get_int32_type());
+   ASSERT_FALSE(m_stock.ContainsId(2));
+
+   ASSERT_TRUE(m_queue.Process(0));
+   ASSERT_EQ(2, m_orderNotifications);
+   ASSERT_EQ(2, m_stockNotifications);
+   ASSERT_FALSE(m_queue.Process(0)) << "The whole transaction should arrive as one message";
+}
+
+TEST_F(DatabaseTransactionTests, edits_to_the_same_object_share_one_copy)
+{
+   DatabaseTransaction transaction;
+   transaction.Edit(m_orders, 1).Set_substuff1("a");
+   transaction.Edit(m_orders, 1).Set_substuff2(2);
+   ASSERT_EQ(1, transaction.size());
+   ASSERT_FALSE(transaction.Edit(m_orders, 99));
+
+   ASSERT_REST_OK(transaction.Commit());
+   ASSERT_EQ("a", m_orders.ReadLock(1)->Get_substuff1());
+   ASSERT_EQ(2, m_orders.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(DatabaseTransactionTests, failed_validation_changes_nothing)
+{
+   auto validation = m_stock.ValidateWith([](Notification<AllOptionalTypes>& info) -> ValidationResult {
+      if (info.IsDeleted())
+      {
+         return "stock can't be deleted";
+      }
+      return true;
+   });
+
+   DatabaseTransaction transaction;
+   transaction.Edit(m_orders, 1).Set_substuff2(2);
+   transaction.Delete(m_stock, 2);
+
+   auto result = transaction.Commit();
+   ASSERT_EQ(jude_rest_Bad_Request, result.GetCode());
+   ASSERT_EQ("'Stock/2': stock can't be deleted", result.GetDetails());
+   ASSERT_EQ(1, m_orders.ReadLock(1)->Get_substuff2());
+   ASSERT_TRUE(m_stock.ContainsId(2));
+   ASSERT_FALSE(m_queue.Process(0));
+}
+
+TEST_F(DatabaseTransactionTests, conflicting_changes_are_rejected)
+{
+   DatabaseTransaction transaction;
+   transaction.Edit(m_orders, 1).Set_substuff2(2);
+   transaction.Edit(m_stock, 1).Set_int32_type(99);
+
+   m_stock.TransactionLock(1)->Set_int32_type(50);
+
+   ASSERT_EQ(jude_rest_Conflict, transaction.Commit().GetCode());
+   ASSERT_EQ(1, m_orders.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ(50, m_stock.ReadLock(1)->Get_int32_type());
+
+   DatabaseTransaction post;
+   post.Post(m_orders, 2);
+   m_orders.Post(2);
+   ASSERT_EQ(jude_rest_Conflict, post.Commit().GetCode());
+}
+
+TEST_F(DatabaseTransactionTests, abort_and_destructor)
+{
+   {
+      DatabaseTransaction transaction;
+      transaction.Edit(m_orders, 1).Set_substuff2(2);
+      transaction.Abort();
+   }
+   ASSERT_EQ(1, m_orders.ReadLock(1)->Get_substuff2());
+
+   {
+      DatabaseTransaction transaction;
+      transaction.Edit(m_orders, 1).Set_substuff2(3);
+   }
+   ASSERT_EQ(3, m_orders.ReadLock(1)->Get_substuff2());
+
+   {
+      DatabaseTransaction transaction;
+      transaction.Post(m_orders, 7);
+      transaction.Delete(m_orders, 7);
+      ASSERT_EQ(0, transaction.size());
+   }
+   ASSERT_FALSE(m_orders.ContainsId(7));
+}
+
+TEST_F(DatabaseTransactionTests, works_with_object_locking)
+{
+   m_stock.EnableObjectLocking();
+
+   DatabaseTransaction transaction;
+   transaction.Edit(m_orders, 1).Set_substuff2(2);
+   transaction.Edit(m_stock, 1).Set_int32_type(99);
+   transaction.Post(m_stock, 3).Set_int32_type(300);
+   ASSERT_REST_OK(transaction.Commit());
+
+   ASSERT_EQ(99, m_stock.ReadLock(1)->Get_int32_type());
+   ASSERT_EQ(300, m_stock.ReadLock(3)->Get_int32_type());
+   ASSERT_EQ(2, m_orders.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(DatabaseTransactionTests, capacity_is_checked)
+{
+   DatabaseTransaction transaction;
+   for (jude_id_t id = 10; id < 20; id++)
+   {
+      transaction.Post(m_orders, id);
+   }
+   ASSERT_EQ(jude_rest_Bad_Request, transaction.Commit().GetCode());
+   ASSERT_EQ(1, m_orders.count());
+}
+
+TEST_F(DatabaseTransactionTests, capacity_is_held_while_committing)
+{
+   m_stock.EnableObjectLocking();
+   for (jude_id_t id = 3; id < 10; id++)
+   {
+      m_stock.Post(id)->Set_int32_type(id);
+   }
+
+   // Something else tries to take the last place while the transaction is being validated
+   bool otherPostFailed = false;
+   auto validation = m_stock.ValidateWith([&](Notification<AllOptionalTypes>& info) -> ValidationResult {
+      if (info->Id() == 1)
+      {
+         otherPostFailed = !m_stock.Post(20);
+      }
+      return true;
+   });
+
+   DatabaseTransaction transaction;
+   transaction.Edit(m_stock, 1).Set_int32_type(99); // edits are validated - new objects aren't from code
+   transaction.Post(m_stock, 10).Set_int32_type(10);
+   ASSERT_REST_OK(transaction.Commit());
+
+   ASSERT_TRUE(otherPostFailed) << "The transaction already holds the last place";
+   ASSERT_EQ(10, m_stock.count());
+   ASSERT_FALSE(m_stock.ContainsId(20));
+
+   DatabaseTransaction another;
+   another.Post(m_stock, 11);
+   ASSERT_EQ(jude_rest_Bad_Request, another.Commit().GetCode());
+   ASSERT_EQ(10, m_stock.count()) << "Room held by the first commit has been given back, not leaked";
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/core/cpp/ObjectPool.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class DeltaTransactionTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   std::vector<FieldMask> m_notifiedChanges;
+   SubscriptionHandle m_subscription;
+
+   DeltaTransactionTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.Post(1)->Set_substuff1("one").Set_substuff2(1).Set_substuff3(true);
+      m_subscription = m_collection.OnChange([&](const Notification<SubMessage>& notification) {
+         m_notifiedChanges.push_back(notification.GetChangeMask());
+      }, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   }
+};
+
+TEST_F(DeltaTransactionTests, only_changed_fields_are_applied)
+{
+   {
+      auto transaction = m_collection.DeltaTransactionLock(1);
+      ASSERT_TRUE(transaction.IsDelta());
+      ASSERT_FALSE(transaction->Has_substuff1()) << "Delta starts empty";
+      transaction->Set_substuff2(2);
+   }
+
+   ASSERT_STREQ(R"({"id":1,"substuff1":"one","substuff2":2,"substuff3":true})", m_collection.ToJSON("/1").c_str());
+   ASSERT_EQ(1, m_notifiedChanges.size());
+   ASSERT_TRUE(m_notifiedChanges[0].IsChanged(SubMessage::Index::substuff2));
+   ASSERT_FALSE(m_notifiedChanges[0].IsChanged(SubMessage::Index::substuff1));
+}
+
+TEST_F(DeltaTransactionTests, original_is_readable_during_transaction)
+{
+   auto transaction = m_collection.DeltaTransactionLock(1);
+   ASSERT_EQ("one", transaction.Original().GetFieldAsString(SubMessage::Index::substuff1));
+   transaction->Set_substuff2((int32_t)transaction.Original().GetFieldValue(SubMessage::Index::substuff2) + 10);
+   ASSERT_REST_OK(transaction.Commit());
+
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(DeltaTransactionTests, abort_and_unchanged_values_leave_object_alone)
+{
+   {
+      auto transaction = m_collection.DeltaTransactionLock(1);
+      transaction->Set_substuff1("aborted");
+      transaction.Abort();
+   }
+   {
+      auto transaction = m_collection.DeltaTransactionLock(1);
+      transaction->Set_substuff1("one"); // same as before
+   }
+
+   ASSERT_EQ("one", m_collection.ReadLock(1)->Get_substuff1());
+   ASSERT_TRUE(m_notifiedChanges.empty());
+}
+
+TEST_F(DeltaTransactionTests, missing_object_gives_null_transaction)
+{
+   ASSERT_FALSE(m_collection.DeltaTransactionLock(99));
+}
+
+TEST_F(DeltaTransactionTests, validators_see_whole_object)
+{
+   size_t validations = 0;
+   auto validation = m_collection.ValidateWith([&](Notification<SubMessage>& info) -> ValidationResult {
+      validations++;
+      if (!info->Has_substuff1())
+      {
+         return "substuff1 is required";
+      }
+      if (info->Get_substuff2() < 0)
+      {
+         return "substuff2 must not be negative";
+      }
+      return true;
+   });
+
+   {
+      auto transaction = m_collection.DeltaTransactionLock(1);
+      transaction->Set_substuff2(5);
+      ASSERT_REST_OK(transaction.Commit());
+   }
+
+   {
+      auto transaction = m_collection.DeltaTransactionLock(1);
+      transaction->Set_substuff2(-1);
+      ASSERT_EQ(jude_rest_Bad_Request, transaction.Commit().GetCode());
+   }
+
+   ASSERT_EQ(2, validations);
+   ASSERT_EQ(5, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(DeltaTransactionTests, patch_object_applies_changes_and_clears)
+{
+   auto patch = SubMessage::New();
+   patch.AssignId(1);
+   patch.Set_substuff2(7);
+   ASSERT_REST_OK(m_collection.PatchObject(patch));
+   ASSERT_STREQ(R"({"id":1,"substuff1":"one","substuff2":7,"substuff3":true})", m_collection.ToJSON("/1").c_str());
+
+   auto clearing = m_collection.ReadLock(1)->Clone();
+   clearing.Clear_substuff1();
+   ASSERT_REST_OK(m_collection.PatchObject(clearing));
+   ASSERT_STREQ(R"({"id":1,"substuff2":7,"substuff3":true})", m_collection.ToJSON("/1").c_str());
+
+   patch.AssignId(99);
+   ASSERT_EQ(jude_rest_Not_Found, m_collection.PatchObject(patch).GetCode());
+}
+
+TEST_F(DeltaTransactionTests, delta_patch_does_not_copy_stored_object)
+{
+   auto allocationsFor = [](auto edit) {
+      auto before = ObjectPool::GetStatistics().poolAllocations;
+      edit();
+      return ObjectPool::GetStatistics().poolAllocations - before;
+   };
+
+   auto patch = SubMessage::New();
+   patch.AssignId(1);
+   patch.Set_substuff2(8);
+
+   auto patched = allocationsFor([&] { m_collection.TransactionLock(1)->Patch(patch); });
+
+   patch.Set_substuff2(9);
+   auto deltaPatched = allocationsFor([&] { m_collection.DeltaTransactionLock(1)->Patch(patch); });
+
+   ASSERT_LT(deltaPatched, patched) << "Full transactions copy the stored object";
+   ASSERT_EQ(9, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ(2, m_notifiedChanges.size());
+}
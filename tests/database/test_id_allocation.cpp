@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <thread>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class IdAllocationTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+
+   IdAllocationTests()
+      : m_collection("MyCollection", 2000)
+   {}
+
+   jude_id_t PostNew()
+   {
+      return m_collection.Post()->Id();
+   }
+
+   void PostFromThreads(size_t threadCount, size_t postsPerThread)
+   {
+      std::vector<std::thread> threads;
+      for (size_t thread = 0; thread < threadCount; thread++)
+      {
+         threads.emplace_back([&] {
+            for (size_t post = 0; post < postsPerThread; post++)
+            {
+               m_collection.Post()->Set_substuff2(1);
+            }
+         });
+      }
+      for (auto& thread : threads)
+      {
+         thread.join();
+      }
+   }
+};
+
+TEST_F(IdAllocationTests, generated_ids_never_replace_stored_objects)
+{
+   m_collection.Post(1)->Set_substuff2(1);
+   m_collection.Post(2)->Set_substuff2(2);
+
+   auto id = PostNew(); // the test uuid generator starts at 1
+   ASSERT_EQ(3, id);
+   ASSERT_EQ(3, m_collection.count());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(IdAllocationTests, sequential_ids_carry_on_from_stored_ids)
+{
+   m_collection.Post(41);
+   m_collection.SetIdPolicy(IdPolicy::Sequential);
+   ASSERT_EQ(IdPolicy::Sequential, m_collection.GetIdPolicy());
+
+   ASSERT_EQ(42, PostNew());
+   ASSERT_EQ(43, PostNew());
+
+   m_collection.Post(100);
+   ASSERT_EQ(101, PostNew()) << "Explicit ids are skipped";
+}
+
+TEST_F(IdAllocationTests, sequential_ids_from_many_threads)
+{
+   m_collection.SetIdPolicy(IdPolicy::Sequential);
+   PostFromThreads(8, 200);
+   ASSERT_EQ(1600, m_collection.count());
+
+   auto ids = m_collection.GetIds();
+   ASSERT_EQ(1, ids.front());
+   ASSERT_EQ(1600, ids.back()) << "No gaps or collisions";
+}
+
+TEST_F(IdAllocationTests, block_ids_from_many_threads)
+{
+   m_collection.SetIdPolicy(IdPolicy::Blocks, 16);
+   PostFromThreads(8, 200);
+   ASSERT_EQ(1600, m_collection.count());
+
+   m_collection.Post(5000);
+   ASSERT_GT(PostNew(), 5000) << "A new block starts after explicit ids";
+}
+
+TEST_F(IdAllocationTests, random_ids)
+{
+   m_collection.SetIdPolicy(IdPolicy::Random);
+   PostFromThreads(4, 100);
+   ASSERT_EQ(400, m_collection.count());
+
+   auto first = PostNew();
+   auto second = PostNew();
+   ASSERT_NE(first + 1, second);
+}
+
+TEST_F(IdAllocationTests, collection_size_ids_never_repeat)
+{
+   Options::GenerateIDsBAsedOnCollectionSize = true;
+   ASSERT_EQ(IdPolicy::Uuid, m_collection.GetIdPolicy());
+
+   ASSERT_EQ(1, PostNew());
+   ASSERT_EQ(2, PostNew());
+   m_collection.Delete(1);
+   ASSERT_EQ(3, PostNew()) << "count() + 1 would give 2 again";
+
+   PostFromThreads(8, 100);
+   ASSERT_EQ(802, m_collection.count());
+
+   Options::GenerateIDsBAsedOnCollectionSize = false;
+}
+
+TEST_F(IdAllocationTests, block_ids_for_many_collections_on_one_thread)
+{
+   std::vector<std::unique_ptr<Collection<SubMessage>>> collections;
+   for (int index = 0; index < 10; index++)
+   {
+      collections.push_back(std::make_unique<Collection<SubMessage>>("Other", 100));
+      collections.back()->SetIdPolicy(IdPolicy::Blocks, 16);
+   }
+
+   for (int round = 0; round < 3; round++)
+   {
+      for (auto& collection : collections)
+      {
+         collection->Post()->Set_substuff2(round);
+      }
+   }
+
+   for (auto& collection : collections)
+   {
+      ASSERT_EQ(3, collection->count());
+   }
+}
+
+TEST_F(IdAllocationTests, sequential_ids_skip_stored_ids_after_wrapping)
+{
+   m_collection.Post(1);
+   m_collection.Post(2);
+   m_collection.SetIdPolicy(IdPolicy::Sequential);
+   m_collection.Post(JUDE_INVALID_ID - 1); // the highest id that can be used
+
+   ASSERT_EQ(3, PostNew()) << "Wraps around to the bottom of the range without replacing 1 or 2";
+   ASSERT_EQ(4, m_collection.count());
+   ASSERT_EQ(4, PostNew());
+}
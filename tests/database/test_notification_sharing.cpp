@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class NotificationSharingTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   NotifyQueue m_queue;
+
+   NotificationSharingTests()
+      : m_collection("MyCollection", 10)
+      , m_queue("Sharing")
+   {
+      m_collection.Post(1)->Set_substuff2(1);
+   }
+};
+
+TEST_F(NotificationSharingTests, every_subscriber_sees_the_same_copy)
+{
+   std::vector<const void*> copies;
+   auto record = [&] (const Notification<SubMessage>& info) { copies.push_back(info->RawData()); };
+   auto immediate1 = m_collection.OnChange(record, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   auto immediate2 = m_collection.OnChange(record, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   auto queued = m_collection.OnChange(record, FieldMask::ForAllChanges(), m_queue);
+   auto generic = m_collection.OnChangeToPath("", [&] (const Notification<Object>& info) { copies.push_back(info->RawData()); },
+                                              FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+
+   m_collection.TransactionLock(1)->Set_substuff2(2);
+   while (m_queue.Process(0)) {}
+
+   ASSERT_EQ(4, copies.size());
+   for (auto copy : copies)
+   {
+      ASSERT_EQ(copies[0], copy);
+   }
+}
+
+TEST_F(NotificationSharingTests, shared_copy_is_not_changed_by_later_edits)
+{
+   std::vector<int32_t> values;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>& info) {
+      values.push_back(info->Get_substuff2());
+   }, FieldMask::ForAllChanges(), m_queue);
+
+   m_collection.TransactionLock(1)->Set_substuff2(2);
+   m_collection.TransactionLock(1)->Set_substuff2(3);
+   while (m_queue.Process(0)) {}
+   ASSERT_EQ(std::vector<int32_t>({ 2, 3 }), values);
+}
+
+TEST_F(NotificationSharingTests, changes_without_interested_subscribers_still_update_state)
+{
+   auto versionBefore = m_collection.Version();
+   m_collection.TransactionLock(1)->Set_substuff2(2);
+   ASSERT_LT(versionBefore, m_collection.Version());
+   ASSERT_FALSE(m_collection.ReadLock(1)->IsChanged()) << "Change markers are cleared even with no notification";
+
+   int otherObjectCalls = 0;
+   int substuff1Calls = 0;
+   auto other = m_collection.OnChangeToPath("2/substuff2", [&] (const Notification<Object>&) { otherObjectCalls++; },
+                                            FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   auto narrow = m_collection.OnChange([&] (const Notification<SubMessage>&) { substuff1Calls++; },
+                                       { SubMessage::Index::substuff1 }, NotifyQueue::Immediate);
+
+   m_collection.TransactionLock(1)->Set_substuff2(3);
+   ASSERT_EQ(0, otherObjectCalls);
+   ASSERT_EQ(0, substuff1Calls);
+
+   m_collection.TransactionLock(1)->Set_substuff1("one");
+   m_collection.Post(2)->Set_substuff2(2);
+   ASSERT_EQ(1, substuff1Calls);
+   ASSERT_EQ(1, otherObjectCalls);
+
+   ASSERT_REST_OK(m_collection.Delete(2));
+   ASSERT_EQ(2, otherObjectCalls) << "Deletes are seen by subscribers to the id";
+}
+
+TEST_F(NotificationSharingTests, typed_notification_locks_its_source)
+{
+   int32_t sourceValue = 0;
+   auto subscription = m_collection.OnChange([&] (const Notification<SubMessage>& info) {
+      sourceValue = info.Source().Get_substuff2();
+   }, FieldMask::ForAllChanges(), m_queue);
+
+   m_collection.TransactionLock(1)->Set_substuff2(2);
+   m_collection.TransactionLock(1)->Set_substuff2(3);
+   while (m_queue.Process(0)) {}
+   ASSERT_EQ(3, sourceValue) << "The source is the stored object, not the copy in the notification";
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+#include <thread>
+#include <future>
+
+using namespace std::chrono_literals;
+using namespace jude;
+
+class ObjectLockingTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   size_t m_notificationCount{0};
+
+   ObjectLockingTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.EnableObjectLocking();
+      m_collection.Post(1)->Set_substuff1("one");
+      m_collection.Post(2)->Set_substuff1("two");
+   }
+
+   template<typename Fn>
+   auto InOtherThread(Fn fn)
+   {
+      return std::async(std::launch::async, fn);
+   }
+};
+
+TEST_F(ObjectLockingTests, object_locking_is_optional)
+{
+   Collection<SubMessage> collection("Other");
+   ASSERT_FALSE(collection.HasObjectLocking());
+   ASSERT_TRUE(m_collection.HasObjectLocking());
+}
+
+TEST_F(ObjectLockingTests, edit_of_one_object_does_not_block_edit_of_another)
+{
+   auto edit = m_collection.WriteLock(1);
+
+   auto otherEdit = InOtherThread([&] {
+      m_collection.WriteLock(2)->Set_substuff1("changed");
+      return true;
+   });
+
+   ASSERT_EQ(std::future_status::ready, otherEdit.wait_for(5s));
+   ASSERT_EQ("changed", m_collection.ReadLock(2)->Get_substuff1());
+}
+
+TEST_F(ObjectLockingTests, edit_of_same_object_waits_for_lock)
+{
+   std::future<bool> otherEdit;
+   {
+      auto edit = m_collection.WriteLock(1);
+
+      otherEdit = InOtherThread([&] {
+         m_collection.WriteLock(1)->Set_substuff2(42);
+         return true;
+      });
+
+      ASSERT_EQ(std::future_status::timeout, otherEdit.wait_for(50ms));
+      edit->Set_substuff1("first");
+   }
+
+   ASSERT_EQ(std::future_status::ready, otherEdit.wait_for(5s));
+   ASSERT_EQ("first", m_collection.ReadLock(1)->Get_substuff1());
+   ASSERT_EQ(42, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(ObjectLockingTests, transaction_only_contends_on_its_own_object)
+{
+   std::future<RestfulResult> sameObject;
+   {
+      auto transaction = m_collection.TransactionLock(1);
+
+      auto otherObject = InOtherThread([&] {
+         auto otherTransaction = m_collection.TransactionLock(2);
+         otherTransaction->Set_substuff2(2);
+         return otherTransaction.Commit();
+      });
+      ASSERT_EQ(std::future_status::ready, otherObject.wait_for(5s));
+      ASSERT_REST_OK(otherObject.get());
+
+      sameObject = InOtherThread([&] {
+         auto otherTransaction = m_collection.TransactionLock(1);
+         otherTransaction->Set_substuff2(11);
+         return otherTransaction.Commit();
+      });
+      ASSERT_EQ(std::future_status::timeout, sameObject.wait_for(50ms));
+
+      transaction->Set_substuff2(1);
+   }
+
+   ASSERT_EQ(std::future_status::ready, sameObject.wait_for(5s));
+   ASSERT_REST_OK(sameObject.get());
+   ASSERT_EQ(11, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ(2, m_collection.ReadLock(2)->Get_substuff2());
+}
+
+TEST_F(ObjectLockingTests, post_and_delete_proceed_while_other_object_is_locked)
+{
+   auto edit = m_collection.WriteLock(1);
+
+   auto postAndDelete = InOtherThread([&] {
+      auto newId = m_collection.Post(3).Commit().GetCreatedObjectId();
+      auto deleted = m_collection.Delete(2);
+      return newId == 3 && deleted.IsOK();
+   });
+
+   ASSERT_EQ(std::future_status::ready, postAndDelete.wait_for(5s));
+   ASSERT_TRUE(postAndDelete.get());
+   ASSERT_TRUE(m_collection.ContainsId(3));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+}
+
+TEST_F(ObjectLockingTests, delete_waits_for_outstanding_edit)
+{
+   std::future<RestfulResult> deletion;
+   {
+      auto edit = m_collection.WriteLock(1);
+
+      deletion = InOtherThread([&] { return m_collection.Delete(1); });
+      ASSERT_EQ(std::future_status::timeout, deletion.wait_for(50ms));
+      ASSERT_TRUE(m_collection.ContainsId(1));
+   }
+
+   ASSERT_EQ(std::future_status::ready, deletion.wait_for(5s));
+   ASSERT_REST_OK(deletion.get());
+   ASSERT_FALSE(m_collection.ContainsId(1));
+   ASSERT_FALSE(m_collection.WriteLock(1));
+}
+
+TEST_F(ObjectLockingTests, objects_remain_editable_after_transaction)
+{
+   auto subscription = m_collection.OnChange([&](const Notification<SubMessage>&) { m_notificationCount++; }, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+
+   {
+      auto transaction = m_collection.TransactionLock(1);
+      transaction->Set_substuff2(1);
+   }
+   ASSERT_EQ(1, m_notificationCount);
+
+   // A committed transaction must leave the stored object publishing and unlocking on later edits
+   m_collection.WriteLock(1)->Set_substuff2(2);
+   ASSERT_EQ(2, m_notificationCount);
+
+   auto otherEdit = InOtherThread([&] {
+      m_collection.WriteLock(1)->Set_substuff2(3);
+      return true;
+   });
+   ASSERT_EQ(std::future_status::ready, otherEdit.wait_for(5s));
+   ASSERT_EQ(3, m_notificationCount);
+   ASSERT_EQ(3, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(ObjectLockingTests, rest_api_works_with_object_locking)
+{
+   ASSERT_REST_OK(m_collection.RestPatchString("/1", R"({"substuff2":5})"));
+   ASSERT_STREQ(R"({"1":{"id":1,"substuff1":"one","substuff2":5},"2":{"id":2,"substuff1":"two"}})", m_collection.ToJSON().c_str());
+   ASSERT_STREQ("5", m_collection.ToJSON("/*substuff1=one/substuff2").c_str());
+
+   ASSERT_EQ(jude_rest_No_Content, m_collection.RestDelete("/2").GetCode());
+   ASSERT_STREQ(R"({"1":{"id":1,"substuff1":"one","substuff2":5}})", m_collection.ToJSON().c_str());
+}
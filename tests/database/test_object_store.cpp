@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+#include "jude/database/ObjectStore.h"
+#include <random>
+#include <set>
+
+using namespace jude;
+
+class ObjectStoreTests : public JudeTestBase
+                       , public ::testing::WithParamInterface<StoragePolicy>
+{
+public:
+   std::unique_ptr<ObjectStore> m_store;
+
+   ObjectStoreTests()
+      : m_store(ObjectStore::Create(GetParam()))
+   {}
+
+   void Insert(jude_id_t id)
+   {
+      auto& object = m_store->Insert(id);
+      object = SubMessage::New();
+      object.AssignId(id);
+   }
+
+   std::vector<jude_id_t> OrderedIds()
+   {
+      std::vector<jude_id_t> ids;
+      m_store->ForEach([&] (const Object& object) { ids.push_back(object.Id()); return true; });
+      return ids;
+   }
+};
+
+TEST_P(ObjectStoreTests, empty_store)
+{
+   ASSERT_EQ(GetParam(), m_store->GetPolicy());
+   ASSERT_EQ(0, m_store->Size());
+   ASSERT_EQ(nullptr, m_store->Find(1));
+   ASSERT_FALSE(m_store->Erase(1));
+   ASSERT_EQ(JUDE_INVALID_ID, m_store->NextId(JUDE_INVALID_ID));
+   ASSERT_TRUE(OrderedIds().empty());
+}
+
+TEST_P(ObjectStoreTests, insert_find_and_erase)
+{
+   Insert(5);
+   Insert(3);
+   Insert(9);
+
+   ASSERT_EQ(3, m_store->Size());
+   ASSERT_NE(nullptr, m_store->Find(5));
+   ASSERT_EQ(5, m_store->Find(5)->Id());
+   ASSERT_EQ(nullptr, m_store->Find(4));
+
+   // inserting an existing id returns the stored object
+   ASSERT_EQ(m_store->Find(3), &m_store->Insert(3));
+   ASSERT_EQ(3, m_store->Size());
+
+   ASSERT_TRUE(m_store->Erase(5));
+   ASSERT_FALSE(m_store->Erase(5));
+   ASSERT_EQ(nullptr, m_store->Find(5));
+   ASSERT_EQ(2, m_store->Size());
+}
+
+TEST_P(ObjectStoreTests, ordered_access_follows_id_order)
+{
+   for (jude_id_t id : { 50, 10, 40, 20, 30 })
+   {
+      Insert(id);
+   }
+
+   ASSERT_EQ(std::vector<jude_id_t>({ 10, 20, 30, 40, 50 }), OrderedIds());
+   ASSERT_EQ(10, m_store->NextId(JUDE_INVALID_ID));
+   ASSERT_EQ(30, m_store->NextId(20));
+   ASSERT_EQ(30, m_store->NextId(25));
+   ASSERT_EQ(JUDE_INVALID_ID, m_store->NextId(50));
+
+   m_store->Erase(30);
+   Insert(60);
+   Insert(5);
+   ASSERT_EQ(std::vector<jude_id_t>({ 5, 10, 20, 40, 50, 60 }), OrderedIds());
+   ASSERT_EQ(40, m_store->NextId(20));
+}
+
+TEST_P(ObjectStoreTests, stored_objects_do_not_move_as_store_grows)
+{
+   Insert(1);
+   auto first = m_store->Find(1);
+
+   for (jude_id_t id = 2; id < 1000; id++)
+   {
+      Insert(id);
+   }
+
+   ASSERT_EQ(first, m_store->Find(1));
+}
+
+TEST_P(ObjectStoreTests, random_inserts_and_erases_match_reference)
+{
+   std::mt19937 random(1234);
+   std::set<jude_id_t> reference;
+
+   for (int i = 0; i < 20000; i++)
+   {
+      jude_id_t id = random() % 2000;
+      if (random() % 3 == 0)
+      {
+         ASSERT_EQ(reference.erase(id) > 0, m_store->Erase(id));
+      }
+      else if (reference.insert(id).second)
+      {
+         Insert(id);
+      }
+   }
+
+   ASSERT_EQ(reference.size(), m_store->Size());
+   for (jude_id_t id = 0; id < 2000; id++)
+   {
+      auto object = m_store->Find(id);
+      ASSERT_EQ(reference.count(id) > 0, object != nullptr);
+      if (object)
+      {
+         ASSERT_EQ(id, object->Id());
+      }
+   }
+   ASSERT_EQ(std::vector<jude_id_t>(reference.begin(), reference.end()), OrderedIds());
+}
+
+TEST_P(ObjectStoreTests, stepping_through_ids_while_erasing)
+{
+   for (jude_id_t id = 1; id <= 100; id++)
+   {
+      Insert(id);
+   }
+
+   // Every other id is erased behind the step, as a paged GET with interleaved deletes would
+   size_t steps = 0;
+   for (auto id = m_store->NextId(JUDE_INVALID_ID); id != JUDE_INVALID_ID; id = m_store->NextId(id))
+   {
+      steps++;
+      if (id <= 100 && id % 2 == 0)
+      {
+         ASSERT_TRUE(m_store->Erase(id));
+         Insert(id + 1000);
+      }
+   }
+   ASSERT_EQ(150, steps) << "Ids inserted ahead of the step are visited too";
+   ASSERT_EQ(100, m_store->Size());
+   ASSERT_EQ(1, m_store->NextId(JUDE_INVALID_ID));
+   ASSERT_EQ(1002, m_store->NextId(99));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllPolicies, ObjectStoreTests, ::testing::Values(StoragePolicy::Ordered, StoragePolicy::Hashed));
+
+class HashedCollectionTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+
+   HashedCollectionTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.SetStoragePolicy(StoragePolicy::Hashed);
+   }
+};
+
+TEST_F(HashedCollectionTests, policy_can_only_change_while_empty)
+{
+   ASSERT_EQ(StoragePolicy::Hashed, m_collection.GetStoragePolicy());
+   m_collection.Post(1);
+   ASSERT_FALSE(m_collection.SetStoragePolicy(StoragePolicy::Ordered));
+   ASSERT_EQ(StoragePolicy::Hashed, m_collection.GetStoragePolicy());
+}
+
+TEST_F(HashedCollectionTests, collection_behaves_as_ordered_collection)
+{
+   m_collection.Post(3)->Set_substuff2(3);
+   m_collection.Post(1)->Set_substuff2(1);
+   m_collection.Post(2)->Set_substuff2(2);
+
+   ASSERT_TRUE(m_collection.ContainsId(2));
+   ASSERT_EQ(std::vector<jude_id_t>({ 1, 2, 3 }), m_collection.GetIds());
+   ASSERT_STREQ(R"({"1":{"id":1,"substuff2":1},"2":{"id":2,"substuff2":2},"3":{"id":3,"substuff2":3}})", m_collection.ToJSON().c_str());
+
+   std::vector<jude_id_t> iterated;
+   for (auto& object : m_collection)
+   {
+      iterated.push_back(object.Id());
+   }
+   ASSERT_EQ(std::vector<jude_id_t>({ 1, 2, 3 }), iterated);
+
+   m_collection.WriteLock(2)->Set_substuff2(22);
+   ASSERT_EQ(22, m_collection.ReadLock(2)->Get_substuff2());
+
+   ASSERT_REST_OK(m_collection.Delete(2));
+   ASSERT_FALSE(m_collection.ContainsId(2));
+   ASSERT_EQ(3, m_collection.ReadLockNext(1)->Id());
+}
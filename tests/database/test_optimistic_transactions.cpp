@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <thread>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class OptimisticTransactionTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+   size_t m_notificationCount;
+   SubscriptionHandle m_subscription;
+
+   OptimisticTransactionTests()
+      : m_collection("MyCollection", 50)
+      , m_notificationCount(0)
+   {
+      m_collection.Post(1)->Set_substuff1("one").Set_substuff2(1);
+      m_subscription = m_collection.OnChange([&](const Notification<SubMessage>&) {
+         m_notificationCount++;
+      }, FieldMask::ForAllChanges(), NotifyQueue::Immediate);
+   }
+};
+
+TEST_F(OptimisticTransactionTests, commit_applies_changes)
+{
+   auto transaction = m_collection.OptimisticTransaction(1);
+   ASSERT_TRUE(transaction);
+   transaction->Set_substuff2(2);
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2()) << "Nothing changes before commit";
+
+   ASSERT_REST_OK(transaction.Commit());
+   ASSERT_EQ(2, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ("one", m_collection.ReadLock(1)->Get_substuff1());
+   ASSERT_EQ(1, m_notificationCount);
+}
+
+TEST_F(OptimisticTransactionTests, missing_object_gives_no_transaction)
+{
+   ASSERT_FALSE(m_collection.OptimisticTransaction(99));
+}
+
+TEST_F(OptimisticTransactionTests, other_writers_are_not_blocked)
+{
+   auto transaction = m_collection.OptimisticTransaction(1);
+   transaction->Set_substuff2(2);
+
+   // Another thread can change the object while we hold our transaction...
+   std::thread([&] { m_collection.TransactionLock(1)->Set_substuff1("changed"); }).join();
+   ASSERT_EQ("changed", m_collection.ReadLock(1)->Get_substuff1());
+
+   // ... but then our commit fails rather than overwriting their change
+   ASSERT_EQ(jude_rest_Conflict, transaction.Commit().GetCode());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+   ASSERT_EQ("changed", m_collection.ReadLock(1)->Get_substuff1());
+}
+
+TEST_F(OptimisticTransactionTests, retry_after_conflict)
+{
+   auto first = m_collection.OptimisticTransaction(1);
+   auto second = m_collection.OptimisticTransaction(1);
+   first->Set_substuff2(first->Get_substuff2() + 1);
+   second->Set_substuff2(second->Get_substuff2() + 1);
+
+   ASSERT_REST_OK(first.Commit());
+   ASSERT_EQ(jude_rest_Conflict, second.Commit().GetCode());
+
+   auto retry = m_collection.OptimisticTransaction(1);
+   retry->Set_substuff2(retry->Get_substuff2() + 1);
+   ASSERT_REST_OK(retry.Commit());
+   ASSERT_EQ(3, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(OptimisticTransactionTests, deleted_object_cannot_commit)
+{
+   auto transaction = m_collection.OptimisticTransaction(1);
+   transaction->Set_substuff2(2);
+   ASSERT_REST_OK(m_collection.Delete(1));
+   ASSERT_EQ(jude_rest_Not_Found, transaction.Commit().GetCode());
+   ASSERT_FALSE(m_collection.ContainsId(1));
+}
+
+TEST_F(OptimisticTransactionTests, validators_are_applied)
+{
+   auto validation = m_collection.ValidateWith([](Notification<SubMessage>& info) -> ValidationResult {
+      return info->Get_substuff2() >= 0;
+   });
+
+   auto transaction = m_collection.OptimisticTransaction(1);
+   transaction->Set_substuff2(-1);
+   ASSERT_EQ(jude_rest_Bad_Request, transaction.Commit().GetCode());
+   ASSERT_EQ(1, m_collection.ReadLock(1)->Get_substuff2());
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+#include "jude/database/Resource.h"
+#include <thread>
+#include <future>
+#include <shared_mutex>
+
+using namespace std::chrono_literals;
+using namespace jude;
+
+class ReaderWriterLockTests : public JudeTestBase
+{
+public:
+   std::shared_ptr<jude::Mutex> m_mutex;
+   Collection<SubMessage> m_collection;
+   Resource<SubMessage> m_resource;
+
+   ReaderWriterLockTests()
+      : m_mutex(std::make_shared<jude::Mutex>(jude::Mutex::Mode::ReaderWriter))
+      , m_collection("MyCollection", 50, jude_user_Public, m_mutex)
+      , m_resource("MyResource", jude_user_Public, m_mutex)
+   {
+      m_collection.Post(1)->Set_substuff1("Hello");
+      m_resource->Set_substuff1("World");
+   }
+
+   std::future<std::string> GetInOtherThread(RestApiInterface& api, const char* path)
+   {
+      return std::async(std::launch::async, [&api, path] { return api.ToJSON(path); });
+   }
+};
+
+TEST_F(ReaderWriterLockTests, exclusive_mutex_treats_shared_lock_as_exclusive)
+{
+   jude::Mutex mutex;
+   ASSERT_FALSE(mutex.IsReaderWriter());
+
+   {
+      std::shared_lock<jude::Mutex> lock(mutex);
+      ASSERT_EQ(1, mutex.GetLockDepth());
+   }
+   ASSERT_EQ(0, mutex.GetLockDepth());
+}
+
+TEST_F(ReaderWriterLockTests, readers_do_not_block_each_other)
+{
+   ASSERT_TRUE(m_mutex->IsReaderWriter());
+
+   std::shared_lock<jude::Mutex> lock(*m_mutex);
+   ASSERT_EQ(0, m_mutex->GetLockDepth()) << "readers do not change lock depth";
+
+   auto otherReader = std::async(std::launch::async, [&] {
+      std::shared_lock<jude::Mutex> otherLock(*m_mutex);
+      return true;
+   });
+
+   ASSERT_EQ(std::future_status::ready, otherReader.wait_for(5s));
+}
+
+TEST_F(ReaderWriterLockTests, writer_blocks_readers_until_unlocked)
+{
+   std::unique_lock<jude::Mutex> lock(*m_mutex);
+   ASSERT_EQ(1, m_mutex->GetLockDepth());
+
+   auto reader = std::async(std::launch::async, [&] {
+      std::shared_lock<jude::Mutex> otherLock(*m_mutex);
+      return true;
+   });
+
+   ASSERT_EQ(std::future_status::timeout, reader.wait_for(50ms));
+   lock.unlock();
+   ASSERT_EQ(std::future_status::ready, reader.wait_for(5s));
+}
+
+TEST_F(ReaderWriterLockTests, readers_block_writers_until_unlocked)
+{
+   std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+   auto writer = std::async(std::launch::async, [&] {
+      std::unique_lock<jude::Mutex> otherLock(*m_mutex);
+      return true;
+   });
+
+   ASSERT_EQ(std::future_status::timeout, writer.wait_for(50ms));
+   lock.unlock();
+   ASSERT_EQ(std::future_status::ready, writer.wait_for(5s));
+}
+
+TEST_F(ReaderWriterLockTests, writer_can_lock_recursively_and_read)
+{
+   std::unique_lock<jude::Mutex> lock1(*m_mutex);
+   {
+      std::unique_lock<jude::Mutex> lock2(*m_mutex);
+      std::shared_lock<jude::Mutex> lock3(*m_mutex);
+      ASSERT_EQ(2, m_mutex->GetLockDepth());
+   }
+   ASSERT_EQ(1, m_mutex->GetLockDepth());
+}
+
+TEST_F(ReaderWriterLockTests, reader_can_lock_recursively_while_writer_waits)
+{
+   std::shared_lock<jude::Mutex> lock1(*m_mutex);
+
+   auto writer = std::async(std::launch::async, [&] {
+      std::unique_lock<jude::Mutex> otherLock(*m_mutex);
+      return true;
+   });
+   ASSERT_EQ(std::future_status::timeout, writer.wait_for(50ms));
+
+   {
+      // would deadlock if new readers were simply queued behind the waiting writer
+      std::shared_lock<jude::Mutex> lock2(*m_mutex);
+   }
+
+   lock1.unlock();
+   ASSERT_EQ(std::future_status::ready, writer.wait_for(5s));
+}
+
+TEST_F(ReaderWriterLockTests, reader_cannot_upgrade_to_exclusive)
+{
+   std::shared_lock<jude::Mutex> lock(*m_mutex);
+   ASSERT_FALSE(m_mutex->try_lock());
+   ASSERT_EQ(0, m_mutex->GetLockDepth());
+}
+
+TEST_F(ReaderWriterLockTests, writer_released_by_last_shared_unlock)
+{
+   m_mutex->lock();
+   m_mutex->lock_shared();
+   m_mutex->unlock();
+   m_mutex->unlock_shared();
+
+   auto writer = std::async(std::launch::async, [&] {
+      std::unique_lock<jude::Mutex> otherLock(*m_mutex);
+      return true;
+   });
+   ASSERT_EQ(std::future_status::ready, writer.wait_for(5s));
+}
+
+TEST_F(ReaderWriterLockTests, collection_get_proceeds_while_other_reader_holds_lock)
+{
+   std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+   auto json = GetInOtherThread(m_collection, "/1/substuff1");
+   ASSERT_EQ(std::future_status::ready, json.wait_for(5s));
+   ASSERT_EQ("\"Hello\"", json.get());
+
+   auto all = GetInOtherThread(m_collection, "/");
+   ASSERT_EQ(std::future_status::ready, all.wait_for(5s));
+   ASSERT_EQ(R"({"1":{"id":1,"substuff1":"Hello"}})", all.get());
+
+   auto ids = std::async(std::launch::async, [&] { return m_collection.GetIds(); });
+   ASSERT_EQ(std::future_status::ready, ids.wait_for(5s));
+   ASSERT_EQ(1, ids.get().size());
+
+   auto iterated = std::async(std::launch::async, [&] {
+      const auto& constCollection = m_collection;
+      return constCollection.ReadLock(1)->Get_substuff1();
+   });
+   ASSERT_EQ(std::future_status::ready, iterated.wait_for(5s));
+   ASSERT_EQ("Hello", iterated.get());
+}
+
+TEST_F(ReaderWriterLockTests, collection_get_waits_for_outstanding_edit)
+{
+   std::future<std::string> json;
+   {
+      auto edit = m_collection.WriteLock(1);
+      json = GetInOtherThread(m_collection, "/1/substuff1");
+      ASSERT_EQ(std::future_status::timeout, json.wait_for(50ms));
+      edit->Set_substuff1("Changed");
+   }
+   ASSERT_EQ(std::future_status::ready, json.wait_for(5s));
+   ASSERT_EQ("\"Changed\"", json.get());
+   ASSERT_EQ(0, m_mutex->GetLockDepth());
+}
+
+TEST_F(ReaderWriterLockTests, resource_get_proceeds_while_other_reader_holds_lock)
+{
+   std::shared_lock<jude::Mutex> lock(*m_mutex);
+
+   auto json = GetInOtherThread(m_resource, "/substuff1");
+   ASSERT_EQ(std::future_status::ready, json.wait_for(5s));
+   ASSERT_EQ("\"World\"", json.get());
+}
+
+TEST_F(ReaderWriterLockTests, resource_get_waits_for_outstanding_edit)
+{
+   std::future<std::string> json;
+   {
+      auto edit = m_resource.WriteLock();
+      json = GetInOtherThread(m_resource, "/substuff1");
+      ASSERT_EQ(std::future_status::timeout, json.wait_for(50ms));
+      edit.Set_substuff1("Changed");
+   }
+   ASSERT_EQ(std::future_status::ready, json.wait_for(5s));
+   ASSERT_EQ("\"Changed\"", json.get());
+   ASSERT_EQ(0, m_mutex->GetLockDepth());
+}
+
+TEST_F(ReaderWriterLockTests, resource_edit_copies_release_lock_once)
+{
+   {
+      auto edit = m_resource.WriteLock();
+      auto copy = edit;
+      ASSERT_EQ(1, m_mutex->GetLockDepth());
+      copy.Set_substuff1("Changed");
+   }
+   ASSERT_EQ(0, m_mutex->GetLockDepth());
+
+   {
+      auto edit = m_resource.WriteLock();
+      ASSERT_EQ(1, m_mutex->GetLockDepth());
+   }
+   ASSERT_EQ(0, m_mutex->GetLockDepth());
+   ASSERT_EQ("\"Changed\"", m_resource.ToJSON("/substuff1"));
+}
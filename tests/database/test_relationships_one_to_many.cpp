@@ -231,3 +231,46 @@ TEST_F(Relationship_OneToMany, relationship_does_not_affect_unique_object_ids)
    ASSERT_EQ(3, m_referencingCollection.count());
    ASSERT_EQ(3, m_targetCollection.count());
 }
+
+TEST_F(Relationship_OneToMany, rejects_references_already_used_by_another_object)
+{
+   m_targetCollection.Post(1);
+   m_targetCollection.Post(2);
+   m_referencingCollection.Post(10)->Set_uint64_type(1);
+
+   m_relationships.EnforceReference({ m_referencingCollection, AllOptionalTypes::Index::uint64_type }, m_targetCollection);
+
+   auto result = m_referencingCollection.RestPostString("/", R"({"uint64_type":1})");
+   ASSERT_FALSE(result.IsOK());
+   ASSERT_STREQ(result.GetDetails().c_str(), "'Referencing/<new>/uint64_type' and 'Referencing/10/uint64_type' have duplucate id: 1");
+
+   m_referencingCollection.Post(11)->Set_uint64_type(2);
+
+   ASSERT_EQ(jude_rest_Bad_Request, m_referencingCollection.RestPatchString("/10", R"({"uint64_type":2})").GetCode()) << "2 is used by 11";
+
+   // Once 11 moves on, 2 is free to be used again
+   m_referencingCollection.TransactionLock(11)->Clear_uint64_type();
+   ASSERT_REST_OK(m_referencingCollection.RestPatchString("/10", R"({"uint64_type":2})"));
+}
+
+TEST_F(Relationship_OneToMany, only_current_references_are_cleared)
+{
+   m_targetCollection.Post(1);
+   m_targetCollection.Post(2);
+   m_referencingCollection.Post(10)->Set_uint64_type(1);
+   m_referencingCollection.Post(11)->Set_uint64_type(2);
+
+   m_relationships.EnforceReference_AllowDuplicates({ m_referencingCollection, AllOptionalTypes::Index::uint64_type }, m_targetCollection);
+
+   m_referencingCollection.TransactionLock(10)->Set_uint64_type(2);
+   m_referencingCollection.Post(12)->Set_uint64_type(1);
+
+   ASSERT_REST_OK(m_targetCollection.Delete(1));
+   ASSERT_EQ(2, m_referencingCollection.ReadLock(10)->Get_uint64_type());
+   ASSERT_EQ(2, m_referencingCollection.ReadLock(11)->Get_uint64_type());
+   ASSERT_FALSE(m_referencingCollection.ReadLock(12)->Has_uint64_type());
+
+   ASSERT_REST_OK(m_referencingCollection.Delete(11));
+   ASSERT_REST_OK(m_targetCollection.Delete(2));
+   ASSERT_FALSE(m_referencingCollection.ReadLock(10)->Has_uint64_type());
+}
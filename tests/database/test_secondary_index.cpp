@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <atomic>
+#include <thread>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+class SecondaryIndexTests : public JudeTestBase
+{
+public:
+   Collection<SubMessage> m_collection;
+
+   SecondaryIndexTests()
+      : m_collection("MyCollection", 50)
+   {
+      m_collection.Post(1)->Set_substuff1("one").Set_substuff2(1);
+      m_collection.Post(2)->Set_substuff1("two").Set_substuff2(2);
+      m_collection.Post(3)->Set_substuff1("two").Set_substuff2(3);
+   }
+};
+
+TEST_F(SecondaryIndexTests, index_requires_a_valid_field)
+{
+   ASSERT_FALSE(m_collection.AddIndex("not_a_field"));
+   ASSERT_FALSE(m_collection.HasIndex("substuff1"));
+
+   ASSERT_TRUE(m_collection.AddIndex("substuff1"));
+   ASSERT_TRUE(m_collection.HasIndex("substuff1"));
+   ASSERT_FALSE(m_collection.AddIndex("substuff1")) << "Can't index the same field twice";
+}
+
+TEST_F(SecondaryIndexTests, index_is_built_from_existing_objects)
+{
+   ASSERT_TRUE(m_collection.AddIndex("substuff1"));
+
+   ASSERT_EQ(std::vector<jude_id_t>({ 1 }), m_collection.FindIdsByIndex("substuff1", "one"));
+   ASSERT_EQ(std::vector<jude_id_t>({ 2, 3 }), m_collection.FindIdsByIndex("substuff1", "two"));
+   ASSERT_TRUE(m_collection.FindIdsByIndex("substuff1", "three").empty());
+   ASSERT_TRUE(m_collection.FindIdsByIndex("substuff2", "1").empty()) << "Not indexed";
+}
+
+TEST_F(SecondaryIndexTests, index_follows_posts_edits_transactions_and_deletes)
+{
+   ASSERT_TRUE(m_collection.AddIndex("substuff1"));
+
+   m_collection.Post(4)->Set_substuff1("four");
+   ASSERT_EQ(std::vector<jude_id_t>({ 4 }), m_collection.FindIdsByIndex("substuff1", "four"));
+
+   m_collection.WriteLock(1)->Set_substuff1("uno");
+   ASSERT_TRUE(m_collection.FindIdsByIndex("substuff1", "one").empty());
+   ASSERT_EQ(std::vector<jude_id_t>({ 1 }), m_collection.FindIdsByIndex("substuff1", "uno"));
+
+   m_collection.TransactionLock(2)->Set_substuff1("dos");
+   ASSERT_EQ(std::vector<jude_id_t>({ 3 }), m_collection.FindIdsByIndex("substuff1", "two"));
+   ASSERT_EQ(std::vector<jude_id_t>({ 2 }), m_collection.FindIdsByIndex("substuff1", "dos"));
+
+   {
+      auto transaction = m_collection.TransactionLock(3);
+      transaction->Set_substuff1("aborted");
+      transaction.Abort();
+   }
+   ASSERT_TRUE(m_collection.FindIdsByIndex("substuff1", "aborted").empty());
+
+   m_collection.Delete(3);
+   ASSERT_TRUE(m_collection.FindIdsByIndex("substuff1", "two").empty());
+
+   // Changes to other fields leave the index alone
+   m_collection.WriteLock(4)->Set_substuff2(44);
+   ASSERT_EQ(std::vector<jude_id_t>({ 4 }), m_collection.FindIdsByIndex("substuff1", "four"));
+}
+
+TEST_F(SecondaryIndexTests, path_lookups_give_same_results_with_and_without_index)
+{
+   auto lookups = { "/*substuff1=one/substuff2", "/*substuff1=two/substuff2", "/*substuff1=missing/substuff2", "/*substuff2=3/substuff1" };
+
+   std::vector<std::string> withoutIndex;
+   for (auto path : lookups)
+   {
+      withoutIndex.push_back(m_collection.ToJSON_EmptyOnError(path));
+   }
+
+   ASSERT_TRUE(m_collection.AddIndex("substuff1"));
+   ASSERT_TRUE(m_collection.AddIndex("substuff2"));
+
+   std::vector<std::string> withIndex;
+   for (auto path : lookups)
+   {
+      withIndex.push_back(m_collection.ToJSON_EmptyOnError(path));
+   }
+
+   ASSERT_EQ(withoutIndex, withIndex);
+   ASSERT_EQ("2", withIndex[1]) << "Lowest id wins when several objects match";
+   ASSERT_EQ("", withIndex[2]);
+}
+
+TEST_F(SecondaryIndexTests, path_lookups_use_index_for_patch)
+{
+   ASSERT_TRUE(m_collection.AddIndex("substuff1"));
+
+   ASSERT_REST_OK(m_collection.RestPatchString("/*substuff1=one", R"({"substuff1":"uno"})"));
+   ASSERT_EQ("uno", m_collection.ReadLock(1)->Get_substuff1());
+   ASSERT_EQ(jude_rest_Not_Found, m_collection.RestPatchString("/*substuff1=one", R"({"substuff2":5})").GetCode());
+   ASSERT_REST_OK(m_collection.RestPatchString("/*substuff1=uno", R"({"substuff2":5})"));
+   ASSERT_EQ(5, m_collection.ReadLock(1)->Get_substuff2());
+}
+
+TEST_F(SecondaryIndexTests, indexes_can_be_declared_in_schema)
+{
+   TestDB db;
+   ASSERT_TRUE(db.collection1.HasIndex("substuff1"));
+   ASSERT_FALSE(db.collection2.HasIndex("substuff1"));
+
+   db.collection1.Post(7)->Set_substuff1("seven");
+   ASSERT_STREQ("7", db.ToJSON_EmptyOnError("/collection1/*substuff1=seven/id").c_str());
+}
+
+TEST_F(SecondaryIndexTests, index_built_while_objects_change_is_up_to_date)
+{
+   for (int attempt = 0; attempt < 20; attempt++)
+   {
+      Collection<SubMessage> collection("Changing", 10);
+      for (jude_id_t id = 1; id <= 3; id++)
+      {
+         collection.Post(id)->Set_substuff1("start");
+      }
+
+      std::atomic<bool> done{false};
+      std::thread writer([&] {
+         for (int round = 0; !done; round++)
+         {
+            for (jude_id_t id = 1; id <= 3; id++)
+            {
+               collection.WriteLock(id)->Set_substuff1("round " + std::to_string(round));
+            }
+         }
+      });
+
+      std::atomic<int> added{0};
+      std::thread other([&] { added += collection.AddIndex("substuff1") ? 1 : 0; });
+      added += collection.AddIndex("substuff1") ? 1 : 0;
+      other.join();
+      done = true;
+      writer.join();
+
+      ASSERT_EQ(1, added) << "Only one of two concurrent adds builds the index";
+      for (jude_id_t id = 1; id <= 3; id++)
+      {
+         auto ids = collection.FindIdsByIndex("substuff1", collection.ReadLock(id)->Get_substuff1());
+         ASSERT_NE(ids.end(), std::find(ids.begin(), ids.end(), id)) << "Object " << id << " is indexed by its latest value";
+      }
+   }
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <inttypes.h>
+
+#include "../core/test_base.h"
+#include "autogen/alltypes_test/SubMessage.h"
+#include "jude/database/Collection.h"
+
+using namespace jude;
+
+using SubscriberIds = std::vector<uint32_t>;
+
+class SubscriberIndexTests : public JudeTestBase
+{
+public:
+   SubscriberIndex m_index;
+
+   SubscriberIds Find(jude_id_t id, FieldMask changes)
+   {
+      SubscriberIds found;
+      m_index.FindInterested(id, changes, found);
+      return found;
+   }
+};
+
+TEST_F(SubscriberIndexTests, matches_by_id_and_field)
+{
+   m_index.Add(1, JUDE_AUTO_ID, FieldMask::ForAllChanges());
+   m_index.Add(2, 5, FieldMask::ForAllChanges());
+   m_index.Add(3, JUDE_AUTO_ID, { SubMessage::Index::substuff1 });
+   m_index.Add(4, 6, { SubMessage::Index::substuff2 });
+   ASSERT_EQ(4, m_index.Size());
+
+   ASSERT_EQ(SubscriberIds({ 1, 2 }), Find(5, { SubMessage::Index::substuff2 }));
+   ASSERT_EQ(SubscriberIds({ 1, 2, 3 }), Find(5, { SubMessage::Index::substuff1 }));
+   ASSERT_EQ(SubscriberIds({ 1, 4 }), Find(6, { SubMessage::Index::substuff2 }));
+   ASSERT_EQ(SubscriberIds({ 1 }), Find(6, { SubMessage::Index::substuff3 }));
+   ASSERT_EQ(SubscriberIds({ 1, 3 }), Find(7, { SubMessage::Index::substuff1, SubMessage::Index::substuff3 }));
+}
+
+TEST_F(SubscriberIndexTests, remove_and_reuse_slots)
+{
+   for (uint32_t subscriberId = 1; subscriberId <= 200; subscriberId++)
+   {
+      m_index.Add(subscriberId, JUDE_AUTO_ID, { SubMessage::Index::substuff1 });
+   }
+   for (uint32_t subscriberId = 1; subscriberId <= 199; subscriberId++)
+   {
+      m_index.Remove(subscriberId);
+   }
+   m_index.Remove(999); // unknown ids are ignored
+   ASSERT_EQ(SubscriberIds({ 200 }), Find(1, { SubMessage::Index::substuff1 }));
+
+   m_index.Add(300, JUDE_AUTO_ID, { SubMessage::Index::substuff2 });
+   m_index.Add(301, 1, { SubMessage::Index::substuff2 });
+   ASSERT_EQ(SubscriberIds({ 300, 301 }), Find(1, { SubMessage::Index::substuff2 })) << "In the order they subscribed";
+   ASSERT_EQ(SubscriberIds({ 200 }), Find(1, { SubMessage::Index::substuff1 })) << "The reused slot is only under its new field";
+
+   m_index.Remove(301);
+   ASSERT_EQ(SubscriberIds({ 300 }), Find(1, { SubMessage::Index::substuff2 }));
+
+   m_index.Clear();
+   ASSERT_EQ(0, m_index.Size());
+   ASSERT_TRUE(Find(1, FieldMask::ForAllChanges()).empty());
+}
+
+TEST_F(SubscriberIndexTests, collection_only_calls_interested_subscribers)
+{
+   Collection<SubMessage> collection("MyCollection", 2000);
+   std::vector<int> calls(1000, 0);
+   std::vector<SubscriptionHandle> subscriptions;
+   for (jude_id_t id = 0; id < 1000; id++)
+   {
+      collection.Post(id + 1);
+      subscriptions.push_back(collection.OnChangeToPath(std::to_string(id + 1) + "/substuff2", [&calls, id] (const Notification<Object>&) {
+         calls[id]++;
+      }, FieldMask::ForAllChanges(), NotifyQueue::Immediate));
+      ASSERT_TRUE(subscriptions.back());
+   }
+
+   int substuff1Calls = 0;
+   auto wildcard = collection.OnChange([&] (const Notification<SubMessage>&) { substuff1Calls++; },
+                                       { SubMessage::Index::substuff1 }, NotifyQueue::Immediate);
+
+   collection.TransactionLock(500)->Set_substuff2(1);
+   ASSERT_EQ(1, std::count(calls.begin(), calls.end(), 1));
+   ASSERT_EQ(1, calls[499]);
+   ASSERT_EQ(0, substuff1Calls);
+
+   collection.TransactionLock(500)->Set_substuff1("x");
+   ASSERT_EQ(1, calls[499]);
+   ASSERT_EQ(1, substuff1Calls);
+
+   subscriptions[499].Unsubscribe();
+   collection.TransactionLock(500)->Set_substuff1("y").Set_substuff2(2);
+   ASSERT_EQ(1, calls[499]);
+   ASSERT_EQ(2, substuff1Calls);
+   ASSERT_EQ(1, std::count(calls.begin(), calls.end(), 1));
+}
@@ -141,9 +141,9 @@ static void queue_destroy(jude_queue_t *q)
    Queue::count--;
 }
 
-static void queue_send(jude_queue_t *q, const void *e)
+static bool queue_send(jude_queue_t *q, const void *e)
 {
-   jude_porting_interface_cpp11.queue_send(q, e);
+   return jude_porting_interface_cpp11.queue_send(q, e);
 }
 
 static bool queue_receive(jude_queue_t *q, void *e, uint32_t maxWaitMs)
@@ -155,6 +155,54 @@ static bool queue_receive(jude_queue_t *q, void *e, uint32_t maxWaitMs)
    return jude_porting_interface_cpp11.queue_receive(q, e, maxWaitMs);
 }
 
+static jude_rwlock_t *rwlock_create()
+{
+   if (!Mutex::allowCreation)
+   {
+      return nullptr;
+   }
+   auto result = jude_porting_interface_cpp11.rwlock_create();
+   if (result)
+   {
+      Mutex::count++;
+   }
+   return result;
+}
+
+static void rwlock_destroy(jude_rwlock_t *rw)
+{
+   jude_porting_interface_cpp11.rwlock_destroy(rw);
+   Mutex::count--;
+}
+
+static bool rwlock_lock(jude_rwlock_t *rw, uint32_t timeoutMs)
+{
+   if (Mutex::lockTime > timeoutMs)
+   {
+      return false;
+   }
+   return jude_porting_interface_cpp11.rwlock_lock(rw, timeoutMs);
+}
+
+static void rwlock_unlock(jude_rwlock_t *rw)
+{
+   jude_porting_interface_cpp11.rwlock_unlock(rw);
+}
+
+static bool rwlock_lock_shared(jude_rwlock_t *rw, uint32_t timeoutMs)
+{
+   if (Mutex::lockTime > timeoutMs)
+   {
+      return false;
+   }
+   return jude_porting_interface_cpp11.rwlock_lock_shared(rw, timeoutMs);
+}
+
+static void rwlock_unlock_shared(jude_rwlock_t *rw)
+{
+   jude_porting_interface_cpp11.rwlock_unlock_shared(rw);
+}
+
 jude_os_interface_t jude_porting_test_interface =
 {
    jude_porting_interface_cpp11.fatal,
@@ -175,7 +223,15 @@ jude_os_interface_t jude_porting_test_interface =
    queue_create,
    queue_destroy,
    queue_send,
-   queue_receive
+   queue_receive,
+
+   // reader/writer lock
+   rwlock_create,
+   rwlock_destroy,
+   rwlock_lock,
+   rwlock_unlock,
+   rwlock_lock_shared,
+   rwlock_unlock_shared
 };
 
 // during tests we will use our test interface